@@ -0,0 +1,92 @@
+/*
+stencil throughput across grid memory layouts
+a 7-point Laplacian over the interior of a cube, visiting cells in each layout's own memory order
+*/
+#include "Tensor/GridLayout.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Tensor;
+
+template<typename F>
+double timeBest(int tries, F && f) {
+	double best = 1e+30;
+	for (int t = 0; t < tries; ++t) {
+		auto const start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double> const dt = std::chrono::steady_clock::now() - start;
+		best = std::min(best, dt.count());
+	}
+	return best;
+}
+
+void report(char const * name, int n, double seconds, double check) {
+	double const cells = (double)(n - 2) * (n - 2) * (n - 2);
+	printf("%-12s %5d^3  %8.1f Mcells/s  (checksum %g)\n", name, n, cells / seconds * 1e-6, check);
+}
+
+// Grid, with cursors
+void benchGrid(int n, int tries) {
+	auto const size = int3(n);
+	auto src = Grid<float, 3>(size, [](int k) -> float { return (float)(k % 17); });
+	auto dst = Grid<float, 3>(size);
+	double const seconds = timeBest(tries, [&]() {
+		for (auto const & c : src.interiorRange<1>()) {
+			dst.v[c.offset] = c.neighbor<0, 1>() + c.neighbor<0, -1>()
+				+ c.neighbor<1, 1>() + c.neighbor<1, -1>()
+				+ c.neighbor<2, 1>() + c.neighbor<2, -1>()
+				- 6 * *c;
+		}
+	});
+	double check = 0;
+	for (auto x : dst) check += x;
+	report("Grid", n, seconds, check);
+}
+
+/*
+neighbors through the layout's per-axis offset tables
+along a run of cells the axis 1 and 2 neighbors are a fixed distance away, and axis 0 neighbors are adjacent except at the ends
+*/
+template<typename Layout>
+void benchLayout(char const * name, int n, int tries) {
+	auto const size = int3(n);
+	auto const lex = Grid<float, 3>(size, [](int k) -> float { return (float)(k % 17); });
+	auto src = LayoutGrid<float, 3, Layout>(size);
+	src.assign(lex);
+	auto dst = LayoutGrid<float, 3, Layout>(size);
+	auto const & table = src.layout.table;
+	double const seconds = timeBest(tries, [&]() {
+		float const * const s = src.cells.data();
+		float * const d = dst.cells.data();
+		src.layout.forEachRun(0, src.layout.storageSize, [&](int o, int m, int3 const & i) {
+			if (i.y == 0 || i.z == 0 || i.y == n-1 || i.z == n-1) return;
+			int const yp = table[1][i.y + 1] - table[1][i.y], ym = table[1][i.y - 1] - table[1][i.y];
+			int const zp = table[2][i.z + 1] - table[2][i.z], zm = table[2][i.z - 1] - table[2][i.z];
+			int const k0 = i.x == 0 ? 1 : 0;
+			int const k1 = i.x + m == n ? m - 1 : m;
+			for (int k = k0; k < k1; ++k) {
+				int const x = i.x + k;
+				int const xp = k + 1 < m ? 1 : table[0][x + 1] - table[0][x];
+				int const xm = k > 0 ? -1 : table[0][x - 1] - table[0][x];
+				float const * p = s + o + k;
+				d[o + k] = p[xp] + p[xm] + p[yp] + p[ym] + p[zp] + p[zm] - 6 * *p;
+			}
+		});
+	});
+	double check = 0;
+	dst.forEach([&](int3 const &, float const & x) { check += x; });
+	report(name, n, seconds, check);
+}
+
+int main(int argc, char ** argv) {
+	int const tries = argc > 2 ? atoi(argv[2]) : 3;
+	for (int n : {argc > 1 ? atoi(argv[1]) : 256}) {
+		benchGrid(n, tries);
+		benchLayout<LinearLayout<3>>("linear", n, tries);
+		benchLayout<MortonLayout<3>>("morton", n, tries);
+		benchLayout<TiledLayout<3, 4>>("tiled 4^3", n, tries);
+		benchLayout<TiledLayout<3, 8>>("tiled 8^3", n, tries);
+		benchLayout<TiledLayout<3, 16>>("tiled 16^3", n, tries);
+	}
+}
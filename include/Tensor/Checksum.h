@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+CRC-32 (IEEE 802.3, same as zlib / zip / png)
+slicing-by-8, so it does about a byte per cycle and doesn't hold up a disk write
+
+	uint32_t c = crc32(data, n);
+	c = crc32(moreData, m, c);	// continue a running crc
+*/
+
+namespace Tensor {
+
+namespace Crc32Detail {
+
+constexpr uint32_t polynomial = 0xEDB88320u;
+
+constexpr std::array<std::array<uint32_t, 256>, 8> makeTables() {
+	std::array<std::array<uint32_t, 256>, 8> t = {};
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t c = i;
+		for (int k = 0; k < 8; ++k) {
+			c = (c & 1) ? (c >> 1) ^ polynomial : c >> 1;
+		}
+		t[0][i] = c;
+	}
+	for (uint32_t i = 0; i < 256; ++i) {
+		for (int j = 1; j < 8; ++j) {
+			t[j][i] = (t[j-1][i] >> 8) ^ t[0][t[j-1][i] & 0xff];
+		}
+	}
+	return t;
+}
+
+inline constexpr auto tables = makeTables();
+
+}
+
+inline uint32_t crc32(void const * data, size_t n, uint32_t crc = 0) {
+	auto const & t = Crc32Detail::tables;
+	auto p = (uint8_t const *)data;
+	crc = ~crc;
+	// the 8-byte loop reads little-endian words
+	if constexpr (std::endian::native == std::endian::little) {
+		for (; n >= 8; n -= 8, p += 8) {
+			uint32_t lo, hi;
+			std::memcpy(&lo, p, 4);
+			std::memcpy(&hi, p + 4, 4);
+			lo ^= crc;
+			crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+				^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+		}
+	}
+	for (; n; --n, ++p) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+	}
+	return ~crc;
+}
+
+}
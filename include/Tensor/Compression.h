@@ -0,0 +1,360 @@
+#pragma once
+
+#include "Common/Exception.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+in-tree codecs for the binary Grid format (see GridIO.h), no external libraries
+
+byteShuffle: groups the k'th byte of every scalar together, so the slowly-varying sign/exponent bytes of a float field end up in long similar runs
+lzCompress: small LZ77 with an LZ4-style token stream.  fast, not the best ratio.
+lorenzoEncode: lossy, error-bounded.  each scalar is predicted from the previous (reconstructed) value of the same component,
+	and the residual is quantized to a multiple of 2 * errorBound, so every value comes back within errorBound.
+	values that can't be (NaN, inf, huge residuals) are kept exactly.
+
+all of these work on one chunk at a time, so GridIO can run them on many chunks in parallel.
+*/
+
+namespace Tensor {
+
+enum class GridCodec : uint32_t {
+	None = 0,
+	Shuffle = 1,	// byteShuffle + lzCompress, lossless
+	Lorenzo = 2,	// lorenzoEncode + byteShuffle + lzCompress, lossy with an error bound, floating-point only
+};
+
+// n bytes of 'width'-byte words in src => all the 0th bytes, then all the 1st bytes, etc.  n must be a multiple of width.
+inline void byteShuffle(uint8_t const * src, size_t n, size_t width, uint8_t * dst) {
+	size_t const words = n / width;
+	for (size_t b = 0; b < width; ++b) {
+		uint8_t * d = dst + b * words;
+		for (size_t w = 0; w < words; ++w) {
+			d[w] = src[w * width + b];
+		}
+	}
+}
+
+inline void byteUnshuffle(uint8_t const * src, size_t n, size_t width, uint8_t * dst) {
+	size_t const words = n / width;
+	for (size_t b = 0; b < width; ++b) {
+		uint8_t const * s = src + b * words;
+		for (size_t w = 0; w < words; ++w) {
+			dst[w * width + b] = s[w];
+		}
+	}
+}
+
+/*
+LZ format:
+	sequences of: token, [literal length bytes], literals, [offset (2 bytes LE), [match length bytes]]
+	token high nibble is the literal count, low nibble is match length - 4.  15 in either means 'add the following bytes until one isn't 255'.
+	the last sequence is literals only.
+*/
+namespace LZDetail {
+inline constexpr int minMatch = 4;
+inline constexpr int hashBits = 14;
+inline constexpr size_t maxOffset = 65535;
+inline constexpr size_t lastLiterals = 8;	// the tail is always literals, so matching never reads past the end
+
+inline uint32_t read32(uint8_t const * p) {
+	uint32_t x;
+	std::memcpy(&x, p, 4);
+	return x;
+}
+
+inline uint32_t hash(uint32_t x) {
+	return (x * 2654435761u) >> (32 - hashBits);
+}
+
+inline void writeLength(std::vector<uint8_t> & out, size_t n) {
+	for (; n >= 255; n -= 255) out.push_back(255);
+	out.push_back((uint8_t)n);
+}
+}
+
+inline size_t lzMaxCompressedSize(size_t n) {
+	return n + n / 255 + 16;
+}
+
+inline std::vector<uint8_t> lzCompress(uint8_t const * src, size_t n) {
+	using namespace LZDetail;
+	std::vector<uint8_t> out;
+	out.reserve(lzMaxCompressedSize(n));
+	std::vector<uint32_t> table(1 << hashBits, (uint32_t)-1);
+	size_t anchor = 0;
+	size_t i = 0;
+
+	auto emit = [&](size_t literalEnd, size_t offset, size_t matchLen) {
+		size_t const literals = literalEnd - anchor;
+		uint8_t const lnib = (uint8_t)std::min<size_t>(literals, 15);
+		uint8_t const mnib = matchLen ? (uint8_t)std::min<size_t>(matchLen - minMatch, 15) : 0;
+		out.push_back((uint8_t)(lnib << 4 | mnib));
+		if (literals >= 15) writeLength(out, literals - 15);
+		out.insert(out.end(), src + anchor, src + literalEnd);
+		if (matchLen) {
+			out.push_back((uint8_t)offset);
+			out.push_back((uint8_t)(offset >> 8));
+			if (matchLen - minMatch >= 15) writeLength(out, matchLen - minMatch - 15);
+		}
+	};
+
+	if (n > lastLiterals + minMatch) {
+		size_t const matchLimit = n - lastLiterals;
+		while (i < matchLimit) {
+			uint32_t const x = read32(src + i);
+			uint32_t & slot = table[hash(x)];
+			size_t const candidate = slot;
+			slot = (uint32_t)i;
+			if (candidate != (uint32_t)-1 && i - candidate <= maxOffset && read32(src + candidate) == x) {
+				size_t len = minMatch;
+				while (i + len < matchLimit && src[candidate + len] == src[i + len]) ++len;
+				emit(i, i - candidate, len);
+				i += len;
+				anchor = i;
+			} else {
+				++i;
+			}
+		}
+	}
+	emit(n, 0, 0);
+	return out;
+}
+
+// dst must be exactly the decompressed size.  throws on anything malformed.
+inline void lzDecompress(uint8_t const * src, size_t n, uint8_t * dst, size_t dstSize) {
+	using namespace LZDetail;
+	uint8_t const * ip = src;
+	uint8_t const * const iend = src + n;
+	uint8_t * op = dst;
+	uint8_t * const oend = dst + dstSize;
+	auto readLength = [&](size_t len) -> size_t {
+		for (;;) {
+			if (ip >= iend) throw Common::Exception() << "lz: truncated length";
+			uint8_t const b = *ip++;
+			len += b;
+			if (b != 255) return len;
+		}
+	};
+	for (;;) {
+		if (ip >= iend) throw Common::Exception() << "lz: truncated token";
+		uint8_t const token = *ip++;
+		size_t literals = token >> 4;
+		if (literals == 15) literals = readLength(literals);
+		if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals) throw Common::Exception() << "lz: literals out of bounds";
+		std::memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+		if (ip == iend) break;
+
+		if (iend - ip < 2) throw Common::Exception() << "lz: truncated offset";
+		size_t const offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		size_t len = token & 15;
+		if (len == 15) len = readLength(len);
+		len += minMatch;
+		if (offset == 0 || offset > (size_t)(op - dst)) throw Common::Exception() << "lz: bad offset";
+		if ((size_t)(oend - op) < len) throw Common::Exception() << "lz: match out of bounds";
+		uint8_t const * m = op - offset;
+		if (offset >= len) {
+			std::memcpy(op, m, len);
+			op += len;
+		} else {
+			for (size_t k = 0; k < len; ++k) *op++ = m[k];
+		}
+	}
+	if (op != oend) throw Common::Exception() << "lz: decompressed " << (op - dst) << " bytes but expected " << dstSize;
+}
+
+/*
+lossy encoding of 'count' scalars, interleaved as 'components' per cell
+returns codes (one per scalar) and the exact values of the ones that couldn't be quantized, in order
+*/
+template<typename Scalar>
+struct LorenzoCodes {
+	static constexpr int32_t exact = std::numeric_limits<int32_t>::min();	// code meaning 'the next value in exacts'
+	std::vector<int32_t> codes;
+	std::vector<Scalar> exacts;
+};
+
+template<typename Scalar>
+LorenzoCodes<Scalar> lorenzoEncode(Scalar const * src, size_t count, int components, double errorBound) {
+	static_assert(std::is_floating_point_v<Scalar>, "the lossy codec is for floating-point fields");
+	if (!(errorBound > 0)) throw Common::Exception() << "lossy error bound must be positive, got " << errorBound;
+	double const step = 2 * errorBound;
+	double const maxCode = (double)std::numeric_limits<int32_t>::max();
+	LorenzoCodes<Scalar> r;
+	r.codes.resize(count);
+	std::vector<Scalar> prev(components);	// reconstructed, so the decoder predicts the same thing
+	for (size_t k = 0; k < count; ++k) {
+		Scalar & p = prev[k % components];
+		Scalar const x = src[k];
+		double const q = std::nearbyint(((double)x - (double)p) / step);
+		bool ok = std::isfinite(x) && std::abs(q) < maxCode;
+		Scalar recon = {};
+		if (ok) {
+			recon = (Scalar)((double)p + q * step);
+			ok = std::abs((double)recon - (double)x) <= errorBound;
+		}
+		if (ok) {
+			r.codes[k] = (int32_t)q;
+			p = recon;
+		} else {
+			r.codes[k] = LorenzoCodes<Scalar>::exact;
+			r.exacts.push_back(x);
+			p = std::isfinite(x) ? x : Scalar();
+		}
+	}
+	return r;
+}
+
+template<typename Scalar>
+void lorenzoDecode(LorenzoCodes<Scalar> const & r, Scalar * dst, size_t count, int components, double errorBound) {
+	double const step = 2 * errorBound;
+	if (r.codes.size() != count) throw Common::Exception() << "lorenzo: have " << r.codes.size() << " codes but expected " << count;
+	std::vector<Scalar> prev(components);
+	size_t e = 0;
+	for (size_t k = 0; k < count; ++k) {
+		Scalar & p = prev[k % components];
+		int32_t const q = r.codes[k];
+		if (q == LorenzoCodes<Scalar>::exact) {
+			if (e >= r.exacts.size()) throw Common::Exception() << "lorenzo: ran out of exact values";
+			Scalar const x = r.exacts[e++];
+			dst[k] = x;
+			p = std::isfinite(x) ? x : Scalar();
+		} else {
+			p = (Scalar)((double)p + (double)q * step);
+			dst[k] = p;
+		}
+	}
+}
+
+/*
+chunk-level glue used by GridIO
+compressed chunk layout:
+	uint8 mode: 0 = stored as-is (when compressing didn't help), 1 = compressed
+	for Shuffle: lz(shuffle(raw bytes))
+	for Lorenzo: uint32 exact count, then lz(exacts raw ++ shuffle(codes))
+*/
+struct ChunkCodec {
+	GridCodec codec = GridCodec::None;
+	double errorBound = {};
+	uint32_t scalarBytes = {};
+	int components = {};	// scalars per cell
+	bool isFloat = {};
+
+	std::vector<uint8_t> compress(uint8_t const * raw, size_t n) const {
+		std::vector<uint8_t> body;
+		if (codec == GridCodec::Shuffle) {
+			std::vector<uint8_t> shuffled(n);
+			byteShuffle(raw, n, scalarBytes, shuffled.data());
+			body = lzCompress(shuffled.data(), n);
+		} else if (codec == GridCodec::Lorenzo) {
+			if (scalarBytes == 4) {
+				body = compressLorenzo<float>(raw, n);
+			} else if (scalarBytes == 8) {
+				body = compressLorenzo<double>(raw, n);
+			} else {
+				throw Common::Exception() << "the lossy codec is for float and double fields";
+			}
+		}
+		// store it as-is if compressing didn't help.  not for Lorenzo though, since its output is in native order and raw chunks aren't.
+		std::vector<uint8_t> out;
+		if (codec != GridCodec::Lorenzo && body.size() >= n) {
+			out.reserve(n + 1);
+			out.push_back(0);
+			out.insert(out.end(), raw, raw + n);
+		} else {
+			out.reserve(body.size() + 1);
+			out.push_back(1);
+			out.insert(out.end(), body.begin(), body.end());
+		}
+		return out;
+	}
+
+	// 'swapped' means the chunk came from the other endianness.  raw comes out in the writer's byte order except for Lorenzo, which comes out native.
+	void decompress(uint8_t const * src, size_t n, uint8_t * raw, size_t rawSize, bool swapped) const {
+		if (n < 1) throw Common::Exception() << "empty compressed chunk";
+		if (src[0] == 0) {
+			if (n - 1 != rawSize) throw Common::Exception() << "stored chunk is " << (n - 1) << " bytes but expected " << rawSize;
+			std::memcpy(raw, src + 1, rawSize);
+			return;
+		}
+		if (src[0] != 1) throw Common::Exception() << "bad chunk mode " << (int)src[0];
+		if (codec == GridCodec::Shuffle) {
+			std::vector<uint8_t> shuffled(rawSize);
+			lzDecompress(src + 1, n - 1, shuffled.data(), rawSize);
+			byteUnshuffle(shuffled.data(), rawSize, scalarBytes, raw);
+		} else if (codec == GridCodec::Lorenzo) {
+			if (scalarBytes == 4) {
+				decompressLorenzo<float>(src + 1, n - 1, raw, rawSize, swapped);
+			} else if (scalarBytes == 8) {
+				decompressLorenzo<double>(src + 1, n - 1, raw, rawSize, swapped);
+			} else {
+				throw Common::Exception() << "bad scalar size " << scalarBytes << " for the lossy codec";
+			}
+		} else {
+			throw Common::Exception() << "chunk is compressed but the file has no codec";
+		}
+	}
+
+protected:
+	template<typename Scalar>
+	std::vector<uint8_t> compressLorenzo(uint8_t const * raw, size_t n) const {
+		size_t const count = n / sizeof(Scalar);
+		std::vector<Scalar> values(count);
+		std::memcpy(values.data(), raw, n);
+		auto const r = lorenzoEncode(values.data(), count, components, errorBound);
+		size_t const exactBytes = r.exacts.size() * sizeof(Scalar);
+		size_t const codeBytes = count * sizeof(int32_t);
+		std::vector<uint8_t> plain(exactBytes + codeBytes);
+		std::memcpy(plain.data(), r.exacts.data(), exactBytes);
+		byteShuffle((uint8_t const *)r.codes.data(), codeBytes, sizeof(int32_t), plain.data() + exactBytes);
+		auto lz = lzCompress(plain.data(), plain.size());
+		std::vector<uint8_t> out(4);
+		uint32_t const numExacts = (uint32_t)r.exacts.size();
+		std::memcpy(out.data(), &numExacts, 4);
+		out.insert(out.end(), lz.begin(), lz.end());
+		return out;
+	}
+
+	template<typename Scalar>
+	void decompressLorenzo(uint8_t const * src, size_t n, uint8_t * raw, size_t rawSize, bool swapped) const {
+		auto swap = [&](auto x) {
+			uint8_t b[sizeof(x)];
+			std::memcpy(b, &x, sizeof(x));
+			std::reverse(b, b + sizeof(x));
+			std::memcpy(&x, b, sizeof(x));
+			return x;
+		};
+		if (n < 4) throw Common::Exception() << "truncated lossy chunk";
+		uint32_t numExacts;
+		std::memcpy(&numExacts, src, 4);
+		if (swapped) numExacts = swap(numExacts);
+		size_t const count = rawSize / sizeof(Scalar);
+		if (numExacts > count) throw Common::Exception() << "bad lossy chunk";
+		size_t const exactBytes = numExacts * sizeof(Scalar);
+		size_t const codeBytes = count * sizeof(int32_t);
+		std::vector<uint8_t> plain(exactBytes + codeBytes);
+		lzDecompress(src + 4, n - 4, plain.data(), plain.size());
+		LorenzoCodes<Scalar> r;
+		r.exacts.resize(numExacts);
+		std::memcpy(r.exacts.data(), plain.data(), exactBytes);
+		r.codes.resize(count);
+		byteUnshuffle(plain.data() + exactBytes, codeBytes, sizeof(int32_t), (uint8_t*)r.codes.data());
+		if (swapped) {
+			for (auto & x : r.exacts) x = swap(x);
+			for (auto & q : r.codes) q = swap(q);
+		}
+		std::vector<Scalar> values(count);
+		lorenzoDecode(r, values.data(), count, components, errorBound);
+		std::memcpy(raw, values.data(), rawSize);
+	}
+};
+
+}
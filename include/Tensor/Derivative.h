@@ -1,4 +1,7 @@
+#pragma once
+
 #include "Tensor/Vector.h"
+#include "Tensor/Grid.h"
 #include "Common/Macros.h"
 #include <functional>
 
@@ -121,7 +124,7 @@ struct PartialDerivativeGridImpl<order, Real, dim, InputType> {
 					getOffset<InputType, dim>(f, gridIndex, gradIndex, i)(srcIndex)
 					- getOffset<InputType, dim>(f, gridIndex, gradIndex, -i)(srcIndex)
 				) * Coeffs::coeffs[i-1]) + ... + (0)) / dx(gradIndex);
-			}(Common::make_integer_range<int, 1, Coeffs::coeffs.size()>{});
+			}(Common::make_integer_range<int, 1, Coeffs::coeffs.size()+1>{});
 		});
 	}
 };
@@ -141,7 +144,7 @@ struct PartialDerivativeGridImpl<order, Real, dim, Real> {
 					getOffset<InputType, dim>(f, gridIndex, gradIndex, i)
 					- getOffset<InputType, dim>(f, gridIndex, gradIndex, -i)
 				) * Coeffs::coeffs[i-1]) + ... + (0)) / dx(gradIndex);
-			}(Common::make_integer_range<int, 1, Coeffs::coeffs.size()>{});
+			}(Common::make_integer_range<int, 1, Coeffs::coeffs.size()+1>{});
 		});
 	}
 };
@@ -155,4 +158,47 @@ auto partialDerivativeGrid(
 	return PartialDerivativeGridImpl<order, Real, dim, InputType>::exec(index, dx, f);
 }
 
+/*
+same thing but reading from a GridCursor (see Grid.h)
+neighbors are compile-time offsets from the cursor's flat offset, so no index math per sample
+use a Grid::interiorRange<border>() with border >= coeffs.size() and it won't need any bounds checks either
+*/
+template<int order, int k, typename Cursor, typename Real>
+auto partialDerivativeGridAxis(
+	Cursor const & c,
+	Real dxk
+) {
+	using Coeffs = PartialDerivativeCoeffs<Real, order>;
+	using Type = std::remove_const_t<typename Cursor::Type>;
+	return [&]<int ... i>(std::integer_sequence<int, i...>) -> Type {
+		return (((
+			c.template neighbor<k, i>()
+			- c.template neighbor<k, -i>()
+		) * Coeffs::coeffs[i-1]) + ...) / dxk;
+	}(Common::make_integer_range<int, 1, Coeffs::coeffs.size()+1>{});
+}
+
+template<int order, typename Cursor, typename Real>
+auto partialDerivativeGrid(
+	Cursor const & c,
+	vec<Real, Cursor::rank> const & dx
+) {
+	using Type = std::remove_const_t<typename Cursor::Type>;
+	constexpr int dim = Cursor::rank;
+	return [&]<int ... k>(std::integer_sequence<int, k...>) -> vec<Type, dim> {
+		return vec<Type, dim>{partialDerivativeGridAxis<order, k>(c, dx[k])...};
+	}(std::make_integer_sequence<int, dim>{});
+}
+
+// sample a Grid or GridView directly at 'index'
+template<int order, typename G, typename Real>
+requires requires (G const & g) { g.v; g.step; g.size; }
+auto partialDerivativeGrid(
+	intN<G::rank> const & index,
+	vec<Real, G::rank> const & dx,
+	G const & g
+) {
+	return partialDerivativeGrid<order>(GridCursor<G const>{&g, index, index.dot(g.step)}, dx);
+}
+
 }
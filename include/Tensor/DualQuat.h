@@ -0,0 +1,320 @@
+#pragma once
+
+/*
+dual quaternions, for rigid transforms
+
+q = r + e d, with e^2 = 0.  r is the rotation, d = t r / 2 for translation t, so a unit dual quat is 8 numbers for what a mat4 uses 16 for.
+x -> r x r* + t, so rotation first, then translation, same as translate(t) * rotate(...).
+compose is a * b = (ar br) + e (ar bd + ad br), b applied first, like matrices.  that's 3 quat products, 48 multiplies, against 64 for a mat4 product.
+
+like quat, these are only rigid transforms when unit: |r| = 1 and r . d = 0.  normalize() puts them back there.
+*/
+
+#include "Tensor/Quat.h"
+#include "Tensor/Matrix.h"
+#include "Common/Exception.h"
+#include <cmath>
+#include <span>
+
+namespace Tensor {
+
+template<typename T>
+struct dualquat {
+	using Scalar = T;
+	using quat = ::Tensor::quat<T>;
+	using vec3 = ::Tensor::vec3<T>;
+	using mat3x3 = ::Tensor::mat3x3<T>;
+	using mat4x4 = ::Tensor::mat<T,4,4>;
+
+	quat real;
+	quat dual;
+
+	// zero, same as quat's default.  identity() for the do-nothing transform.
+	constexpr dualquat() {}
+	constexpr dualquat(quat const & real_, quat const & dual_ = {}) : real(real_), dual(dual_) {}
+
+	static dualquat identity() { return {quat(0,0,0,1)}; }
+
+	// rotate by unit quat r, then translate by t
+	static dualquat fromRotationTranslation(quat const & r, vec3 const & t) {
+		return {r, (quat)(quat(t) * r * (T).5)};
+	}
+
+	static dualquat fromTranslation(vec3 const & t) {
+		return {quat(0,0,0,1), quat(t.x / 2, t.y / 2, t.z / 2, 0)};
+	}
+
+	// from a rotation and translation matrix, like translate(t) * rotate(angle, axis).  anything else in m is ignored.
+	static dualquat fromMatrix(mat4x4 const & m) {
+		mat3x3 const r = {
+			{m(0,0), m(0,1), m(0,2)},
+			{m(1,0), m(1,1), m(1,2)},
+			{m(2,0), m(2,1), m(2,2)},
+		};
+		return fromRotationTranslation(normalize(quat::fromMatrix(r)), vec3(m(0,3), m(1,3), m(2,3)));
+	}
+
+	quat const & rotation() const { return real; }
+
+	// 2 d r*, without the real part, which is zero for unit dual quats
+	vec3 translation() const {
+		return {
+			2 * (real.w * dual.x - dual.w * real.x + real.y * dual.z - real.z * dual.y),
+			2 * (real.w * dual.y - dual.w * real.y + real.z * dual.x - real.x * dual.z),
+			2 * (real.w * dual.z - dual.w * real.z + real.x * dual.y - real.y * dual.x),
+		};
+	}
+
+	mat4x4 toMatrix() const {
+		auto const r = real.toMatrix();
+		auto const t = translation();
+		return mat4x4{
+			{r(0,0), r(0,1), r(0,2), t.x},
+			{r(1,0), r(1,1), r(1,2), t.y},
+			{r(2,0), r(2,1), r(2,2), t.z},
+			{0, 0, 0, 1},
+		};
+	}
+
+	vec3 transformPoint(vec3 const & p) const {
+		return real.rotateUnit(p) + translation();
+	}
+
+	// directions only rotate
+	vec3 transformVector(vec3 const & v) const {
+		return real.rotateUnit(v);
+	}
+
+	static dualquat mul(dualquat const & a, dualquat const & b) {
+		return {a.real * b.real, (quat)(a.real * b.dual + a.dual * b.real)};
+	}
+
+	dualquat & operator*=(dualquat const & o) {
+		*this = mul(*this, o);
+		return *this;
+	}
+
+	// quaternion conjugate of both parts.  same as the inverse for unit dual quats.
+	dualquat conjugate() const {
+		return {real.conjugate(), dual.conjugate()};
+	}
+
+	// for any invertible dual quat: (r + e d)^-1 = r^-1 - e r^-1 d r^-1
+	dualquat inverse() const {
+		quat const ri = real.inverse();
+		return {ri, (quat)-(ri * dual * ri)};
+	}
+
+	dualquat operator-() const { return {-real, -dual}; }
+
+	dualquat operator+(dualquat const & o) const { return {(quat)(real + o.real), (quat)(dual + o.dual)}; }
+	dualquat operator-(dualquat const & o) const { return {(quat)(real - o.real), (quat)(dual - o.dual)}; }
+	dualquat operator*(T const & s) const { return {(quat)(real * s), (quat)(dual * s)}; }
+
+	bool operator==(dualquat const & o) const { return real == o.real && dual == o.dual; }
+	bool operator!=(dualquat const & o) const { return !operator==(o); }
+};
+
+template<typename T>
+dualquat<T> operator*(dualquat<T> const & a, dualquat<T> const & b) {
+	return dualquat<T>::mul(a, b);
+}
+
+template<typename T>
+dualquat<T> operator*(T const & s, dualquat<T> const & q) {
+	return q * s;
+}
+
+// back to |real| = 1 and real . dual = 0
+template<typename T>
+dualquat<T> normalize(dualquat<T> const & q) {
+	T const len = q.real.length();
+	if (len <= quat<T>::angleAxisEpsilon) return {};
+	auto const r = (quat<T>)(q.real / len);
+	auto const d = (quat<T>)(q.dual / len);
+	return {r, (quat<T>)(d - r * r.dot(d))};
+}
+
+template<typename T>
+std::ostream & operator<<(std::ostream & o, dualquat<T> const & q) {
+	return o << "(" << q.real << ") + e(" << q.dual << ")";
+}
+
+/*
+screw linear interpolation: a (a* b)^t
+constant speed along the screw motion from a to b: rotating about one axis while sliding along it.
+takes the shortest path, like slerp.  for unit dual quats.
+*/
+template<typename T>
+dualquat<T> sclerp(dualquat<T> const & a, dualquat<T> b, std::type_identity_t<T> t) {
+	using quat = quat<T>;
+	if (a.real.dot(b.real) < 0) b = -b;
+	auto const d = a.conjugate() * b;
+
+	// screw parameters of d: half angle h about axis l, displacement s along l, moment m
+	T const sinH = d.real.axis().length();
+	if (sinH <= quat::angleAxisEpsilon) {
+		// no rotation to speak of, so it's a translation, and that's linear
+		return a * normalize(dualquat<T>(slerp(quat(0,0,0,1), d.real, t), (quat)(d.dual * t)));
+	}
+	T const h = std::atan2(sinH, d.real.w);
+	auto const l = d.real.axis() / sinH;
+	T const s = -2 * d.dual.w / sinH;
+	auto const m = (d.dual.axis() - l * (s / 2 * d.real.w)) / sinH;
+
+	T const ht = h * t, st = s * t;
+	T const sn = std::sin(ht), cs = std::cos(ht);
+	auto const dualAxis = l * (st / 2 * cs) + m * sn;
+	return a * dualquat<T>(
+		quat(l.x * sn, l.y * sn, l.z * sn, cs),
+		quat(dualAxis.x, dualAxis.y, dualAxis.z, -st / 2 * sn)
+	);
+}
+
+/*
+dual quaternion linear blending (Kavan et al, "Skinning with Dual Quaternions")
+normalize(sum_i w_i q_i), with each q_i's sign flipped into q[0]'s hemisphere.
+not quite sclerp for two inputs, but it's close, always a rigid transform, and much cheaper for many inputs.
+*/
+template<typename T>
+dualquat<T> blend(std::span<dualquat<T> const> q, std::span<std::type_identity_t<T> const> weights) {
+	if (q.empty()) throw Common::Exception() << "can't blend no dual quats";
+	if (weights.size() != q.size()) throw Common::Exception() << weights.size() << " weights for " << q.size() << " dual quats";
+	dualquat<T> sum;
+	for (size_t i = 0; i < q.size(); ++i) {
+		T const w = q[i].real.dot(q[0].real) < 0 ? -weights[i] : weights[i];
+		sum = sum + q[i] * w;
+	}
+	return normalize(sum);
+}
+
+/*
+batched kernels, for skinning-style work
+
+like Quat.h's batched rotate(), these go in blocks, split into component arrays, so the loops vectorize.
+src and dst can be the same span.
+*/
+namespace DualQuatDetail {
+inline constexpr int block = 16;
+
+// dst[i] = q(i) applied to src[i], q(i) a unit dual quat
+template<typename T, typename Q>
+void transformBlocks(Q && dualQuatAt, std::span<vec3<T> const> src, std::span<vec3<T>> dst) {
+	constexpr int B = block;
+	size_t const n = src.size();
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const m = (int)std::min<size_t>(B, n - begin);
+		T px[B] = {}, py[B] = {}, pz[B] = {};
+		T rx[B] = {}, ry[B] = {}, rz[B] = {}, rw[B] = {};
+		T dx[B] = {}, dy[B] = {}, dz[B] = {}, dw[B] = {};
+		for (int k = 0; k < m; ++k) {
+			auto const & p = src[begin + k];
+			px[k] = p.x;
+			py[k] = p.y;
+			pz[k] = p.z;
+			dualquat<T> const & q = dualQuatAt(begin + k);
+			rx[k] = q.real.x; ry[k] = q.real.y; rz[k] = q.real.z; rw[k] = q.real.w;
+			dx[k] = q.dual.x; dy[k] = q.dual.y; dz[k] = q.dual.z; dw[k] = q.dual.w;
+		}
+		T ox[B], oy[B], oz[B];
+		for (int k = 0; k < B; ++k) {
+			// rotateUnit, then translation()
+			T const tx = 2 * (ry[k] * pz[k] - rz[k] * py[k]);
+			T const ty = 2 * (rz[k] * px[k] - rx[k] * pz[k]);
+			T const tz = 2 * (rx[k] * py[k] - ry[k] * px[k]);
+			ox[k] = px[k] + rw[k] * tx + (ry[k] * tz - rz[k] * ty)
+				+ 2 * (rw[k] * dx[k] - dw[k] * rx[k] + ry[k] * dz[k] - rz[k] * dy[k]);
+			oy[k] = py[k] + rw[k] * ty + (rz[k] * tx - rx[k] * tz)
+				+ 2 * (rw[k] * dy[k] - dw[k] * ry[k] + rz[k] * dx[k] - rx[k] * dz[k]);
+			oz[k] = pz[k] + rw[k] * tz + (rx[k] * ty - ry[k] * tx)
+				+ 2 * (rw[k] * dz[k] - dw[k] * rz[k] + rx[k] * dy[k] - ry[k] * dx[k]);
+		}
+		for (int k = 0; k < m; ++k) {
+			dst[begin + k] = vec3<T>(ox[k], oy[k], oz[k]);
+		}
+	}
+}
+}
+
+// dst[i] = q.transformPoint(src[i]).  goes through q's matrix, since that's 9 multiplies a point.
+template<typename T>
+void transform(dualquat<T> const & q, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	if (src.size() != dst.size()) throw Common::Exception() << "transform " << src.size() << " points into " << dst.size();
+	auto const m = q.real.toMatrix();
+	auto const t = q.translation();
+	rotate(m, src, dst);
+	for (auto & p : dst) p += t;
+}
+
+// dst[i] = q[i].transformPoint(src[i])
+template<typename T>
+void transform(std::span<dualquat<T> const> q, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	if (q.size() != src.size()) throw Common::Exception() << q.size() << " dual quats for " << src.size() << " points";
+	if (src.size() != dst.size()) throw Common::Exception() << "transform " << src.size() << " points into " << dst.size();
+	DualQuatDetail::transformBlocks<T>([&](size_t i) -> dualquat<T> const & { return q[i]; }, src, dst);
+}
+
+/*
+blend per vertex, for skinning
+vertex i has 'influences' bones: bones[indices[i * influences + j]] with weight weights[i * influences + j], for j in [0, influences)
+dst[i] is their blend() (unused slots can have weight 0).
+then transform(dst, rest positions, skinned positions) does the rest.
+*/
+template<typename T>
+void blend(
+	std::span<dualquat<T> const> bones,
+	std::span<int const> indices,
+	std::span<std::type_identity_t<T> const> weights,
+	int influences,
+	std::span<dualquat<std::type_identity_t<T>>> dst
+) {
+	constexpr int B = DualQuatDetail::block;
+	size_t const n = dst.size();
+	if (influences < 1) throw Common::Exception() << "need at least one influence per vertex, got " << influences;
+	if (indices.size() != n * influences || weights.size() != n * influences) {
+		throw Common::Exception() << indices.size() << " indices and " << weights.size() << " weights for " << n << " vertexes of " << influences << " influences";
+	}
+	for (size_t i = 0; i < indices.size(); ++i) {
+		if (indices[i] < 0 || (size_t)indices[i] >= bones.size()) throw Common::Exception() << "bone index " << indices[i] << " out of range, there are " << bones.size();
+	}
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const m = (int)std::min<size_t>(B, n - begin);
+		// sum[component][k], components are real xyzw then dual xyzw
+		T sum[8][B] = {};
+		T first[4][B] = {};
+		for (int k = 0; k < m; ++k) {
+			auto const & r = bones[indices[(begin + k) * influences]].real;
+			for (int c = 0; c < 4; ++c) first[c][k] = r[c];
+		}
+		for (int j = 0; j < influences; ++j) {
+			T b[8][B] = {}, w[B] = {};
+			for (int k = 0; k < m; ++k) {
+				size_t const slot = (begin + k) * influences + j;
+				auto const & q = bones[indices[slot]];
+				for (int c = 0; c < 4; ++c) {
+					b[c][k] = q.real[c];
+					b[c + 4][k] = q.dual[c];
+				}
+				w[k] = weights[slot];
+			}
+			for (int k = 0; k < B; ++k) {
+				T const d = b[0][k] * first[0][k] + b[1][k] * first[1][k] + b[2][k] * first[2][k] + b[3][k] * first[3][k];
+				T const wk = w[k] * std::copysign((T)1, d);
+				for (int c = 0; c < 8; ++c) {
+					sum[c][k] += b[c][k] * wk;
+				}
+			}
+		}
+		for (int k = 0; k < m; ++k) {
+			dst[begin + k] = normalize(dualquat<T>(
+				quat<T>(sum[0][k], sum[1][k], sum[2][k], sum[3][k]),
+				quat<T>(sum[4][k], sum[5][k], sum[6][k], sum[7][k])
+			));
+		}
+	}
+}
+
+using dualquatf = dualquat<float>;
+using dualquatd = dualquat<double>;
+
+}
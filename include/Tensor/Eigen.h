@@ -0,0 +1,337 @@
+#pragma once
+
+#include "Tensor/Vector.h"
+#include "Common/Exception.h"
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <span>
+
+/*
+eigendecomposition of symmetric matrices
+
+eigen(sym<T,N>) returns the eigenvalues in ascending order, and the eigenvectors as the columns of a mat, so a = V diag(values) V^T.
+eigenvalues(sym<T,N>) skips the eigenvectors.
+
+sym<T,3> is closed form: the trigonometric solution of the characteristic cubic for the values,
+and cross products for the vectors, as in Eberly's "A Robust Eigensolver for 3x3 Symmetric Matrices".
+the cubic's roots are only good to about sqrt(epsilon) of the matrix's scale around a repeated pair,
+so eigen() replaces each value with its eigenvector's Rayleigh quotient, which is good to epsilon.  eigenvalues() alone doesn't have vectors to do that.
+the small eigenvalues of a badly conditioned matrix also lose relative accuracy either way, since they come from cancellation against the big ones.
+eigenJacobi() and eigenvaluesJacobi() are still there for those.
+
+everything else is cyclic Jacobi on the packed upper triangle, same as sym's own storage.
+*/
+
+namespace Tensor {
+
+template<typename T, int N>
+struct EigenSym {
+	vec<T,N> values;
+	mat<T,N,N> vectors;	// vectors(i,k) is component i of eigenvector k
+};
+
+namespace EigenDetail {
+
+// index of (i,j), i <= j, in packed upper-triangle order: 00 01 11 02 12 22 ...
+constexpr int packed(int i, int j) {
+	return i <= j ? j * (j + 1) / 2 + i : i * (i + 1) / 2 + j;
+}
+
+template<typename T, int N>
+void sortAscending(vec<T,N> & values, mat<T,N,N> * vectors) {
+	for (int i = 0; i < N - 1; ++i) {
+		int k = i;
+		for (int j = i + 1; j < N; ++j) {
+			if (values[j] < values[k]) k = j;
+		}
+		if (k == i) continue;
+		std::swap(values[i], values[k]);
+		if (vectors) {
+			for (int r = 0; r < N; ++r) {
+				std::swap((*vectors)(r,i), (*vectors)(r,k));
+			}
+		}
+	}
+}
+
+/*
+cyclic Jacobi on packed storage.  each rotation zeroes s(p,q) and only touches rows/columns p and q, which are the same elements, stored once.
+vectors is accumulated when it isn't null.
+*/
+template<typename T, int N>
+vec<T,N> jacobi(sym<T,N> const & a, mat<T,N,N> * vectors) {
+	constexpr int count = N * (N + 1) / 2;
+	T s[count];
+	for (int j = 0; j < N; ++j) {
+		for (int i = 0; i <= j; ++i) {
+			s[packed(i,j)] = a(i,j);
+		}
+	}
+	if (vectors) *vectors = mat<T,N,N>([](int i, int j) -> T { return i == j; });
+	constexpr T eps = std::numeric_limits<T>::epsilon();
+	for (int sweep = 0; sweep < 50; ++sweep) {
+		T off = 0, diag = 0;
+		for (int p = 0; p < N; ++p) {
+			diag += s[packed(p,p)] * s[packed(p,p)];
+			for (int q = p + 1; q < N; ++q) off += s[packed(p,q)] * s[packed(p,q)];
+		}
+		if (off <= eps * eps * diag) break;
+		for (int p = 0; p < N; ++p) {
+			for (int q = p + 1; q < N; ++q) {
+				T const apq = s[packed(p,q)];
+				if (apq == 0) continue;
+				T const theta = (s[packed(q,q)] - s[packed(p,p)]) / (2 * apq);
+				// t -> 0 if theta^2 overflows, which is when apq is negligible anyway
+				T const t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+				T const c = 1 / std::sqrt(t * t + 1);
+				T const sn = t * c;
+				T const tau = sn / (1 + c);
+				s[packed(p,p)] -= t * apq;
+				s[packed(q,q)] += t * apq;
+				s[packed(p,q)] = 0;
+				for (int k = 0; k < N; ++k) {
+					if (k == p || k == q) continue;
+					T const kp = s[packed(k,p)], kq = s[packed(k,q)];
+					s[packed(k,p)] = kp - sn * (kq + tau * kp);
+					s[packed(k,q)] = kq + sn * (kp - tau * kq);
+				}
+				if (vectors) {
+					auto & v = *vectors;
+					for (int k = 0; k < N; ++k) {
+						T const kp = v(k,p), kq = v(k,q);
+						v(k,p) = kp - sn * (kq + tau * kp);
+						v(k,q) = kq + sn * (kp - tau * kq);
+					}
+				}
+			}
+		}
+	}
+	vec<T,N> values;
+	for (int i = 0; i < N; ++i) values[i] = s[packed(i,i)];
+	sortAscending(values, vectors);
+	return values;
+}
+
+/*
+eigenvalues of a sym3, ascending, by the trigonometric solution of the characteristic cubic of b = (a - q I) / p.
+scale is the max abs element, factored out first so nothing over/underflows.
+*/
+template<typename T>
+vec3<T> sym3Values(sym<T,3> const & a, T & scale, T & halfDet) {
+	T const a00 = a(0,0), a01 = a(0,1), a02 = a(0,2), a11 = a(1,1), a12 = a(1,2), a22 = a(2,2);
+	auto const maxAbs = [](T x, T y) { return std::abs(x) > y ? std::abs(x) : y; };
+	scale = maxAbs(a22, maxAbs(a12, maxAbs(a11, maxAbs(a02, maxAbs(a01, std::abs(a00))))));
+	if (scale == 0) {
+		halfDet = 0;
+		return {};
+	}
+	T const inv = 1 / scale;
+	T const b00 = a00 * inv, b01 = a01 * inv, b02 = a02 * inv, b11 = a11 * inv, b12 = a12 * inv, b22 = a22 * inv;
+	T const q = (b00 + b11 + b22) / 3;
+	T const c00 = b00 - q, c11 = b11 - q, c22 = b22 - q;
+	T const offSq = b01 * b01 + b02 * b02 + b12 * b12;
+	T const p2 = (c00 * c00 + c11 * c11 + c22 * c22 + 2 * offSq) / 6;
+	if (p2 == 0) {
+		// a multiple of the identity
+		halfDet = 0;
+		return vec3<T>(q, q, q) * scale;
+	}
+	T const p = std::sqrt(p2);
+	T const det = c00 * (c11 * c22 - b12 * b12) - b01 * (b01 * c22 - b12 * b02) + b02 * (b01 * b12 - c11 * b02);
+	halfDet = det / (2 * p2 * p);
+	halfDet = halfDet < -1 ? -1 : (halfDet > 1 ? 1 : halfDet);
+	T const phi = std::acos(halfDet) / 3;
+	// the roots of b^3 - 3b - 2 halfDet: 2 cos(phi + 2 pi k / 3)
+	T const beta2 = 2 * std::cos(phi);
+	T const beta0 = 2 * std::cos(phi + (T)(2 * std::numbers::pi / 3));
+	T const beta1 = -(beta0 + beta2);
+	return vec3<T>(q + p * beta0, q + p * beta1, q + p * beta2) * scale;
+}
+
+// eigenvector for value, from the biggest cross product of two rows of a - value I.  value must be a simple eigenvalue.
+template<typename T>
+vec3<T> sym3Vector0(sym<T,3> const & a, T value) {
+	vec3<T> const r0(a(0,0) - value, a(0,1), a(0,2));
+	vec3<T> const r1(a(0,1), a(1,1) - value, a(1,2));
+	vec3<T> const r2(a(0,2), a(1,2), a(2,2) - value);
+	vec3<T> const c01 = cross(r0, r1), c02 = cross(r0, r2), c12 = cross(r1, r2);
+	T const d01 = c01.lenSq(), d02 = c02.lenSq(), d12 = c12.lenSq();
+	if (d01 >= d02 && d01 >= d12) return c01 / std::sqrt(d01);
+	if (d02 >= d12) return c02 / std::sqrt(d02);
+	return c12 / std::sqrt(d12);
+}
+
+// eigenvector for value, perpendicular to the eigenvector v0, from the 2x2 problem in v0's orthogonal complement.  this one handles a repeated value.
+template<typename T>
+vec3<T> sym3Vector1(sym<T,3> const & a, vec3<T> const & v0, T value) {
+	// u, v span the complement of v0
+	vec3<T> u;
+	if (std::abs(v0.x) > std::abs(v0.y)) {
+		u = vec3<T>(-v0.z, 0, v0.x) / std::sqrt(v0.x * v0.x + v0.z * v0.z);
+	} else {
+		u = vec3<T>(0, v0.z, -v0.y) / std::sqrt(v0.y * v0.y + v0.z * v0.z);
+	}
+	vec3<T> const v = cross(v0, u);
+	auto const mul = [&](vec3<T> const & x) {
+		return vec3<T>(
+			a(0,0) * x.x + a(0,1) * x.y + a(0,2) * x.z,
+			a(0,1) * x.x + a(1,1) * x.y + a(1,2) * x.z,
+			a(0,2) * x.x + a(1,2) * x.y + a(2,2) * x.z
+		);
+	};
+	vec3<T> const au = mul(u), av = mul(v);
+	T m00 = u.dot(au) - value, m01 = u.dot(av), m11 = v.dot(av) - value;
+	T const abs00 = std::abs(m00), abs01 = std::abs(m01), abs11 = std::abs(m11);
+	if (abs00 >= abs11) {
+		if ((abs00 > abs01 ? abs00 : abs01) == 0) return u;
+		if (abs00 >= abs01) {
+			m01 /= m00;
+			m00 = 1 / std::sqrt(1 + m01 * m01);
+			m01 *= m00;
+		} else {
+			m00 /= m01;
+			m01 = 1 / std::sqrt(1 + m00 * m00);
+			m00 *= m01;
+		}
+		return u * m01 - v * m00;
+	} else {
+		if ((abs11 > abs01 ? abs11 : abs01) == 0) return u;
+		if (abs11 >= abs01) {
+			m01 /= m11;
+			m11 = 1 / std::sqrt(1 + m01 * m01);
+			m01 *= m11;
+		} else {
+			m11 /= m01;
+			m01 = 1 / std::sqrt(1 + m11 * m11);
+			m11 *= m01;
+		}
+		return u * m11 - v * m01;
+	}
+}
+}
+
+template<typename T>
+vec3<T> eigenvalues(sym<T,3> const & a) {
+	T scale, halfDet;
+	return EigenDetail::sym3Values(a, scale, halfDet);
+}
+
+template<typename T>
+EigenSym<T,3> eigen(sym<T,3> const & a) {
+	T scale, halfDet;
+	EigenSym<T,3> r;
+	r.values = EigenDetail::sym3Values(a, scale, halfDet);
+	if (scale == 0 || r.values[0] == r.values[2]) {
+		r.vectors = mat3x3<T>{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+		return r;
+	}
+	// start from whichever end value is further from the middle one, it's the one that's surely simple
+	auto const b = a * (1 / scale);
+	vec3<T> v[3];
+	if (halfDet >= 0) {
+		v[2] = EigenDetail::sym3Vector0(b, r.values[2] / scale);
+		v[1] = EigenDetail::sym3Vector1(b, v[2], r.values[1] / scale);
+		v[0] = cross(v[1], v[2]);
+	} else {
+		v[0] = EigenDetail::sym3Vector0(b, r.values[0] / scale);
+		v[1] = EigenDetail::sym3Vector1(b, v[0], r.values[1] / scale);
+		v[2] = cross(v[0], v[1]);
+	}
+	for (int k = 0; k < 3; ++k) {
+		for (int i = 0; i < 3; ++i) {
+			r.vectors(i,k) = v[k][i];
+		}
+		// the Rayleigh quotient is good to epsilon even where the cubic's roots weren't
+		auto const & x = v[k];
+		r.values[k] = scale * (
+			b(0,0) * x.x * x.x + b(1,1) * x.y * x.y + b(2,2) * x.z * x.z
+			+ 2 * (b(0,1) * x.x * x.y + b(0,2) * x.x * x.z + b(1,2) * x.y * x.z)
+		);
+	}
+	EigenDetail::sortAscending(r.values, &r.vectors);
+	return r;
+}
+
+// Jacobi, for any size
+template<typename T, int N>
+vec<T,N> eigenvaluesJacobi(sym<T,N> const & a) {
+	return EigenDetail::jacobi<T,N>(a, nullptr);
+}
+
+template<typename T, int N>
+EigenSym<T,N> eigenJacobi(sym<T,N> const & a) {
+	EigenSym<T,N> r;
+	r.values = EigenDetail::jacobi<T,N>(a, &r.vectors);
+	return r;
+}
+
+template<typename T, int N>
+requires (N != 3)
+vec<T,N> eigenvalues(sym<T,N> const & a) {
+	return eigenvaluesJacobi(a);
+}
+
+template<typename T, int N>
+requires (N != 3)
+EigenSym<T,N> eigen(sym<T,N> const & a) {
+	return eigenJacobi(a);
+}
+
+/*
+batched
+the sym3 values-only path goes through in blocks, split into component arrays, so the loop vectorizes.
+(with -fno-math-errno for the sqrt, and a vector math library for the acos and cos, like glibc's libmvec under -ffast-math.)
+the rest go one matrix at a time.
+*/
+namespace EigenDetail {
+inline constexpr int block = 16;
+}
+
+template<typename T, int N>
+void eigenvalues(std::span<sym<T,N> const> a, std::span<vec<std::type_identity_t<T>,N>> dst) {
+	if (a.size() != dst.size()) throw Common::Exception() << a.size() << " matrices for " << dst.size() << " eigenvalues";
+	if constexpr (N != 3) {
+		for (size_t i = 0; i < a.size(); ++i) dst[i] = eigenvalues(a[i]);
+	} else {
+		constexpr int B = EigenDetail::block;
+		size_t const n = a.size();
+		for (size_t begin = 0; begin < n; begin += B) {
+			int const count = (int)std::min<size_t>(B, n - begin);
+			T m[6][B] = {};
+			for (int k = 0; k < count; ++k) {
+				for (int c = 0; c < 6; ++c) m[c][k] = a[begin + k].s[c];
+			}
+			T r0[B], r1[B], r2[B];
+			for (int k = 0; k < B; ++k) {
+				// sym3Values without the scaling or the early outs.  a multiple of the identity has p = 0 and comes out q, q, q
+				T const a00 = m[0][k], a01 = m[1][k], a11 = m[2][k], a02 = m[3][k], a12 = m[4][k], a22 = m[5][k];
+				T const q = (a00 + a11 + a22) / 3;
+				T const c00 = a00 - q, c11 = a11 - q, c22 = a22 - q;
+				T const p2 = (c00 * c00 + c11 * c11 + c22 * c22 + 2 * (a01 * a01 + a02 * a02 + a12 * a12)) / 6;
+				T const p = std::sqrt(p2);
+				T const invP = p2 > 0 ? 1 / p : 0;
+				T const d00 = c00 * invP, d11 = c11 * invP, d22 = c22 * invP, d01 = a01 * invP, d02 = a02 * invP, d12 = a12 * invP;
+				T halfDet = (d00 * (d11 * d22 - d12 * d12) - d01 * (d01 * d22 - d12 * d02) + d02 * (d01 * d12 - d11 * d02)) / 2;
+				halfDet = halfDet < -1 ? -1 : (halfDet > 1 ? 1 : halfDet);
+				T const phi = std::acos(halfDet) / 3;
+				T const beta2 = 2 * std::cos(phi);
+				T const beta0 = 2 * std::cos(phi + (T)(2 * std::numbers::pi / 3));
+				r0[k] = q + p * beta0;
+				r1[k] = q - p * (beta0 + beta2);
+				r2[k] = q + p * beta2;
+			}
+			for (int k = 0; k < count; ++k) {
+				dst[begin + k] = vec3<T>(r0[k], r1[k], r2[k]);
+			}
+		}
+	}
+}
+
+template<typename T, int N>
+void eigen(std::span<sym<T,N> const> a, std::span<EigenSym<std::type_identity_t<T>,N>> dst) {
+	if (a.size() != dst.size()) throw Common::Exception() << a.size() << " matrices for " << dst.size() << " eigendecompositions";
+	for (size_t i = 0; i < a.size(); ++i) dst[i] = eigen(a[i]);
+}
+
+}
@@ -2,8 +2,12 @@
 
 #include "Tensor/Vector.h"	// new tensor struct
 #include "Tensor/Range.h"
+#include "Tensor/ThreadPool.h"
 #include "Common/Exception.h"
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
 
 #if PLATFORM_MSVC
 #undef min
@@ -23,55 +27,274 @@ inline intN<rank> stepForSize(intN<rank> const size) {
 	return step;
 }
 
+/*
+cursor into a Grid for stencil code
+keeps the flat offset in sync with the index so neighbor access is just v[offset + delta * step[axis]] instead of a dot() per access
+
+GridType is whatever we are iterating over (incl. constness) - it just needs .v, .step and .size
+border < 0 means the cursor can be anywhere in the grid, so neighbor() is bounds-checked under DEBUG
+border >= 0 means the cursor came from an interior range at least 'border' cells from each edge,
+	so neighbor() with |delta| <= border needs no checks, and anything past that is a compile error.
+*/
+template<typename GridType, int border_ = -1>
+struct GridCursor {
+	using GridNoConst = std::remove_const_t<GridType>;
+	static constexpr auto rank = GridNoConst::rank;
+	static constexpr int border = border_;
+	using intN = Tensor::intN<rank>;
+	using Type = std::conditional_t<
+		std::is_const_v<GridType>,
+		typename GridNoConst::Type const,
+		typename GridNoConst::Type
+	>;
+
+	GridType * grid = {};
+	intN index;
+	int offset = {};
+
+	Type & operator*() const { return grid->v[offset]; }
+	Type * operator->() const { return grid->v + offset; }
+
+	template<int axis, int delta>
+	Type & neighbor() const {
+		static_assert(axis >= 0 && axis < rank, "neighbor axis out of bounds");
+		if constexpr (border >= 0) {
+			static_assert(delta >= -border && delta <= border, "neighbor offset is past the interior range's border");
+		} else {
+#ifdef DEBUG
+			int const i = index[axis] + delta;
+			if (i < 0 || i >= grid->size[axis]) {
+				throw Common::Exception() << "size is " << grid->size << " but neighbor of " << index << " along axis " << axis << " is " << i;
+			}
+#endif
+		}
+		return grid->v[offset + delta * grid->step[axis]];
+	}
+
+	// runtime-offset neighbor, for when the stencil isn't known at compile time
+	Type & neighbor(intN const & delta) const {
+#ifdef DEBUG
+		for (int i = 0; i < rank; ++i) {
+			int const j = index[i] + delta[i];
+			if (j < 0 || j >= grid->size[i]) {
+				throw Common::Exception() << "size is " << grid->size << " but neighbor of " << index << " is " << (index + delta);
+			}
+		}
+#endif
+		return grid->v[offset + delta.dot(grid->step)];
+	}
+};
+
+// iterate a box [min, max) of a Grid in memory order (index 0 first, same as RangeObj's inner-first order)
+template<typename GridType, int border = -1>
+struct GridCursorRange {
+	using Cursor = GridCursor<GridType, border>;
+	static constexpr auto rank = Cursor::rank;
+	using intN = typename Cursor::intN;
+
+	GridType * grid = {};
+	intN min, max;
+
+	GridCursorRange(GridType * grid_, intN const & min_, intN const & max_)
+	: grid(grid_), min(min_), max(max_) {}
+
+	struct iterator {
+		Cursor cursor;
+		intN min, max;
+
+		Cursor const & operator*() const { return cursor; }
+		Cursor const * operator->() const { return &cursor; }
+
+		iterator & operator++() {
+			auto & index = cursor.index;
+			auto const & step = cursor.grid->step;
+			++index[0];
+			cursor.offset += step[0];
+			for (int i = 0; i < rank-1; ++i) {
+				if (index[i] < max[i]) return *this;
+				cursor.offset += step[i+1] - (index[i] - min[i]) * step[i];
+				index[i] = min[i];
+				++index[i+1];
+			}
+			return *this;
+		}
+
+		bool operator==(iterator const & o) const { return cursor.index == o.cursor.index; }
+		bool operator!=(iterator const & o) const { return !operator==(o); }
+	};
+
+	iterator end() const {
+		intN index = min;
+		index[rank-1] = max[rank-1];
+		return iterator{Cursor{grid, index, index.dot(grid->step)}, min, max};
+	}
+
+	iterator begin() const {
+		for (int i = 0; i < rank; ++i) {
+			if (max[i] <= min[i]) return end();
+		}
+		return iterator{Cursor{grid, min, min.dot(grid->step)}, min, max};
+	}
+};
+
+/*
+slabs for splitting work on a grid across threads
+slabs are runs of layers along the slowest-varying axis (rank-1), about gridSlabBytes each.
+the split only depends on the grid size and sizeof(Type), never on the number of threads.
+*/
+
+// about an L2's worth
+inline constexpr int gridSlabBytes = 1 << 18;
+
+struct GridSlabs {
+	int depth = {};	// how many slowest-axis layers per slab
+	int count = {};	// how many slabs
+};
+
+template<typename G>
+GridSlabs gridSlabs(G const & g, int slabBytes = gridSlabBytes) {
+	constexpr int last = G::rank - 1;
+	int const n = g.size[last];
+	if (n <= 0) return {};
+	long layerCells = 1;
+	for (int i = 0; i < last; ++i) {
+		layerCells *= g.size[i];
+	}
+	long const layerBytes = std::max<long>(1, layerCells * (long)sizeof(typename G::Type));
+	int const depth = (int)std::clamp<long>(slabBytes / layerBytes, 1, n);
+	return {depth, (n + depth - 1) / depth};
+}
+
+// calls f(min, max) for each slab's box, in parallel
+template<typename G, typename F>
+void forEachGridSlab(G & g, ThreadPool & pool, F && f) {
+	using intN = Tensor::intN<G::rank>;
+	constexpr int last = G::rank - 1;
+	auto const slabs = gridSlabs(g);
+	pool.parallelFor(slabs.count, [&](int s) {
+		intN min, max = g.size;
+		min[last] = s * slabs.depth;
+		max[last] = std::min(g.size[last], min[last] + slabs.depth);
+		f(min, max);
+	});
+}
+
+/*
+calls row(p, n, index) for each run of cells along axis 0 within [min, max)
+where p is the cell at 'index', and the run's k'th cell is p[k * g.step[0]]
+*/
+template<typename G, typename RowF>
+void forEachGridRow(G & g, intN<G::rank> const & min, intN<G::rank> const & max, RowF && row) {
+	constexpr int rank = G::rank;
+	for (int i = 0; i < rank; ++i) {
+		if (max[i] <= min[i]) return;
+	}
+	int const n = max[0] - min[0];
+	auto index = min;
+	for (;;) {
+		row(g.v + index.dot(g.step), n, index);
+		int j = 1;
+		for (; j < rank; ++j) {
+			if (++index[j] < max[j]) break;
+			index[j] = min[j];
+		}
+		if (j == rank) return;
+	}
+}
+
+template<typename Type, int rank>
+struct GridView;
+
+// tag for the Grid ctors that construct their cells in parallel slabs
+// so each slab's pages get first touched (and placed on the NUMA node of) the thread that will likely process it
+struct FirstTouch {
+	ThreadPool * pool = &ThreadPool::get();
+};
+
 //rank is templated, but dim is not as it varies per-rank
 //so this is dynamically-sized tensor
-template<typename Type_, int rank_>
+/*
+Allocator is used for all storage the Grid owns.
+The default is the pmr one, so you can pass a polymorphic_allocator over anything from Tensor/Memory.h (aligned, recycling, etc)
+*/
+template<typename Type_, int rank_, typename Allocator_ = std::pmr::polymorphic_allocator<Type_>>
 struct Grid {
 	using Type = Type_;
 	using value_type = Type;
 	static constexpr auto rank = rank_;
 	using intN = Tensor::intN<rank>;
+	using Allocator = Allocator_;
+	using AllocTraits = std::allocator_traits<Allocator>;
+	static_assert(std::is_same_v<typename AllocTraits::value_type, Type>);
 
 	intN size;
 	Type * v = {};
 	bool own = {};	//or just use a shared_ptr to v?
+	int capacity = {};	// cells allocated at v, if we own it.  can be more than size.product() after shrinking the slowest axis.
 
 	//cached for quick access by dot with index vector
 	//step[0] = 1, step[1] = size[0], step[j] = product(i=1,j-1) size[i]
 	intN step;
 
+	[[no_unique_address]] Allocator alloc;
+
 	Grid() {
 		// TODO but in my ptr ctor I say v cannot be null ... ?
 	}
 
+	explicit Grid(Allocator const & alloc_) : alloc(alloc_) {}
+
 	// deep copy
 	Grid(Grid const & src)
 	:	size(src.size),
-		v(new Type[src.size.product()]()),
 		own(true),
-		step(stepForSize(src.size))
+		step(stepForSize(src.size)),
+		alloc(AllocTraits::select_on_container_copy_construction(src.alloc))
 	{
-		for (auto i : range()) {
-			(*this)(i) = src(i);
-		}
+		int const n = size.product();
+		v = allocate(capacity = n);
+		forEachChunk(n, [&](int begin, int end) {
+			copyConstruct(v + begin, src.v + begin, end - begin);
+		});
 	}
 
 	Grid(Grid && src)
 	:	size(src.size),
 		v(src.v),
-		own(true),
-		step(stepForSize(src.size))
+		own(src.own),
+		capacity(src.capacity),
+		step(src.step),
+		alloc(std::move(src.alloc))
 	{
 		src.v = nullptr;
 		src.own = false;	// don't free
 	}
 
-	Grid(intN const & size_)
+	Grid(intN const & size_, Allocator const & alloc_ = {})
 	:	size(size_),
-		v(new Type[size.product()]()),
 		own(true),
-		step(stepForSize(size_))
-	{}
+		step(stepForSize(size_)),
+		alloc(alloc_)
+	{
+		int const n = size.product();
+		v = allocate(capacity = n);
+		valueConstruct(v, n);
+	}
+
+	// same but value-initializes in parallel slabs
+	Grid(intN const & size_, FirstTouch firstTouch, Allocator const & alloc_ = {})
+	:	size(size_),
+		own(true),
+		step(stepForSize(size_)),
+		alloc(alloc_)
+	{
+		v = allocate(capacity = size.product());
+		forEachGridSlab(*this, *firstTouch.pool, [&](intN const & min, intN const & max) {
+			forEachGridRow(*this, min, max, [&](Type * p, int n, intN const &) {
+				valueConstruct(p, n);
+			});
+		});
+	}
 
 	// shallow copy by default ... when passed a pointer ...
 	// ... is this a bad idea?
@@ -84,20 +307,124 @@ struct Grid {
 		if (!v) throw Common::Exception() << "v cannot be null.  use the (intN) constructor.";
 	}
 
-	Grid(intN const & size_, std::function<Type(intN)> f)
+	// f(intN index) or f(int flatIndex), called in memory order
+	// taking F as a template arg (instead of std::function) lets it inline into the loop
+	template<typename F>
+	requires (std::is_invocable_r_v<Type, F, intN> || std::is_invocable_r_v<Type, F, int>)
+	Grid(intN const & size_, F && f, Allocator const & alloc_ = {})
 	:	size(size_),
-		v(new Type[size_.product()]()),
 		own(true),
-		step(stepForSize(size_))
+		step(stepForSize(size_)),
+		alloc(alloc_)
 	{
-		for (auto i : range()) {
-			(*this)(i) = f(i);
-		}
+		int const n = size.product();
+		v = allocate(capacity = n);
+		fillInMemoryOrder(v, n, intN(), size, std::forward<F>(f));
+	}
+
+	// same but in parallel slabs, for first-touch placement.  f must be safe to call from multiple threads.
+	template<typename F>
+	requires (std::is_invocable_r_v<Type, F, intN> || std::is_invocable_r_v<Type, F, int>)
+	Grid(intN const & size_, F && f, FirstTouch firstTouch, Allocator const & alloc_ = {})
+	:	size(size_),
+		own(true),
+		step(stepForSize(size_)),
+		alloc(alloc_)
+	{
+		v = allocate(capacity = size.product());
+		forEachGridSlab(*this, *firstTouch.pool, [&](intN const & min, intN const & max) {
+			Type * p = v + min.dot(step);
+			intN sliceSize = max - min;
+			fillInMemoryOrder(p, sliceSize.product(), min, max, f);
+		});
 	}
 
 	~Grid() {
-		if (own) {
-			delete[] v;
+		release();
+	}
+
+	// uninitialized storage for n cells
+	Type * allocate(int n) {
+		if (n <= 0) return nullptr;
+		return AllocTraits::allocate(alloc, (size_t)n);
+	}
+
+	// destroy and free v, if we own it
+	void release() {
+		if (own && v) {
+			destroy(v, size.product());
+			AllocTraits::deallocate(alloc, v, (size_t)capacity);
+		}
+		v = nullptr;
+		own = false;
+		capacity = 0;
+	}
+
+	// f(begin, end) over [0, n) in chunks of about gridSlabBytes, in parallel when there's more than one
+	template<typename F>
+	static void forEachChunk(int n, F && f) {
+		int const chunk = std::max<int>(1, gridSlabBytes / (int)sizeof(Type));
+		int const count = (n + chunk - 1) / chunk;
+		if (count <= 1) {
+			if (n > 0) f(0, n);
+			return;
+		}
+		ThreadPool::get().parallelFor(count, [&](int c) {
+			f(c * chunk, std::min(n, (c + 1) * chunk));
+		});
+	}
+
+	void valueConstruct(Type * p, int n) {
+		for (int k = 0; k < n; ++k) AllocTraits::construct(alloc, p + k);
+	}
+
+	void destroy(Type * p, int n) {
+		if constexpr (!std::is_trivially_destructible_v<Type>) {
+			for (int k = 0; k < n; ++k) AllocTraits::destroy(alloc, p + k);
+		}
+	}
+
+	void copyConstruct(Type * dst, Type const * src, int n) {
+		if constexpr (std::is_trivially_copyable_v<Type>) {
+			if (n > 0) std::memcpy((void*)dst, (void const*)src, sizeof(Type) * n);
+		} else {
+			for (int k = 0; k < n; ++k) AllocTraits::construct(alloc, dst + k, src[k]);
+		}
+	}
+
+	/*
+	constructs the n cells at p, which are the box [min, max), with f(index) or f(flatIndex), walking p linearly
+	step[0] = 1 so memory order is index 0 first, same as range()
+	the intN form runs an inner loop over index 0 so it doesn't have to carry every cell
+	trivial types aren't default-constructed first, so each cell is only written once
+	*/
+	template<typename F>
+	void fillInMemoryOrder(Type * p, int n, intN const & min, intN const & max, F && f) {
+		if (n <= 0) return;
+		auto construct = [&](Type * q, auto && x) {
+			if constexpr (std::is_trivially_default_constructible_v<Type> && std::is_trivially_copy_assignable_v<Type>) {
+				*q = x;
+			} else {
+				AllocTraits::construct(alloc, q, std::forward<decltype(x)>(x));
+			}
+		};
+		Type * const pend = p + n;
+		if constexpr (std::is_invocable_r_v<Type, F, intN>) {
+			intN i = min;
+			while (p < pend) {
+				for (i[0] = min[0]; i[0] < max[0]; ++i[0]) {
+					construct(p++, f(i));
+				}
+				for (int j = 1; j < rank; ++j) {
+					if (++i[j] < max[j]) break;
+					i[j] = min[j];
+				}
+			}
+		} else {
+			int k = min.dot(step);
+			for (; p < pend; ++p, ++k) {
+				construct(p, f(k));
+			}
 		}
 	}
 
@@ -178,6 +505,20 @@ struct Grid {
 		return RangeObj<rank>(intN(), size);
 	}
 
+	// same order as range(), but iterates GridCursors for stencil access
+	GridCursorRange<Grid> cursorRange() { return {this, intN(), size}; }
+	GridCursorRange<Grid const> cursorRange() const { return {this, intN(), size}; }
+
+	// cells at least 'border' away from every edge, so neighbor<axis, delta>() with |delta| <= border is statically in bounds
+	template<int border> requires (border >= 0)
+	GridCursorRange<Grid, border> interiorRange() { return {this, intN(border), size - border}; }
+	template<int border> requires (border >= 0)
+	GridCursorRange<Grid const, border> interiorRange() const { return {this, intN(border), size - border}; }
+
+	// non-owning views, see GridView
+	GridView<Type, rank> view() { return {size, step, v}; }
+	GridView<Type const, rank> view() const { return {size, step, v}; }
+
 	//dereference by vararg ints
 
 	template<typename... Rest>
@@ -187,52 +528,119 @@ struct Grid {
 
 	//dereference by a vector of ints
 
+	/*
+	keeps the overlap of the old and new sizes, and value-initializes the rest
+	if only the slowest axis changes, the cells that stay are already in the right place,
+	so shrinking just drops the end (and keeps the capacity), and growing only constructs the new layers, reallocating if it has to.
+	otherwise rows of the overlap get copied along axis 0 into new storage, in parallel slabs.
+	*/
 	void resize(intN const& newSize) {
 		if (size == newSize) return;
+		int const n = size.product();
+		int const newN = newSize.product();
 
-		intN oldSize = size;
-		intN oldStep = step;
-		Type* oldV = v;
-
-		size = newSize;
-		v = new Type[newSize.product()];
-		step(0) = 1;
-		for (int i = 1; i < rank; ++i) {
-			step(i) = step(i-1) * size(i-1);
+		bool slowestOnly = own || !v;
+		for (int i = 0; i < rank-1; ++i) {
+			slowestOnly = slowestOnly && size[i] == newSize[i];
+		}
+		if (slowestOnly) {
+			if (newN <= n) {
+				destroy(v + newN, n - newN);
+			} else {
+				if (newN > capacity) reserve(newN);
+				valueConstruct(v + n, newN - n);
+			}
+			size = newSize;
+			step = stepForSize(newSize);
+			return;
 		}
 
 		intN minSize;
 		for (int i = 0; i < rank; ++i) {
-			minSize(i) = size(i) < oldSize(i) ? size(i) : oldSize(i);
-		}
-
-		RangeObj<rank> range(intN(), minSize);
-		for (typename RangeObj<rank>::iterator iter = range.begin(); iter != range.end(); ++iter) {
-			intN index = *iter;
-			int oldOffset = oldStep.dot(index);
-			(*this)(index) = oldV[oldOffset];
+			minSize(i) = size(i) < newSize(i) ? size(i) : newSize(i);
 		}
+		auto dst = GridView<Type, rank>(newSize, stepForSize(newSize), allocate(newN));
+		forEachGridSlab(dst, ThreadPool::get(), [&](intN const & min, intN const & max) {
+			forEachGridRow(dst, min, max, [&](Type * p, int m, intN const & index) {
+				int copied = minSize[0];
+				for (int i = 1; i < rank; ++i) {
+					if (index[i] >= minSize[i]) copied = 0;
+				}
+				copyConstruct(p, v + index.dot(step), copied);
+				valueConstruct(p + copied, m - copied);
+			});
+		});
+		release();
+		v = dst.v;
+		own = true;
+		capacity = newN;
+		size = newSize;
+		step = dst.step;
+	}
 
-		delete[] oldV;
+	// make room for n cells without reallocating, for growing the slowest axis.  this takes ownership of v.
+	void reserve(int n) {
+		if (own && n <= capacity) return;
+		int const count = size.product();
+		n = std::max(n, count);
+		Type * const newV = allocate(n);
+		forEachChunk(count, [&](int begin, int end) {
+			if constexpr (std::is_trivially_copyable_v<Type>) {
+				copyConstruct(newV + begin, v + begin, end - begin);
+			} else {
+				for (int k = begin; k < end; ++k) AllocTraits::construct(alloc, newV + k, std::move(v[k]));
+			}
+		});
+		release();
+		v = newV;
+		own = true;
+		capacity = n;
 	}
 
 	Grid & operator=(Grid const & src) {
-		resize(src.size);
+		if (this == &src) return *this;
+
+		// same size: copy in place.  this also writes through non-owned v's, like it always has.
+		if (size == src.size && v) {
+			forEachChunk(size.product(), [&](int begin, int end) {
+				std::copy(src.v + begin, src.v + end, v + begin);
+			});
+			return *this;
+		}
 
-		Type* srcv = src.v;
-		Type* dstv = v;
-		for (int i = size.product()-1; i >= 0; --i) {
-			*(dstv++) = *(srcv++);
+		// otherwise don't bother resize()ing and copying the old contents just to overwrite them
+		release();
+		if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+			alloc = src.alloc;
 		}
+		size = src.size;
+		step = src.step;
+		own = true;
+		int const n = size.product();
+		v = allocate(capacity = n);
+		forEachChunk(n, [&](int begin, int end) {
+			copyConstruct(v + begin, src.v + begin, end - begin);
+		});
 		return *this;
 	}
 
 	Grid & operator=(Grid && src) {
-		if (own) {
-			delete[] v;
+		if (this == &src) return *this;
+		// can't take src's buffer if our allocator can't free it
+		if constexpr (!AllocTraits::propagate_on_container_move_assignment::value
+			&& !AllocTraits::is_always_equal::value
+		) {
+			if (src.own && !(alloc == src.alloc)) {
+				return operator=((Grid const &)src);
+			}
+		}
+		release();
+		if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+			alloc = std::move(src.alloc);
 		}
 		v = src.v;
 		own = src.own;
+		capacity = src.capacity;
 		size = src.size;
 		step = src.step;
 		src.v = nullptr;
@@ -240,11 +648,181 @@ struct Grid {
 		return *this;
 	}
 
+	// results keep our allocator (rebound to the new type), so they use the same memory resource
+	template<typename Return>
+	using RebindGrid = Grid<Return, rank, typename AllocTraits::template rebind_alloc<Return>>;
+
 	template<typename Return>
 	decltype(auto) map(std::function<Return(Type)> f) const {
-		return Grid<Return, rank>(size, [&](intN i) -> Return {
-			return f((*this)(i));
-		});
+		using Result = RebindGrid<Return>;
+		return Result(size, [&](int k) -> Return {
+			return f(v[k]);
+		}, typename Result::Allocator(alloc));
+	}
+
+	// same but with any callable, no type-erasure
+	template<typename F>
+	requires std::is_invocable_v<F, Type const &>
+	auto map(F && f) const {
+		using Return = std::decay_t<std::invoke_result_t<F, Type const &>>;
+		using Result = RebindGrid<Return>;
+		return Result(size, [&](int k) -> Return {
+			return f(v[k]);
+		}, typename Result::Allocator(alloc));
+	}
+};
+
+/*
+non-owning view of a Grid, or of any strided block of memory
+it has its own size, step and base pointer, so sub-boxes, planes, transposes and tensor components
+are all just a different step and offset into the same memory, no copies.
+steps are in units of Type, and can be non-unit or permuted.
+use Type const for read-only views.
+
+cursorRange() etc point back at the view, so keep the view alive while iterating
+(i.e. don't range-for over a temporary's cursorRange(), it'll dangle)
+*/
+template<typename Type_, int rank_>
+struct GridView {
+	using Type = Type_;
+	using value_type = std::remove_const_t<Type>;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+
+	intN size;
+	intN step;
+	Type * v = {};
+
+	GridView() {}
+
+	GridView(intN const & size_, intN const & step_, Type * v_)
+	: size(size_), step(step_), v(v_) {}
+
+	template<typename Allocator>
+	GridView(Grid<value_type, rank, Allocator> & g)
+	: size(g.size), step(g.step), v(g.v) {}
+
+	template<typename Allocator>
+	requires std::is_const_v<Type>
+	GridView(Grid<value_type, rank, Allocator> const & g)
+	: size(g.size), step(g.step), v(g.v) {}
+
+	// non-const view => const view
+	// (templated so it doesn't hide the copy ctor)
+	template<typename U>
+	requires (std::is_const_v<Type> && std::is_same_v<U, value_type>)
+	GridView(GridView<U, rank> const & o)
+	: size(o.size), step(o.step), v(o.v) {}
+
+	Type & operator()(intN const & i) const {
+#ifdef DEBUG
+		for (int j = 0; j < rank; ++j) {
+			if (i[j] < 0 || i[j] >= size[j]) {
+				throw Common::Exception() << "size is " << size << " but dereference is " << i;
+			}
+		}
+#endif
+		return v[i.dot(step)];
+	}
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type & operator()(int first, Rest... rest) const {
+		std::array<int, rank> const a = {first, (int)rest...};
+		intN i;
+		for (int j = 0; j < rank; ++j) {
+			i[j] = a[j];
+		}
+		return (*this)(i);
+	}
+
+	RangeObj<rank> range() const {
+		return RangeObj<rank>(intN(), size);
+	}
+
+	// views are shallow, so a const view still gives cursors to (maybe) non-const cells
+	GridCursorRange<GridView> cursorRange() const { return {const_cast<GridView*>(this), intN(), size}; }
+
+	template<int border> requires (border >= 0)
+	GridCursorRange<GridView, border> interiorRange() const { return {const_cast<GridView*>(this), intN(border), size - border}; }
+
+	// the sub-box [min, max)
+	GridView slice(intN const & min, intN const & max) const {
+#ifdef DEBUG
+		for (int j = 0; j < rank; ++j) {
+			if (min[j] < 0 || max[j] > size[j] || max[j] < min[j]) {
+				throw Common::Exception() << "size is " << size << " but slice is " << min << " to " << max;
+			}
+		}
+#endif
+		return GridView(max - min, step, v + min.dot(step));
+	}
+
+	// fix index 'axis' at i and drop it, so a plane of a 3D grid is a 2D grid
+	template<int axis>
+	requires (rank > 1 && axis >= 0 && axis < rank)
+	GridView<Type, rank-1> fixAxis(int i) const {
+#ifdef DEBUG
+		if (i < 0 || i >= size[axis]) {
+			throw Common::Exception() << "size is " << size << " but fixAxis<" << axis << "> index is " << i;
+		}
+#endif
+		using intM = Tensor::intN<rank-1>;
+		intM newSize, newStep;
+		for (int j = 0, k = 0; j < rank; ++j) {
+			if (j == axis) continue;
+			newSize[k] = size[j];
+			newStep[k] = step[j];
+			++k;
+		}
+		return GridView<Type, rank-1>(newSize, newStep, v + i * step[axis]);
+	}
+
+	template<int a = 0, int b = 1>
+	requires (a >= 0 && a < rank && b >= 0 && b < rank)
+	GridView transpose() const {
+		GridView t = *this;
+		std::swap(t.size[a], t.size[b]);
+		std::swap(t.step[a], t.step[b]);
+		return t;
+	}
+
+	/*
+	view of one element of each cell's storage, i.e. cell.s[i]
+	for vec-of-vec this is a row, for vec or sym etc it's a single scalar
+	chain them to get deeper: g.view().component(1).component(2)
+	*/
+	auto component(int i) const {
+		using Inner = typename decltype(std::declval<value_type>().s)::value_type;
+		using InnerC = std::conditional_t<std::is_const_v<Type>, Inner const, Inner>;
+		static_assert(sizeof(value_type) % sizeof(Inner) == 0);
+		constexpr int scale = sizeof(value_type) / sizeof(Inner);
+		using CharC = std::conditional_t<std::is_const_v<Type>, char const, char>;
+		auto p = (CharC*)v + (size_t)i * sizeof(Inner);
+		return GridView<InnerC, rank>(size, step * scale, (InnerC*)p);
+	}
+
+	// view of the scalar at cell(index), for tensors whose index returns a reference (so vec, sym, etc -- not asym)
+	template<typename T = value_type>
+	requires is_tensor_v<T>
+	auto component(typename T::intN const & index) const {
+		using Scalar = typename T::Scalar;
+		using ScalarC = std::conditional_t<std::is_const_v<Type>, Scalar const, Scalar>;
+		static_assert(sizeof(T) % sizeof(Scalar) == 0);
+		T probe = {};
+		static_assert(std::is_lvalue_reference_v<decltype(probe(index))>, "component(index) needs an index that references storage.  use component(storageIndex) instead.");
+		auto const ofs = (char const *)&probe(index) - (char const *)&probe;
+		constexpr int scale = sizeof(T) / sizeof(Scalar);
+		using CharC = std::conditional_t<std::is_const_v<Type>, char const, char>;
+		return GridView<ScalarC, rank>(size, step * scale, (ScalarC*)((CharC*)v + ofs));
+	}
+
+	// deep copy into a new Grid
+	template<typename Allocator = std::pmr::polymorphic_allocator<value_type>>
+	Grid<value_type, rank, Allocator> copy(Allocator const & alloc = {}) const {
+		return Grid<value_type, rank, Allocator>(size, [&](intN const & i) -> value_type {
+			return v[i.dot(step)];
+		}, alloc);
 	}
 };
 
@@ -0,0 +1,326 @@
+#pragma once
+
+/*
+splitting one logical grid into blocks, each a GhostGrid of its own, with halo exchange between them
+
+DomainDecomposition is just the arithmetic: which block covers which cells, and who its neighbors are.
+blocks are numbered in inner-first order over 'parts', same as a Grid's memory order.
+Subdomain is one block's data, with its ghost layers.
+exchangeHalos() fills the ghost layers, from neighbors through a HaloTransport, or from the boundary policy at the edges of the whole domain.
+
+the transport is abstract so the same code runs blocks in threads of one process (SharedMemoryHaloTransport)
+or in separate processes (implement send/recv over MPI or whatever, mapping block ids to processes).
+*/
+
+#include "Tensor/GridGhost.h"
+#include "Common/Exception.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace Tensor {
+
+/*
+moves bytes between blocks
+send() must not wait for the matching recv(), so every block can send all of its faces before receiving any.
+messages with the same (from, to, tag) arrive in the order they were sent.
+*/
+struct HaloTransport {
+	virtual ~HaloTransport() {}
+	virtual void send(int from, int to, int tag, void const * data, size_t bytes) = 0;
+	// blocks until the matching send has arrived
+	virtual void recv(int from, int to, int tag, void * data, size_t bytes) = 0;
+};
+
+// mailboxes, for blocks that are all in one process
+struct SharedMemoryHaloTransport : public HaloTransport {
+protected:
+	std::mutex mutex;
+	std::condition_variable arrived;
+	std::map<std::tuple<int, int, int>, std::deque<std::vector<uint8_t>>> mailboxes;
+
+public:
+	virtual void send(int from, int to, int tag, void const * data, size_t bytes) override {
+		auto const p = (uint8_t const *)data;
+		std::vector<uint8_t> msg(p, p + bytes);
+		{
+			std::lock_guard lock(mutex);
+			mailboxes[{from, to, tag}].push_back(std::move(msg));
+		}
+		arrived.notify_all();
+	}
+
+	virtual void recv(int from, int to, int tag, void * data, size_t bytes) override {
+		std::vector<uint8_t> msg;
+		{
+			std::unique_lock lock(mutex);
+			auto & box = mailboxes[{from, to, tag}];
+			arrived.wait(lock, [&]{ return !box.empty(); });
+			msg = std::move(box.front());
+			box.pop_front();
+		}
+		if (msg.size() != bytes) {
+			throw Common::Exception() << "halo message from " << from << " to " << to << " tag " << tag << " is " << msg.size() << " bytes, expected " << bytes;
+		}
+		if (bytes) std::memcpy(data, msg.data(), bytes);
+	}
+};
+
+template<typename Type_, int rank_, typename Allocator_ = std::pmr::polymorphic_allocator<Type_>>
+struct Subdomain {
+	using Type = Type_;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	using Allocator = Allocator_;
+
+	int id = -1;
+	intN min, max;	// the cells of the whole domain this block covers
+	GhostGrid<Type, rank, Allocator> grid;
+
+	// copy our part of the whole domain in, or back out
+	void scatterFrom(GridView<Type const, rank> const & whole) {
+		copyBox(grid.interior(), whole.slice(min, max));
+	}
+
+	void gatherInto(GridView<Type, rank> const & whole) const {
+		copyBox(whole.slice(min, max), grid.interior());
+	}
+
+	static void copyBox(GridView<Type, rank> const & dst, GridView<Type const, rank> const & src) {
+		forEachGridRow(dst, intN(), dst.size, [&](Type * p, int n, intN const & index) {
+			Type const * q = &src(index);
+			for (int k = 0; k < n; ++k) {
+				p[k * dst.step[0]] = q[k * src.step[0]];
+			}
+		});
+	}
+};
+
+template<int rank_>
+struct DomainDecomposition {
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+
+	intN size;	// of the whole domain
+	intN parts;	// blocks along each axis
+	intN ghost;
+	std::array<bool, rank> periodic = {};	// per axis, whether the edge blocks are each others' neighbors
+
+	DomainDecomposition() {}
+
+	DomainDecomposition(intN const & size_, intN const & parts_, intN const & ghost_, std::array<bool, rank> const & periodic_ = {})
+	:	size(size_),
+		parts(parts_),
+		ghost(ghost_),
+		periodic(periodic_)
+	{
+		for (int i = 0; i < rank; ++i) {
+			if (parts[i] < 1 || parts[i] > std::max(1, size[i])) {
+				throw Common::Exception() << "can't split size " << size << " into " << parts << " parts";
+			}
+			// a neighbor has to be able to fill all of our ghost layers from its interior
+			if ((parts[i] > 1 || periodic[i]) && size[i] / parts[i] < ghost[i]) {
+				throw Common::Exception() << "blocks of size " << (size / parts) << " are thinner than the ghost layers " << ghost;
+			}
+		}
+	}
+
+	// splits into 'count' blocks, picking the parts per axis with the least total cut area
+	DomainDecomposition(intN const & size_, int count, intN const & ghost_, std::array<bool, rank> const & periodic_ = {})
+	: DomainDecomposition(size_, chooseParts(size_, count), ghost_, periodic_) {}
+
+	static intN chooseParts(intN const & size, int count) {
+		intN best, parts;
+		double bestArea = -1;
+		auto search = [&](auto && search, int axis, int left) -> void {
+			if (axis == rank - 1) {
+				parts[axis] = left;
+				for (int i = 0; i < rank; ++i) {
+					if (parts[i] > std::max(1, size[i])) return;
+				}
+				double area = 0;
+				for (int i = 0; i < rank; ++i) {
+					double face = parts[i] - 1;
+					for (int j = 0; j < rank; ++j) {
+						if (j != i) face *= size[j];
+					}
+					area += face;
+				}
+				if (bestArea < 0 || area < bestArea) {
+					bestArea = area;
+					best = parts;
+				}
+				return;
+			}
+			for (int p = 1; p <= left; ++p) {
+				if (left % p) continue;
+				parts[axis] = p;
+				search(search, axis + 1, left / p);
+			}
+		};
+		if (count < 1) throw Common::Exception() << "can't split into " << count << " blocks";
+		search(search, 0, count);
+		if (bestArea < 0) throw Common::Exception() << "can't split size " << size << " into " << count << " blocks";
+		return best;
+	}
+
+	int count() const { return parts.product(); }
+
+	intN blockOf(int id) const {
+		intN b;
+		for (int i = 0; i < rank; ++i) {
+			b[i] = id % parts[i];
+			id /= parts[i];
+		}
+		return b;
+	}
+
+	int idOf(intN const & b) const {
+		return b.dot(stepForSize(parts));
+	}
+
+	// as even as possible: block sizes differ by at most one along each axis
+	intN blockMin(int id) const {
+		auto const b = blockOf(id);
+		intN min;
+		for (int i = 0; i < rank; ++i) {
+			min[i] = (int)((long)size[i] * b[i] / parts[i]);
+		}
+		return min;
+	}
+
+	intN blockMax(int id) const {
+		return blockMin(id) + blockSize(id);
+	}
+
+	intN blockSize(int id) const {
+		auto const b = blockOf(id);
+		intN n;
+		for (int i = 0; i < rank; ++i) {
+			n[i] = (int)((long)size[i] * (b[i] + 1) / parts[i] - (long)size[i] * b[i] / parts[i]);
+		}
+		return n;
+	}
+
+	// the block on side 'side' (0 = low, 1 = high) along 'axis', or -1 at the edge of a non-periodic axis
+	int neighbor(int id, int axis, int side) const {
+		auto b = blockOf(id);
+		b[axis] += side ? 1 : -1;
+		if (b[axis] < 0 || b[axis] >= parts[axis]) {
+			if (!periodic[axis]) return -1;
+			b[axis] = (b[axis] + parts[axis]) % parts[axis];
+		}
+		return idOf(b);
+	}
+
+	/*
+	block 'id's data, uninitialized
+	'boundary' fills the ghosts at the edges of the whole domain along non-periodic axes, so it can't be GhostFill::Periodic.
+	periodic axes wrap around through the transport instead.
+	*/
+	template<typename Type, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+	Subdomain<Type, rank, Allocator> subdomain(
+		int id,
+		GhostBoundary<Type> const & boundary = {GhostFill::Constant},
+		Allocator const & alloc = {}
+	) const {
+		if (id < 0 || id >= count()) throw Common::Exception() << "block " << id << " is out of range, there are " << count();
+		bool anyEdge = false;
+		for (int i = 0; i < rank; ++i) {
+			anyEdge = anyEdge || !periodic[i];
+		}
+		if (anyEdge && boundary.fill == GhostFill::Periodic) {
+			throw Common::Exception() << "periodic boundaries go in the DomainDecomposition, not the subdomain's boundary";
+		}
+		Subdomain<Type, rank, Allocator> s;
+		s.id = id;
+		s.min = blockMin(id);
+		s.max = blockMax(id);
+		s.grid = GhostGrid<Type, rank, Allocator>(s.max - s.min, ghost, boundary, alloc);
+		return s;
+	}
+};
+
+/*
+fill the ghost layers of every subdomain in 'local' -- the ones this thread or process owns.
+every block of the decomposition has to be in some exchangeHalos() call at the same time, all with the same transport.
+axes go in order, and each axis sends the earlier axes' ghosts along with it, so the corners get filled too.
+*/
+template<typename Type, int rank, typename Allocator>
+void exchangeHalos(
+	DomainDecomposition<rank> const & d,
+	std::span<Subdomain<Type, rank, Allocator>> local,
+	HaloTransport & transport
+) {
+	static_assert(std::is_trivially_copyable_v<Type>, "halos are sent as bytes");
+	using intN = Tensor::intN<rank>;
+	std::vector<Type> buffer;
+
+	// the interior layers we send to side 'side', or the ghost layers we receive from it, in storage coordinates
+	auto faceBox = [&](GhostGrid<Type, rank, Allocator> const & g, int axis, int side, bool ghosts) {
+		auto box = g.ghostBox(axis);
+		int const w = g.ghost[axis];
+		int const n = g.size[axis];
+		int const first = ghosts
+			? (side ? n : -w)
+			: (side ? n - w : 0);
+		box.first[axis] = first + w;
+		box.second[axis] = first + 2 * w;
+		return box;
+	};
+	auto pack = [&](GhostGrid<Type, rank, Allocator> & g, std::pair<intN, intN> const & box) {
+		buffer.clear();
+		forEachGridRow(g.storage, box.first, box.second, [&](Type * p, int n, intN const &) {
+			buffer.insert(buffer.end(), p, p + n);
+		});
+	};
+	auto unpack = [&](GhostGrid<Type, rank, Allocator> & g, std::pair<intN, intN> const & box) {
+		Type const * q = buffer.data();
+		forEachGridRow(g.storage, box.first, box.second, [&](Type * p, int n, intN const &) {
+			std::copy(q, q + n, p);
+			q += n;
+		});
+	};
+
+	for (int axis = 0; axis < rank; ++axis) {
+		if (!d.ghost[axis]) continue;
+		// tag is the direction the message travels
+		for (auto & s : local) {
+			for (int side = 0; side < 2; ++side) {
+				int const to = d.neighbor(s.id, axis, side);
+				if (to < 0) continue;
+				pack(s.grid, faceBox(s.grid, axis, side, false));
+				transport.send(s.id, to, 2 * axis + side, buffer.data(), buffer.size() * sizeof(Type));
+			}
+		}
+		for (auto & s : local) {
+			for (int side = 0; side < 2; ++side) {
+				int const from = d.neighbor(s.id, axis, side);
+				if (from < 0) {
+					s.grid.fillGhosts(axis, side);
+					continue;
+				}
+				auto const box = faceBox(s.grid, axis, side, true);
+				buffer.resize((box.second - box.first).product());
+				transport.recv(from, s.id, 2 * axis + !side, buffer.data(), buffer.size() * sizeof(Type));
+				unpack(s.grid, box);
+			}
+		}
+	}
+}
+
+template<typename Type, int rank, typename Allocator>
+void exchangeHalos(
+	DomainDecomposition<rank> const & d,
+	Subdomain<Type, rank, Allocator> & local,
+	HaloTransport & transport
+) {
+	exchangeHalos(d, std::span<Subdomain<Type, rank, Allocator>>(&local, 1), transport);
+}
+
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+/*
+Grids with ghost (halo) layers around them, for stencil code
+so boundaries are filled by a policy instead of every stencil padding and copying edges by hand.
+
+GhostGrid keeps a plain Grid of size + 2 * ghost cells, and indexes it relative to the interior,
+so g(i) for i in [-ghost, size + ghost) is valid and [0, size) is the interior.
+*/
+
+#include "Tensor/Grid.h"
+#include "Tensor/Signature.h"
+#include "Common/Exception.h"
+#include <array>
+
+namespace Tensor {
+
+enum class GhostFill {
+	Periodic,	// wrap around to the other side
+	Constant,	// GhostBoundary::value
+	Extrapolate,	// linear, from the two cells nearest the edge
+	Reflect,	// mirrored about the edge, so ghost -1 is cell 0, -2 is cell 1, etc
+};
+
+template<typename Type>
+struct GhostBoundary {
+	GhostFill fill = GhostFill::Periodic;
+	Type value = {};	// for Constant
+};
+
+template<typename Type_, int rank_, typename Allocator_ = std::pmr::polymorphic_allocator<Type_>>
+struct GhostGrid {
+	using Type = Type_;
+	using value_type = Type;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	using Allocator = Allocator_;
+	using Storage = Grid<Type, rank, Allocator>;
+	using Boundary = GhostBoundary<Type>;
+
+	intN size;	// interior
+	intN ghost;	// layers on each side, per axis
+	Storage storage;	// size + 2 * ghost, interior starts at index 'ghost'
+
+	// [2 * axis + side], side 0 is the low end, 1 is the high end
+	std::array<Boundary, 2 * rank> boundary = {};
+
+	GhostGrid() {}
+
+	GhostGrid(intN const & size_, intN const & ghost_, Boundary const & boundary_ = {}, Allocator const & alloc = {})
+	:	size(size_),
+		ghost(ghost_),
+		storage(size_ + ghost_ * 2, alloc)
+	{
+		for (int i = 0; i < rank; ++i) {
+			if (size[i] < 0 || ghost[i] < 0) throw Common::Exception() << "bad size " << size << " or ghost width " << ghost;
+		}
+		boundary.fill(boundary_);
+	}
+
+	Type & operator()(intN const & i) { return storage(i + ghost); }
+	Type const & operator()(intN const & i) const { return storage(i + ghost); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type & operator()(int first, Rest... rest) { return (*this)(indexOf(first, rest...)); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type const & operator()(int first, Rest... rest) const { return (*this)(indexOf(first, rest...)); }
+
+	template<typename... Rest>
+	static intN indexOf(int first, Rest... rest) {
+		std::array<int, rank> const a = {first, (int)rest...};
+		intN i;
+		for (int j = 0; j < rank; ++j) {
+			i[j] = a[j];
+		}
+		return i;
+	}
+
+	// interior indexes
+	RangeObj<rank> range() const {
+		return RangeObj<rank>(intN(), size);
+	}
+
+	// the interior, as a view into the storage
+	GridView<Type, rank> interior() { return storage.view().slice(ghost, ghost + size); }
+	GridView<Type const, rank> interior() const { return storage.view().slice(ghost, ghost + size); }
+
+	// everything, ghosts included.  index 0 of this is ghost cell -ghost.
+	GridView<Type, rank> view() { return storage.view(); }
+	GridView<Type const, rank> view() const { return storage.view(); }
+
+	/*
+	cursors over the interior, with neighbor<axis, delta>() unchecked for |delta| <= border
+	cursor.index is in storage coordinates, so the interior index is cursor.index - ghost
+	*/
+	template<int border> requires (border >= 0)
+	GridCursorRange<Storage, border> interiorRange() {
+		checkBorder(border);
+		return {&storage, ghost, ghost + size};
+	}
+	template<int border> requires (border >= 0)
+	GridCursorRange<Storage const, border> interiorRange() const {
+		checkBorder(border);
+		return {&storage, ghost, ghost + size};
+	}
+
+	void checkBorder(int border) const {
+		for (int i = 0; i < rank; ++i) {
+			if (border > ghost[i]) throw Common::Exception() << "stencil border " << border << " is wider than the ghost layers " << ghost;
+		}
+	}
+
+	void setBoundary(int axis, Boundary const & b) {
+		boundary[2 * axis] = b;
+		boundary[2 * axis + 1] = b;
+	}
+
+	void setBoundary(int axis, int side, Boundary const & b) {
+		boundary[2 * axis + side] = b;
+	}
+
+	/*
+	the box, in storage coordinates, that axis 'axis' ghost layers span across the other axes
+	earlier axes include their ghosts and later axes don't, so filling axes in order fills the corners too.
+	*/
+	std::pair<intN, intN> ghostBox(int axis) const {
+		intN min, max = storage.size;
+		for (int i = axis + 1; i < rank; ++i) {
+			min[i] = ghost[i];
+			max[i] = ghost[i] + size[i];
+		}
+		return {min, max};
+	}
+
+	// fill every ghost cell from the boundary policies
+	void fillGhosts() {
+		for (int axis = 0; axis < rank; ++axis) {
+			fillGhosts(axis, 0);
+			fillGhosts(axis, 1);
+		}
+	}
+
+	// fill one side's ghost layers.  axes before 'axis' should be filled already for the corners to come out right.
+	void fillGhosts(int axis, int side) {
+		int const g = ghost[axis];
+		int const n = size[axis];
+		if (!g || !n) return;
+		auto const & b = boundary[2 * axis + side];
+		int const stride = storage.step[axis];
+		auto [min, max] = ghostBox(axis);
+		for (int k = 0; k < g; ++k) {
+			// interior-relative index of this ghost layer
+			int const j = side ? n + k : -1 - k;
+			min[axis] = j + g;
+			max[axis] = min[axis] + 1;
+			switch (b.fill) {
+			case GhostFill::Constant:
+				forEachGridRow(storage, min, max, [&](Type * p, int m, intN const &) {
+					std::fill(p, p + m, b.value);
+				});
+				break;
+			case GhostFill::Periodic:
+			case GhostFill::Reflect: {
+				int src;
+				if (b.fill == GhostFill::Periodic) {
+					src = (j % n + n) % n;
+				} else {
+					int const m = (j % (2 * n) + 2 * n) % (2 * n);
+					src = m < n ? m : 2 * n - 1 - m;
+				}
+				forEachGridRow(storage, min, max, [&](Type * p, int m, intN const &) {
+					Type const * q = p + (src - j) * stride;
+					std::copy(q, q + m, p);
+				});
+				break;
+			}
+			case GhostFill::Extrapolate: {
+				int const edge = side ? n - 1 : 0;
+				int const inner = n > 1 ? (side ? n - 2 : 1) : edge;
+				auto const dist = (StorageScalar<Type>)(k + 1);
+				forEachGridRow(storage, min, max, [&](Type * p, int m, intN const &) {
+					Type const * q0 = p + (edge - j) * stride;
+					Type const * q1 = p + (inner - j) * stride;
+					for (int i = 0; i < m; ++i) {
+						p[i] = q0[i] + (q0[i] - q1[i]) * dist;
+					}
+				});
+				break;
+			}
+			}
+		}
+	}
+};
+
+}
@@ -0,0 +1,471 @@
+#pragma once
+
+#include "Tensor/Grid.h"
+#include "Tensor/Signature.h"
+#include "Tensor/Checksum.h"
+#include "Tensor/Compression.h"
+#include "Tensor/ThreadPool.h"
+#include "Common/Exception.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+binary Grid and tensor files
+
+layout:
+	fixed header (GridIOHeader below)
+	size[rank] as int64, fastest axis first
+	signature length as uint32, then the storageSignature<Type>() chars
+	(version 2+) codec as uint32, error bound as double
+	data in chunks of chunkCells cells (the last one may be short), in Grid memory order (index 0 fastest)
+		with a codec, each chunk is its compressed size as uint32 and then the compressed bytes (see ChunkCodec in Compression.h)
+		each chunk followed by its crc32 (of what's on disk) if the checksum flag is set
+
+only stored elements are written, i.e. a Grid<sym4<float>> is 10 floats a cell, not 16.
+everything is written in native byte order along with endianTag, and a reader on the other endianness swaps on the way in.
+
+	writeGrid("rho.tgrid", g);
+	auto g = readGrid<float3s3, 3>("rho.tgrid");
+	readGridInto("rho.tgrid", m.grid());	// into something preallocated, like a MappedGrid
+
+compression is per field, and runs across chunks in parallel on the pool:
+	writeGrid("sigma.tgrid", sigma, {.codec = GridCodec::Shuffle});	// lossless
+	writeGrid("rho.tgrid", rho, {.codec = GridCodec::Lorenzo, .errorBound = 1e-6});	// every value within 1e-6
+*/
+
+namespace Tensor {
+
+struct GridIOHeader {
+	static constexpr char magicValue[8] = {'T', 'N', 'S', 'R', 'G', 'I', 'O', 0};
+	static constexpr uint32_t currentVersion = 2;
+	static constexpr uint32_t flagChecksums = 1;
+
+	char magic[8] = {};
+	uint32_t version = {};
+	uint32_t endian = {};
+	uint32_t rank = {};
+	uint32_t flags = {};
+	uint32_t scalarBytes = {};	// for byte-swapping
+	uint32_t cellBytes = {};
+	uint64_t chunkCells = {};
+};
+static_assert(sizeof(GridIOHeader) == 40);
+
+struct GridWriteOptions {
+	bool checksums = true;
+	size_t chunkBytes = 1 << 20;	// rounded down to whole cells
+	GridCodec codec = GridCodec::None;
+	double errorBound = {};	// absolute, for GridCodec::Lorenzo
+	ThreadPool * pool = &ThreadPool::get();	// for compressing and decompressing chunks
+};
+
+// what readGridInfo() found in a file's header
+struct GridFileInfo {
+	uint32_t version = {};
+	int rank = {};
+	std::vector<int64_t> size;
+	std::string signature;
+	uint32_t scalarBytes = {};
+	uint32_t cellBytes = {};
+	uint64_t chunkCells = {};
+	bool checksums = {};
+	bool swapped = {};	// written on the other endianness
+	GridCodec codec = GridCodec::None;
+	double errorBound = {};
+
+	int64_t cellCount() const {
+		int64_t n = 1;
+		for (auto s : size) n *= s;
+		return n;
+	}
+};
+
+namespace GridIODetail {
+
+template<typename T>
+T byteSwap(T x) {
+	static_assert(std::is_trivially_copyable_v<T>);
+	char b[sizeof(T)];
+	std::memcpy(b, &x, sizeof(T));
+	std::reverse(b, b + sizeof(T));
+	std::memcpy(&x, b, sizeof(T));
+	return x;
+}
+
+// swap every 'width'-byte word in place
+inline void byteSwapWords(char * p, size_t n, uint32_t width) {
+	if (width <= 1) return;
+	for (size_t i = 0; i + width <= n; i += width) {
+		std::reverse(p + i, p + i + width);
+	}
+}
+
+inline void writeBytes(std::ostream & o, void const * p, size_t n) {
+	o.write((char const *)p, (std::streamsize)n);
+	if (!o) throw Common::Exception() << "failed to write " << n << " bytes";
+}
+
+inline void readBytes(std::istream & i, void * p, size_t n) {
+	i.read((char*)p, (std::streamsize)n);
+	if ((size_t)i.gcount() != n) throw Common::Exception() << "unexpected end of file, wanted " << n << " bytes but got " << i.gcount();
+}
+
+template<typename Type>
+void writeHeader(std::ostream & o, int rank, int64_t const * size, uint64_t chunkCells, GridWriteOptions const & options) {
+	using Scalar = StorageScalar<Type>;
+	static_assert(std::is_trivially_copyable_v<Type>, "binary I/O needs trivially copyable cells");
+	static_assert(sizeof(Type) == storedScalarCount<Type>() * sizeof(Scalar), "cell type has padding");
+
+	GridIOHeader h;
+	std::memcpy(h.magic, GridIOHeader::magicValue, sizeof(h.magic));
+	h.version = GridIOHeader::currentVersion;
+	h.endian = endianTag;
+	h.rank = rank;
+	h.flags = options.checksums ? GridIOHeader::flagChecksums : 0;
+	h.scalarBytes = sizeof(Scalar);
+	h.cellBytes = sizeof(Type);
+	h.chunkCells = chunkCells;
+	writeBytes(o, &h, sizeof(h));
+	writeBytes(o, size, sizeof(int64_t) * rank);
+	std::string const sig = storageSignature<Type>();
+	uint32_t const sigLen = (uint32_t)sig.size();
+	writeBytes(o, &sigLen, sizeof(sigLen));
+	writeBytes(o, sig.data(), sig.size());
+	uint32_t const codec = (uint32_t)options.codec;
+	writeBytes(o, &codec, sizeof(codec));
+	writeBytes(o, &options.errorBound, sizeof(options.errorBound));
+}
+
+template<typename Type>
+ChunkCodec chunkCodecFor(GridCodec codec, double errorBound) {
+	using Scalar = StorageScalar<Type>;
+	if (codec == GridCodec::Lorenzo && !std::is_floating_point_v<Scalar>) {
+		throw Common::Exception() << "GridCodec::Lorenzo is for floating-point fields, not " << storageSignature<Type>();
+	}
+	if (codec == GridCodec::Lorenzo && !(errorBound > 0)) {
+		throw Common::Exception() << "GridCodec::Lorenzo needs a positive errorBound, got " << errorBound;
+	}
+	return ChunkCodec{codec, errorBound, (uint32_t)sizeof(Scalar), storedScalarCount<Type>(), std::is_floating_point_v<Scalar>};
+}
+
+// how many chunks to (de)compress at once
+inline int chunkBatchSize(GridCodec codec, ThreadPool const & pool) {
+	return codec == GridCodec::None ? 1 : 2 * pool.numThreads();
+}
+
+/*
+the data part of the file, shared by grids and single tensors
+forEachRun(run) calls run(Type const * p, int n, int stride) for each run of cells, in file order
+chunks are gathered a batch at a time so a codec can compress the batch in parallel
+*/
+template<typename Type, typename ForEachRun>
+void writeChunks(std::ostream & o, uint64_t chunkCells, GridWriteOptions const & options, ForEachRun && forEachRun) {
+	size_t const chunkBytes = chunkCells * sizeof(Type);
+	auto const codec = chunkCodecFor<Type>(options.codec, options.errorBound);
+	ThreadPool & pool = *options.pool;
+	int const batchSize = chunkBatchSize(options.codec, pool);
+	std::vector<std::vector<char>> chunks(batchSize);
+	std::vector<std::vector<uint8_t>> packed(batchSize);
+	int count = 0;	// full chunks so far.  chunks[count] is the one being filled.
+
+	auto writeChunk = [&](void const * p, size_t n) {
+		if (options.codec != GridCodec::None) {
+			uint32_t const len = (uint32_t)n;
+			writeBytes(o, &len, sizeof(len));
+		}
+		writeBytes(o, p, n);
+		if (options.checksums) {
+			uint32_t const c = crc32(p, n);
+			writeBytes(o, &c, sizeof(c));
+		}
+	};
+	auto flush = [&]() {
+		if (options.codec == GridCodec::None) {
+			for (int k = 0; k < count; ++k) writeChunk(chunks[k].data(), chunks[k].size());
+		} else {
+			pool.parallelFor(count, [&](int k) {
+				packed[k] = codec.compress((uint8_t const *)chunks[k].data(), chunks[k].size());
+			});
+			for (int k = 0; k < count; ++k) writeChunk(packed[k].data(), packed[k].size());
+		}
+		for (int k = 0; k < count; ++k) chunks[k].clear();
+		count = 0;
+	};
+
+	forEachRun([&](Type const * p, int n, int stride) {
+		for (int k = 0; k < n;) {
+			auto & chunk = chunks[count];
+			if (chunk.capacity() < chunkBytes) chunk.reserve(chunkBytes);
+			size_t const room = (chunkBytes - chunk.size()) / sizeof(Type);
+			int const m = (int)std::min<size_t>(room, (size_t)(n - k));
+			size_t const at = chunk.size();
+			chunk.resize(at + m * sizeof(Type));
+			if (stride == 1) {
+				std::memcpy(chunk.data() + at, (void const *)(p + k), m * sizeof(Type));
+			} else {
+				for (int j = 0; j < m; ++j) {
+					std::memcpy(chunk.data() + at + j * sizeof(Type), (void const *)(p + (k + j) * stride), sizeof(Type));
+				}
+			}
+			k += m;
+			if (chunk.size() == chunkBytes && ++count == batchSize) flush();
+		}
+	});
+	if (!chunks[count].empty()) ++count;
+	flush();
+}
+
+template<typename Type, typename ForEachRun>
+void readChunks(std::istream & i, GridFileInfo const & info, ThreadPool & pool, ForEachRun && forEachRun) {
+	auto const codec = chunkCodecFor<Type>(info.codec, info.errorBound);
+	int const batchSize = chunkBatchSize(info.codec, pool);
+	std::vector<std::vector<char>> chunks(batchSize);
+	std::vector<std::vector<uint8_t>> packed(batchSize);
+	int64_t remaining = info.cellCount();
+	int available = 0;
+	int current = 0;
+	size_t used = 0;
+
+	auto readChunk = [&](void * p, size_t n) {
+		readBytes(i, p, n);
+		if (info.checksums) {
+			uint32_t c;
+			readBytes(i, &c, sizeof(c));
+			if (info.swapped) c = byteSwap(c);
+			// the crc is of the bytes as written, so check before swapping
+			if (c != crc32(p, n)) throw Common::Exception() << "checksum mismatch";
+		}
+	};
+	auto fillBatch = [&]() {
+		int n = 0;
+		for (; n < batchSize && remaining > 0; ++n) {
+			size_t const cells = (size_t)std::min<int64_t>(remaining, (int64_t)info.chunkCells);
+			size_t const rawBytes = cells * sizeof(Type);
+			chunks[n].resize(rawBytes);
+			if (info.codec == GridCodec::None) {
+				readChunk(chunks[n].data(), rawBytes);
+			} else {
+				uint32_t len;
+				readBytes(i, &len, sizeof(len));
+				if (info.swapped) len = byteSwap(len);
+				// no codec output is ever this big, so don't let a corrupt length allocate the world
+				if (len > lzMaxCompressedSize(2 * rawBytes) + 8) throw Common::Exception() << "bad compressed chunk size " << len;
+				packed[n].resize(len);
+				readChunk(packed[n].data(), len);
+			}
+			remaining -= (int64_t)cells;
+		}
+		if (info.codec != GridCodec::None) {
+			pool.parallelFor(n, [&](int k) {
+				codec.decompress(packed[k].data(), packed[k].size(), (uint8_t*)chunks[k].data(), chunks[k].size(), info.swapped);
+			});
+		}
+		// Lorenzo decodes straight to native order
+		if (info.swapped && info.codec != GridCodec::Lorenzo) {
+			for (int k = 0; k < n; ++k) byteSwapWords(chunks[k].data(), chunks[k].size(), info.scalarBytes);
+		}
+		available = n;
+		current = 0;
+		used = 0;
+	};
+	auto nextChunk = [&]() -> std::vector<char> & {
+		while (current < available && used == chunks[current].size()) {
+			++current;
+			used = 0;
+		}
+		if (current == available) {
+			fillBatch();
+			if (!available) throw Common::Exception() << "ran out of chunks";
+		}
+		return chunks[current];
+	};
+
+	forEachRun([&](Type * p, int n, int stride) {
+		for (int k = 0; k < n;) {
+			auto const & chunk = nextChunk();
+			int const m = (int)std::min<size_t>((chunk.size() - used) / sizeof(Type), (size_t)(n - k));
+			if (stride == 1) {
+				std::memcpy((void*)(p + k), chunk.data() + used, m * sizeof(Type));
+			} else {
+				for (int j = 0; j < m; ++j) {
+					std::memcpy((void*)(p + (k + j) * stride), chunk.data() + used + j * sizeof(Type), sizeof(Type));
+				}
+			}
+			used += m * sizeof(Type);
+			k += m;
+		}
+	});
+}
+
+template<typename Type>
+void checkInfo(GridFileInfo const & info, int rank) {
+	if (info.rank != rank) throw Common::Exception() << "file has rank " << info.rank << " but we expected " << rank;
+	if (info.cellBytes != sizeof(Type)) throw Common::Exception() << "file has " << info.cellBytes << " bytes per cell but we expected " << sizeof(Type);
+	std::string const sig = storageSignature<Type>();
+	if (info.signature != sig) throw Common::Exception() << "file holds '" << info.signature << "' but we expected '" << sig << "'";
+}
+
+template<typename G>
+void readGridData(std::istream & i, GridFileInfo const & info, G & dst, ThreadPool & pool) {
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	using intN = Tensor::intN<rank>;
+	checkInfo<Type>(info, rank);
+	for (int j = 0; j < rank; ++j) {
+		if (info.size[j] != dst.size[j]) throw Common::Exception() << "file has size " << info.size[j] << " along axis " << j << " but the destination has " << dst.size[j];
+	}
+	readChunks<Type>(i, info, pool, [&](auto && run) {
+		forEachGridRow(dst, intN(), dst.size, [&](Type * p, int n, intN const &) {
+			run(p, n, dst.step[0]);
+		});
+	});
+}
+
+inline uint64_t chunkCellsFor(GridWriteOptions const & options, size_t cellBytes) {
+	return std::max<uint64_t>(1, options.chunkBytes / cellBytes);
+}
+
+}
+
+inline GridFileInfo readGridInfo(std::istream & i) {
+	using namespace GridIODetail;
+	GridIOHeader h;
+	readBytes(i, &h, sizeof(h));
+	if (std::memcmp(h.magic, GridIOHeader::magicValue, sizeof(h.magic))) throw Common::Exception() << "not a Tensor grid file";
+	GridFileInfo info;
+	if (h.endian == endianTagSwapped) {
+		info.swapped = true;
+		h.version = byteSwap(h.version);
+		h.rank = byteSwap(h.rank);
+		h.flags = byteSwap(h.flags);
+		h.scalarBytes = byteSwap(h.scalarBytes);
+		h.cellBytes = byteSwap(h.cellBytes);
+		h.chunkCells = byteSwap(h.chunkCells);
+	} else if (h.endian != endianTag) {
+		throw Common::Exception() << "bad endian tag";
+	}
+	if (h.version > GridIOHeader::currentVersion) throw Common::Exception() << "file is version " << h.version << " but we only know up to " << GridIOHeader::currentVersion;
+	if (h.rank > 64) throw Common::Exception() << "bad rank " << h.rank;
+	if (h.chunkCells == 0) throw Common::Exception() << "bad chunk size";
+	info.version = h.version;
+	info.rank = (int)h.rank;
+	info.scalarBytes = h.scalarBytes;
+	info.cellBytes = h.cellBytes;
+	info.chunkCells = h.chunkCells;
+	info.checksums = h.flags & GridIOHeader::flagChecksums;
+
+	info.size.resize(info.rank);
+	readBytes(i, info.size.data(), sizeof(int64_t) * info.rank);
+	if (info.swapped) {
+		for (auto & s : info.size) s = byteSwap(s);
+	}
+	for (auto s : info.size) {
+		if (s < 0) throw Common::Exception() << "bad size " << s;
+	}
+	uint32_t sigLen;
+	readBytes(i, &sigLen, sizeof(sigLen));
+	if (info.swapped) sigLen = byteSwap(sigLen);
+	if (sigLen > 4096) throw Common::Exception() << "bad signature length " << sigLen;
+	info.signature.resize(sigLen);
+	readBytes(i, info.signature.data(), sigLen);
+	if (info.version >= 2) {
+		uint32_t codec;
+		readBytes(i, &codec, sizeof(codec));
+		readBytes(i, &info.errorBound, sizeof(info.errorBound));
+		if (info.swapped) {
+			codec = byteSwap(codec);
+			info.errorBound = byteSwap(info.errorBound);
+		}
+		if (codec > (uint32_t)GridCodec::Lorenzo) throw Common::Exception() << "unknown codec " << codec;
+		info.codec = (GridCodec)codec;
+	}
+	return info;
+}
+
+// G is a Grid or GridView.  views are written in their own index order.
+template<typename G>
+void writeGrid(std::ostream & o, G const & g, GridWriteOptions const & options = {}) {
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	using intN = Tensor::intN<rank>;
+	int64_t size[rank];
+	for (int j = 0; j < rank; ++j) {
+		size[j] = g.size[j];
+	}
+	uint64_t const chunkCells = GridIODetail::chunkCellsFor(options, sizeof(Type));
+	GridIODetail::writeHeader<Type>(o, rank, size, chunkCells, options);
+	GridIODetail::writeChunks<Type>(o, chunkCells, options, [&](auto && run) {
+		forEachGridRow(g, intN(), g.size, [&](Type const * p, int n, intN const &) {
+			run(p, n, g.step[0]);
+		});
+	});
+}
+
+// reads into dst, which must already be the right size, i.e. a preallocated Grid, a GridView, or a MappedGrid's grid()
+template<typename G>
+void readGridInto(std::istream & i, G && dst, ThreadPool & pool = ThreadPool::get()) {
+	GridIODetail::readGridData(i, readGridInfo(i), dst, pool);
+}
+
+template<typename Type, int rank, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+Grid<Type, rank, Allocator> readGrid(std::istream & i, Allocator const & alloc = {}, ThreadPool & pool = ThreadPool::get()) {
+	auto const info = readGridInfo(i);
+	GridIODetail::checkInfo<Type>(info, rank);
+	intN<rank> size;
+	for (int j = 0; j < rank; ++j) {
+		if (info.size[j] > std::numeric_limits<int>::max()) throw Common::Exception() << "size " << info.size[j] << " is too big for a Grid";
+		size[j] = (int)info.size[j];
+	}
+	auto g = Grid<Type, rank, Allocator>(size, alloc);
+	GridIODetail::readGridData(i, info, g, pool);
+	return g;
+}
+
+// single tensors (or scalars) are written as rank-0 grids
+template<typename T>
+void writeTensor(std::ostream & o, T const & t, GridWriteOptions const & options = {}) {
+	GridIODetail::writeHeader<T>(o, 0, nullptr, 1, options);
+	GridIODetail::writeChunks<T>(o, 1, options, [&](auto && run) { run(&t, 1, 1); });
+}
+
+template<typename T>
+T readTensor(std::istream & i) {
+	auto const info = readGridInfo(i);
+	GridIODetail::checkInfo<T>(info, 0);
+	T t;
+	GridIODetail::readChunks<T>(i, info, ThreadPool::get(), [&](auto && run) { run(&t, 1, 1); });
+	return t;
+}
+
+// file versions
+
+template<typename G>
+void writeGrid(std::string const & path, G const & g, GridWriteOptions const & options = {}) {
+	std::ofstream o(path, std::ios::binary);
+	if (!o) throw Common::Exception() << "failed to open " << path << " for writing";
+	writeGrid(o, g, options);
+}
+
+template<typename G>
+void readGridInto(std::string const & path, G && dst, ThreadPool & pool = ThreadPool::get()) {
+	std::ifstream i(path, std::ios::binary);
+	if (!i) throw Common::Exception() << "failed to open " << path;
+	readGridInto(i, std::forward<G>(dst), pool);
+}
+
+template<typename Type, int rank, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+Grid<Type, rank, Allocator> readGrid(std::string const & path, Allocator const & alloc = {}, ThreadPool & pool = ThreadPool::get()) {
+	std::ifstream i(path, std::ios::binary);
+	if (!i) throw Common::Exception() << "failed to open " << path;
+	return readGrid<Type, rank, Allocator>(i, alloc, pool);
+}
+
+}
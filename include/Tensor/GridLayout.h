@@ -0,0 +1,471 @@
+#pragma once
+
+/*
+grids with other memory layouts than Grid's lexicographic one
+
+in a lexicographic 3D grid, neighbors along the slowest axis are a whole layer apart,
+so stencils touch as many pages as they have planes.
+Morton (Z-order) and tiled (bricks of tile^rank cells) layouts keep neighbors in every direction close together.
+
+each layout here is separable: the offset of index i is table[0][i[0]] + table[1][i[1]] + ...
+so lookup is rank adds, whatever the layout.
+layouts can pad the storage (Morton up to powers of two per axis, tiled up to whole tiles).
+padding cells exist in memory but never show up in range() or forEach().
+
+layouts also know their memory order:
+	decode(o) is the index at offset o (maybe a padding index, outside size)
+	advance(o, i) moves to offset o+1 and its index
+	skip(o, i) is called when i is a padding index, and moves past as much padding as it can
+	forEachRun(begin, end, f) calls f(o, n, i) for each run of n in-bounds cells at offsets o.. that step along axis 0,
+		for begin and end multiples of blockCells (or end = storageSize).  this is what forEach() uses.
+*/
+
+#include "Tensor/Grid.h"
+#include "Tensor/ThreadPool.h"
+#include "Common/Exception.h"
+#include <array>
+#include <bit>
+#include <vector>
+
+namespace Tensor {
+
+template<int rank_>
+struct SeparableLayout {
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+
+	intN size;
+	int storageSize = {};
+	std::array<std::vector<int>, rank> table;
+
+	SeparableLayout() {}
+	SeparableLayout(intN const & size_) : size(size_) {
+		for (int j = 0; j < rank; ++j) {
+			if (size[j] < 0) throw Common::Exception() << "bad size " << size;
+			table[j].resize(size[j]);
+		}
+	}
+
+	int offset(intN const & i) const {
+		int o = 0;
+		for (int j = 0; j < rank; ++j) {
+			o += table[j][i[j]];
+		}
+		return o;
+	}
+
+	bool inBounds(intN const & i) const {
+		for (int j = 0; j < rank; ++j) {
+			if (i[j] >= size[j]) return false;
+		}
+		return true;
+	}
+};
+
+// same as Grid, for comparison and for code that's templated on the layout
+template<int rank_>
+struct LinearLayout : public SeparableLayout<rank_> {
+	using Super = SeparableLayout<rank_>;
+	using Super::rank;
+	using typename Super::intN;
+	using Super::size;
+	using Super::table;
+
+	LinearLayout() {}
+	LinearLayout(intN const & size_) : Super(size_) {
+		auto const step = stepForSize(size);
+		for (int j = 0; j < rank; ++j) {
+			for (int x = 0; x < size[j]; ++x) table[j][x] = x * step[j];
+		}
+		Super::storageSize = size.product();
+	}
+
+	intN decode(int o) const {
+		intN i;
+		for (int j = 0; j < rank; ++j) {
+			i[j] = o % size[j];
+			o /= size[j];
+		}
+		return i;
+	}
+
+	void advance(int & o, intN & i) const {
+		++o;
+		for (int j = 0; j < rank-1; ++j) {
+			if (++i[j] < size[j]) return;
+			i[j] = 0;
+		}
+		++i[rank-1];
+	}
+
+	void skip(int & o, intN & i) const { advance(o, i); }
+
+	int blockCells() const { return std::max(1, size[0]); }
+
+	template<typename F>
+	void forEachRun(int begin, int end, F && f) const {
+		if (Super::storageSize <= 0) return;
+		for (int o = begin; o < end; o += size[0]) {
+			f(o, size[0], decode(o));
+		}
+	}
+};
+
+/*
+bit b of axis j goes wherever it lands when you interleave the bits of each axis, lowest first,
+with axes that have run out of bits dropping out.  so 8x8x8 is plain Morton, and 4x16 is Morton for the first 4x4 then rows of those.
+each axis is padded to a power of two.
+*/
+template<int rank_>
+struct MortonLayout : public SeparableLayout<rank_> {
+	using Super = SeparableLayout<rank_>;
+	using Super::rank;
+	using typename Super::intN;
+	using Super::size;
+	using Super::table;
+
+	int totalBits = {};
+	std::vector<int> axisOfBit, bitOfBit;	// which axis and which of its bits each bit of the offset is
+	std::vector<intN> lowBits;	// how many of each axis' bits are below each bit of the offset
+
+	MortonLayout() {}
+	MortonLayout(intN const & size_) : Super(size_) {
+		if (size.product() <= 0) return;
+		intN bits;
+		int maxBits = 0;
+		for (int j = 0; j < rank; ++j) {
+			bits[j] = std::bit_width((unsigned)size[j] - 1);
+			maxBits = std::max(maxBits, bits[j]);
+		}
+		if (bits.sum() > 30) throw Common::Exception() << "size " << size << " is too big for a Morton layout";
+		intN count;
+		for (int b = 0; b < maxBits; ++b) {
+			for (int j = 0; j < rank; ++j) {
+				if (b >= bits[j]) continue;
+				lowBits.push_back(count);
+				axisOfBit.push_back(j);
+				bitOfBit.push_back(b);
+				++count[j];
+			}
+		}
+		totalBits = (int)axisOfBit.size();
+		for (int j = 0; j < rank; ++j) {
+			for (int x = 0; x < size[j]; ++x) {
+				int o = 0;
+				for (int p = 0; p < totalBits; ++p) {
+					if (axisOfBit[p] == j && (x >> bitOfBit[p] & 1)) o |= 1 << p;
+				}
+				table[j][x] = o;
+			}
+		}
+		Super::storageSize = 1 << totalBits;
+	}
+
+	intN decode(int o) const {
+		intN i;
+		for (int p = 0; p < totalBits; ++p) {
+			if (o >> p & 1) i[axisOfBit[p]] |= 1 << bitOfBit[p];
+		}
+		return i;
+	}
+
+	// o+1 clears the trailing ones of o and sets the next bit up, so only those bits' axes change
+	void advance(int & o, intN & i) const {
+		int const p = std::countr_one((unsigned)o);
+		++o;
+		if (p >= totalBits) return;
+		for (int j = 0; j < rank; ++j) {
+			i[j] &= ~((1 << lowBits[p][j]) - 1);
+		}
+		i[axisOfBit[p]] |= 1 << bitOfBit[p];
+	}
+
+	/*
+	the offsets [o, o + lowest set bit of o) are an aligned block, and i is its lowest corner.
+	so if i is out of bounds, so is the whole block.
+	*/
+	void skip(int & o, intN & i) const {
+		o = o ? o + (o & -o) : Super::storageSize;
+		if (o < Super::storageSize) i = decode(o);
+	}
+
+	int blockCells() const { return 1; }
+
+	// consecutive offsets only step along axis 0 for one bit, so this is one cell at a time
+	template<typename F>
+	void forEachRun(int begin, int end, F && f) const {
+		if (begin >= end) return;
+		intN i = decode(begin);
+		for (int o = begin; o < end;) {
+			if (Super::inBounds(i)) {
+				f(o, 1, i);
+				advance(o, i);
+			} else {
+				skip(o, i);
+			}
+		}
+	}
+};
+
+// bricks of tile^rank cells, each stored lexicographically, and the bricks stored lexicographically
+template<int rank_, int tile_ = 8>
+struct TiledLayout : public SeparableLayout<rank_> {
+	using Super = SeparableLayout<rank_>;
+	using Super::rank;
+	using typename Super::intN;
+	using Super::size;
+	using Super::table;
+	static constexpr int tile = tile_;
+	static_assert(tile > 0);
+
+	static constexpr int tileCells = [](){
+		int n = 1;
+		for (int j = 0; j < rank; ++j) n *= tile;
+		return n;
+	}();
+
+	intN tiles;	// how many along each axis
+
+	TiledLayout() {}
+	TiledLayout(intN const & size_) : Super(size_) {
+		for (int j = 0; j < rank; ++j) {
+			tiles[j] = (size[j] + tile - 1) / tile;
+		}
+		auto const tileStep = stepForSize(tiles);
+		int cellStep = 1;
+		for (int j = 0; j < rank; ++j) {
+			for (int x = 0; x < size[j]; ++x) {
+				table[j][x] = x / tile * tileStep[j] * tileCells + x % tile * cellStep;
+			}
+			cellStep *= tile;
+		}
+		Super::storageSize = tiles.product() * tileCells;
+	}
+
+	intN decode(int o) const {
+		int t = o / tileCells;
+		int w = o % tileCells;
+		intN i;
+		for (int j = 0; j < rank; ++j) {
+			i[j] = t % tiles[j] * tile + w % tile;
+			t /= tiles[j];
+			w /= tile;
+		}
+		return i;
+	}
+
+	void advance(int & o, intN & i) const {
+		++o;
+		if (o % tileCells == 0) {
+			if (o < Super::storageSize) i = decode(o);
+			return;
+		}
+		for (int j = 0; j < rank; ++j) {
+			if (++i[j] % tile) return;
+			i[j] -= tile;
+		}
+	}
+
+	void skip(int & o, intN & i) const { advance(o, i); }
+
+	int blockCells() const { return tileCells; }
+
+	// rows of each tile, clipped to the size
+	template<typename F>
+	void forEachRun(int begin, int end, F && f) const {
+		for (int t = begin / tileCells; t * tileCells < end; ++t) {
+			intN const corner = decode(t * tileCells);
+			intN extent;
+			for (int j = 0; j < rank; ++j) {
+				extent[j] = std::min(tile, size[j] - corner[j]);
+			}
+			intN w;
+			for (;;) {
+				int o = t * tileCells;
+				int cellStep = 1;
+				for (int j = 0; j < rank; ++j) {
+					o += w[j] * cellStep;
+					cellStep *= tile;
+				}
+				f(o, extent[0], corner + w);
+				int j = 1;
+				for (; j < rank; ++j) {
+					if (++w[j] < extent[j]) break;
+					w[j] = 0;
+				}
+				if (j >= rank) break;
+			}
+		}
+	}
+};
+
+// indexes in a layout's memory order, over offsets [begin, end)
+template<typename Layout>
+struct LayoutRange {
+	using intN = typename Layout::intN;
+
+	Layout const * layout = {};
+	int begin_ = {}, end_ = {};
+
+	struct iterator {
+		Layout const * layout = {};
+		int offset = {};
+		int end = {};
+		intN index;
+
+		iterator(Layout const * layout_, int offset_, int end_)
+		: layout(layout_), offset(offset_), end(end_) {
+			if (offset < end) {
+				index = layout->decode(offset);
+				settle();
+			}
+		}
+
+		// move to the next in-bounds index, if we're not on one
+		void settle() {
+			while (offset < end && !layout->inBounds(index)) {
+				layout->skip(offset, index);
+			}
+			if (offset > end) offset = end;
+		}
+
+		intN const & operator*() const { return index; }
+		intN const * operator->() const { return &index; }
+
+		iterator & operator++() {
+			layout->advance(offset, index);
+			settle();
+			return *this;
+		}
+
+		// all end iterators are at 'end', wherever advance() left their index
+		bool operator==(iterator const & o) const { return offset == o.offset; }
+		bool operator!=(iterator const & o) const { return !operator==(o); }
+	};
+
+	iterator begin() const { return iterator(layout, begin_, end_); }
+	iterator end() const { return iterator(layout, end_, end_); }
+};
+
+template<
+	typename Type_,
+	int rank_,
+	typename Layout_ = MortonLayout<rank_>,
+	typename Allocator_ = std::pmr::polymorphic_allocator<Type_>
+>
+struct LayoutGrid {
+	using Type = Type_;
+	using value_type = Type;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	using Layout = Layout_;
+	using Allocator = Allocator_;
+	static_assert(Layout::rank == rank);
+
+	intN size;
+	Layout layout;
+	std::vector<Type, Allocator> cells;	// includes any padding
+
+	LayoutGrid() {}
+
+	LayoutGrid(intN const & size_, Allocator const & alloc = {})
+	:	size(size_),
+		layout(size_),
+		cells(layout.storageSize, alloc)
+	{}
+
+	// f(intN index), called in memory order
+	template<typename F>
+	requires std::is_invocable_r_v<Type, F, intN>
+	LayoutGrid(intN const & size_, F && f, Allocator const & alloc = {})
+	: LayoutGrid(size_, alloc) {
+		forEach([&](intN const & i, Type & x) { x = f(i); });
+	}
+
+	Type & operator()(intN const & i) { return cells[offset(i)]; }
+	Type const & operator()(intN const & i) const { return cells[offset(i)]; }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type & operator()(int first, Rest... rest) { return (*this)(intN(first, rest...)); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type const & operator()(int first, Rest... rest) const { return (*this)(intN(first, rest...)); }
+
+	int offset(intN const & i) const {
+#ifdef DEBUG
+		for (int j = 0; j < rank; ++j) {
+			if (i[j] < 0 || i[j] >= size[j]) {
+				throw Common::Exception() << "size is " << size << " but dereference is " << i;
+			}
+		}
+#endif
+		return layout.offset(i);
+	}
+
+	// every index, in memory order
+	LayoutRange<Layout> range() const { return {&layout, 0, layout.storageSize}; }
+
+	// f(intN index, Type & cell) in memory order
+	template<typename F>
+	void forEach(F && f) {
+		forEachIn(0, layout.storageSize, f);
+	}
+
+	template<typename F>
+	void forEach(F && f) const {
+		forEachIn(0, layout.storageSize, f);
+	}
+
+	/*
+	same, in parallel over runs of storage of about gridSlabBytes
+	runs are whole layout blocks, and for Morton a power of two long, so each run is a compact box
+	the split only depends on the size and layout, not the number of threads
+	*/
+	template<typename F>
+	void parallelForEach(F && f, ThreadPool & pool = ThreadPool::get()) {
+		int const total = layout.storageSize;
+		int const block = layout.blockCells();
+		int const slabCells = (int)std::bit_floor((unsigned)std::max<size_t>(1, gridSlabBytes / sizeof(Type)));
+		int const run = std::max(1, slabCells / block) * block;
+		pool.parallelFor((total + run - 1) / run, [&](int r) {
+			forEachIn(r * run, std::min(total, (r + 1) * run), f);
+		});
+	}
+
+	template<typename F>
+	void forEachIn(int begin, int end, F && f) {
+		layout.forEachRun(begin, end, [&](int o, int n, intN i) {
+			for (int k = 0; k < n; ++k, ++i[0]) {
+				f(i, cells[o + k]);
+			}
+		});
+	}
+
+	template<typename F>
+	void forEachIn(int begin, int end, F && f) const {
+		layout.forEachRun(begin, end, [&](int o, int n, intN i) {
+			for (int k = 0; k < n; ++k, ++i[0]) {
+				f((intN const &)i, cells[o + k]);
+			}
+		});
+	}
+
+	// copy out to a lexicographic Grid
+	template<typename Alloc = std::pmr::polymorphic_allocator<Type>>
+	Grid<Type, rank, Alloc> copy(Alloc const & alloc = {}) const {
+		Grid<Type, rank, Alloc> g(size, alloc);
+		forEach([&](intN const & i, Type const & x) { g(i) = x; });
+		return g;
+	}
+
+	// copy in from a Grid or GridView of the same size
+	template<typename G>
+	void assign(G const & g) {
+		if (g.size != size) throw Common::Exception() << "can't assign a grid of size " << g.size << " to one of size " << size;
+		forEach([&](intN const & i, Type & x) { x = g(i); });
+	}
+};
+
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Tensor/Grid.h"
+#include "Tensor/ThreadPool.h"
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/*
+parallel Grid algorithms
+
+work is split along the slowest-varying axis (rank-1) into slabs of about gridSlabBytes each (see Grid.h).
+the split only depends on the grid size and sizeof(Type), never on the number of threads,
+and reductions combine the per-slab results in a fixed pairwise tree,
+so results are bit-identical no matter how many threads the pool has.
+
+G is anything with rank, Type, .size, .step and .v, i.e. Grid or GridView.
+the ones that write take G&& so you can pass a temporary view, like parallelFill(g.view().slice(a, b), x)
+*/
+
+namespace Tensor {
+
+// f(Type &) or f(intN index, Type &)
+template<typename G_, typename F>
+void parallelForEach(G_ && g, F && f, ThreadPool & pool = ThreadPool::get()) {
+	using G = std::remove_reference_t<G_>;
+	using intN = Tensor::intN<G::rank>;
+	forEachGridSlab(g, pool, [&](intN const & min, intN const & max) {
+		forEachGridRow(g, min, max, [&](auto * p, int n, intN index) {
+			int const s = g.step[0];
+			for (int k = 0; k < n; ++k, ++index[0]) {
+				if constexpr (std::is_invocable_v<F, intN const &, decltype(*p)>) {
+					f(index, p[k * s]);
+				} else {
+					f(p[k * s]);
+				}
+			}
+		});
+	});
+}
+
+template<typename G_>
+void parallelFill(G_ && g, typename std::remove_reference_t<G_>::value_type const & x, ThreadPool & pool = ThreadPool::get()) {
+	using G = std::remove_reference_t<G_>;
+	using intN = Tensor::intN<G::rank>;
+	forEachGridSlab(g, pool, [&](intN const & min, intN const & max) {
+		forEachGridRow(g, min, max, [&](auto * p, int n, intN const &) {
+			int const s = g.step[0];
+			if (s == 1) {
+				std::fill(p, p + n, x);
+			} else {
+				for (int k = 0; k < n; ++k) p[k * s] = x;
+			}
+		});
+	});
+}
+
+// dst(i) = f(src(i)) for all i.  dst and src must be the same size.
+template<typename D_, typename S, typename F>
+void parallelTransform(D_ && dst, S const & src, F && f, ThreadPool & pool = ThreadPool::get()) {
+	using D = std::remove_reference_t<D_>;
+	using intN = Tensor::intN<D::rank>;
+	static_assert(D::rank == S::rank);
+	if (dst.size != src.size) {
+		throw Common::Exception() << "parallelTransform size mismatch: dst is " << dst.size << " but src is " << src.size;
+	}
+	forEachGridSlab(dst, pool, [&](intN const & min, intN const & max) {
+		forEachGridRow(dst, min, max, [&](auto * pd, int n, intN const & index) {
+			auto const * ps = src.v + index.dot(src.step);
+			int const sd = dst.step[0];
+			int const ss = src.step[0];
+			if (sd == 1 && ss == 1) {
+				for (int k = 0; k < n; ++k) pd[k] = f(ps[k]);
+			} else {
+				for (int k = 0; k < n; ++k) pd[k * sd] = f(ps[k * ss]);
+			}
+		});
+	});
+}
+
+// parallel version of Grid::map
+template<typename S, typename F>
+auto parallelMap(S const & src, F && f, ThreadPool & pool = ThreadPool::get()) {
+	using Return = std::decay_t<std::invoke_result_t<F, typename S::value_type const &>>;
+	Grid<Return, S::rank> dst(src.size);
+	parallelTransform(dst, src, std::forward<F>(f), pool);
+	return dst;
+}
+
+// same as parallelTransformReduce but without the init, so g must not be empty
+template<typename Acc, typename G, typename Op, typename Map>
+Acc parallelTransformReduceNonEmpty(G const & g, Op && op, Map && map, ThreadPool & pool = ThreadPool::get()) {
+	using intN = Tensor::intN<G::rank>;
+	auto const slabs = gridSlabs(g);
+	std::vector<Acc> partial(slabs.count);
+	constexpr int last = G::rank - 1;
+	pool.parallelFor(slabs.count, [&](int s) {
+		intN min, max = g.size;
+		min[last] = s * slabs.depth;
+		max[last] = std::min(g.size[last], min[last] + slabs.depth);
+		bool first = true;
+		Acc acc = {};
+		forEachGridRow(g, min, max, [&](auto const * p, int n, intN const &) {
+			int const stride = g.step[0];
+			int k = 0;
+			if (first) {
+				acc = map(p[0]);
+				first = false;
+				k = 1;
+			}
+			for (; k < n; ++k) {
+				acc = op(acc, map(p[k * stride]));
+			}
+		});
+		partial[s] = acc;
+	});
+	for (int w = 1; w < slabs.count; w <<= 1) {
+		for (int i = 0; i + w < slabs.count; i += w << 1) {
+			partial[i] = op(partial[i], partial[i + w]);
+		}
+	}
+	return partial[0];
+}
+
+/*
+op(init, map(x0), map(x1), ...) reduced per slab in memory order, then the slab results combined pairwise:
+	((s0 op s1) op (s2 op s3)) op ...
+op must accept (Acc, Acc) and be associative enough for your purposes -- the order is fixed either way.
+*/
+template<typename G, typename Acc, typename Op, typename Map>
+Acc parallelTransformReduce(G const & g, Acc init, Op && op, Map && map, ThreadPool & pool = ThreadPool::get()) {
+	if (g.size.product() <= 0) return init;
+	return op(init, parallelTransformReduceNonEmpty<Acc>(g, op, map, pool));
+}
+
+template<typename G, typename Acc, typename Op>
+Acc parallelReduce(G const & g, Acc init, Op && op, ThreadPool & pool = ThreadPool::get()) {
+	return parallelTransformReduce(g, init, std::forward<Op>(op), [](auto const & x) -> Acc { return x; }, pool);
+}
+
+template<typename G>
+typename G::value_type parallelSum(G const & g, ThreadPool & pool = ThreadPool::get()) {
+	using Type = typename G::value_type;
+	return parallelReduce(g, Type(), std::plus<>(), pool);
+}
+
+// min and max are only for scalar grids.  an empty grid throws.
+template<typename G>
+requires std::is_arithmetic_v<typename G::value_type>
+typename G::value_type parallelMin(G const & g, ThreadPool & pool = ThreadPool::get()) {
+	using Type = typename G::value_type;
+	if (g.size.product() <= 0) throw Common::Exception() << "parallelMin of an empty grid";
+	return parallelReduce(g, *g.v, [](Type a, Type b) -> Type { return b < a ? b : a; }, pool);
+}
+
+template<typename G>
+requires std::is_arithmetic_v<typename G::value_type>
+typename G::value_type parallelMax(G const & g, ThreadPool & pool = ThreadPool::get()) {
+	using Type = typename G::value_type;
+	if (g.size.product() <= 0) throw Common::Exception() << "parallelMax of an empty grid";
+	return parallelReduce(g, *g.v, [](Type a, Type b) -> Type { return a < b ? b : a; }, pool);
+}
+
+// sqrt of the sum of every cell's normSq, i.e. the L2 norm of the whole field
+template<typename G>
+auto parallelNorm(G const & g, ThreadPool & pool = ThreadPool::get()) {
+	using Type = typename G::value_type;
+	if constexpr (is_tensor_v<Type>) {
+		using Scalar = typename Type::Scalar;
+		return (Scalar)std::sqrt(parallelTransformReduce(g, Scalar(), std::plus<>(), [](Type const & x) -> Scalar { return normSq(x); }, pool));
+	} else {
+		return (Type)std::sqrt(parallelTransformReduce(g, Type(), std::plus<>(), [](Type const & x) -> Type { return x * x; }, pool));
+	}
+}
+
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "Tensor/Grid.h"
+#include "Tensor/GridParallel.h"
+#include "Tensor/ThreadPool.h"
+#include "Common/Exception.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <type_traits>
+
+/*
+bounded-memory (out-of-core) execution over a big grid, usually a MappedGrid
+
+the source is read a slab of slowest-axis layers at a time into a buffer, with 'halo' extra layers on either side (clamped at the ends)
+so stencils can see their neighbors across the slab boundary.
+while one slab is being processed the next one is read into a second buffer on a background thread,
+so at most 2 buffers of (depth + 2 * halo) layers are ever alive.
+if the source has advise() (i.e. it's a MappedGrid) then it's told we're going sequential, to read ahead the next slab, and to drop each slab once we're past it.
+
+	auto src = MappedGrid<float, 3>::open("rho.grid");
+	auto dst = MappedGrid<float3, 3>::create("drho.grid", src.cgrid().size);
+	int depth = gridStreamDepth(src, 1 << 30, 2);	// 1GB of buffers
+	streamStencil<2>(dst.grid(), src, depth, [&](auto const & c) { return partialDerivativeGrid<4>(c, dx); });
+*/
+
+namespace Tensor {
+
+// the Grid/GridView behind a source, i.e. MappedGrid's cgrid() or the source itself
+template<typename S>
+decltype(auto) gridStreamData(S const & src) {
+	if constexpr (requires { src.cgrid(); }) {
+		return src.cgrid();
+	} else {
+		return (src);
+	}
+}
+
+template<typename S>
+using GridStreamData = std::remove_cvref_t<decltype(gridStreamData(std::declval<S const &>()))>;
+
+// how many layers per slab fit two buffers (with halos) in budgetBytes.  at least 1.
+template<typename S>
+int gridStreamDepth(S const & src, size_t budgetBytes, int halo = 0) {
+	auto const & g = gridStreamData(src);
+	using G = std::remove_cvref_t<decltype(g)>;
+	constexpr int last = G::rank - 1;
+	size_t layerBytes = sizeof(typename G::value_type);
+	for (int i = 0; i < last; ++i) {
+		layerBytes *= (size_t)std::max(0, g.size[i]);
+	}
+	long const layers = (long)(budgetBytes / std::max<size_t>(1, 2 * layerBytes)) - 2 * halo;
+	return (int)std::clamp<long>(layers, 1, std::max(1, g.size[last]));
+}
+
+/*
+one slab as handed to the callback
+data is a view of source layers [dataBegin, dataBegin + data.size[rank-1]), which includes the halo
+the slab itself is responsible for source layers [begin, end)
+*/
+template<typename Type, int rank>
+struct GridStreamSlab {
+	using intN = Tensor::intN<rank>;
+	static constexpr int last = rank - 1;
+
+	GridView<Type const, rank> data;
+	int dataBegin = {};
+	int begin = {};
+	int end = {};
+
+	intN toSource(intN i) const { i[last] += dataBegin; return i; }
+	intN toData(intN i) const { i[last] -= dataBegin; return i; }
+
+	// just the slab's own layers, without the halo
+	GridView<Type const, rank> interior() const {
+		intN min, max = data.size;
+		min[last] = begin - dataBegin;
+		max[last] = end - dataBegin;
+		return data.slice(min, max);
+	}
+};
+
+/*
+calls f(GridStreamSlab const &) for each slab of 'depth' layers, in order, on the calling thread
+the slab's buffer is only valid during the call
+*/
+template<typename S, typename F>
+void streamGrid(S const & src, int depth, int halo, F && f, bool prefetch = true) {
+	using G = GridStreamData<S>;
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	constexpr int last = rank - 1;
+	using intN = Tensor::intN<rank>;
+
+	auto const & g = gridStreamData(src);
+	int const n = g.size[last];
+	if (g.size.product() <= 0) return;
+	if (depth < 1) throw Common::Exception() << "streamGrid depth must be positive, got " << depth;
+	if (halo < 0) throw Common::Exception() << "streamGrid halo must be non-negative, got " << halo;
+	depth = std::min(depth, n);
+	int const count = (n + depth - 1) / depth;
+
+	auto advise = [&](auto advice, int a, int b) {
+		if constexpr (requires { src.advise(advice, a, b); }) {
+			src.advise(advice, a, b);
+		}
+	};
+	auto dataRange = [&](int s) -> std::pair<int, int> {
+		int const begin = s * depth;
+		int const end = std::min(n, begin + depth);
+		return {std::max(0, begin - halo), std::min(n, end + halo)};
+	};
+	if constexpr (requires { S::Advice::Sequential; }) {
+		advise(S::Advice::Sequential, 0, n);
+	}
+
+	// each buffer is big enough for the biggest slab + halo, and slabs use a prefix of it
+	intN bufferSize = g.size;
+	bufferSize[last] = std::min(n, depth + 2 * halo);
+	Grid<Type, rank> buffers[2] = {Grid<Type, rank>(bufferSize), Grid<Type, rank>(bufferSize)};
+
+	// copy source layers [a, b) into the front of buffer
+	auto load = [&](Grid<Type, rank> & buffer, int a, int b) {
+		intN min, max = g.size;
+		min[last] = a;
+		max[last] = b;
+		forEachGridRow(g, min, max, [&](auto const * p, int rowLen, intN index) {
+			index[last] -= a;
+			Type * q = buffer.v + index.dot(buffer.step);
+			if constexpr (std::is_trivially_copyable_v<Type>) {
+				if (g.step[0] == 1) {
+					std::memcpy((void*)q, (void const *)p, sizeof(Type) * rowLen);
+					return;
+				}
+			}
+			for (int k = 0; k < rowLen; ++k) {
+				q[k] = p[k * g.step[0]];
+			}
+		});
+	};
+
+	{
+		auto [a, b] = dataRange(0);
+		load(buffers[0], a, b);
+	}
+	for (int s = 0; s < count; ++s) {
+		auto [a, b] = dataRange(s);
+		std::future<void> next;
+		if (s + 1 < count) {
+			auto [na, nb] = dataRange(s + 1);
+			if constexpr (requires { S::Advice::WillNeed; }) {
+				advise(S::Advice::WillNeed, na, nb);
+			}
+			auto & nextBuffer = buffers[(s + 1) & 1];
+			if (prefetch) {
+				next = std::async(std::launch::async, [&load, &nextBuffer, na = na, nb = nb]() { load(nextBuffer, na, nb); });
+			}
+		}
+
+		auto const & buffer = buffers[s & 1];
+		intN size = g.size;
+		size[last] = b - a;
+		GridStreamSlab<Type, rank> slab;
+		slab.data = GridView<Type const, rank>(size, buffer.step, buffer.v);
+		slab.dataBegin = a;
+		slab.begin = s * depth;
+		slab.end = std::min(n, slab.begin + depth);
+		try {
+			f(slab);
+		} catch (...) {
+			// don't let the prefetch outlive the buffers
+			if (next.valid()) next.wait();
+			throw;
+		}
+
+		if (s + 1 < count) {
+			if (prefetch) {
+				next.get();
+			} else {
+				auto [na, nb] = dataRange(s + 1);
+				load(buffers[(s + 1) & 1], na, nb);
+			}
+		}
+		// the next slab's halo can reach back into this one, so only drop what's behind that
+		if constexpr (requires { S::Advice::DontNeed; }) {
+			advise(S::Advice::DontNeed, a, std::max(a, std::min(b, slab.end - halo)));
+		}
+	}
+}
+
+/*
+dst(i) = f(cursor at i) for every i at least 'border' cells from the edge of src, like Grid::interiorRange<border>
+the cursor is a GridCursor<..., border> into the slab's buffer, so stencils like partialDerivativeGrid<order>(c, dx) work as-is.
+cursor.index is in buffer coordinates, so if you need the source index use the second form:
+	f(cursor) or f(cursor, intN sourceIndex)
+dst is written directly, so it can be in memory or a MappedGrid's grid()
+cells within each slab are done in parallel on the pool
+*/
+template<int border, typename D, typename S, typename F>
+requires (border >= 0)
+void streamStencil(D && dst, S const & src, int depth, F && f, ThreadPool & pool = ThreadPool::get(), bool prefetch = true) {
+	using G = GridStreamData<S>;
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	constexpr int last = rank - 1;
+	using intN = Tensor::intN<rank>;
+	using View = GridView<Type const, rank>;
+	using Cursor = GridCursor<View, border>;
+
+	auto const & g = gridStreamData(src);
+	if (dst.size != g.size) {
+		throw Common::Exception() << "streamStencil size mismatch: dst is " << dst.size << " but src is " << g.size;
+	}
+	int const n = g.size[last];
+	streamGrid(src, depth, border, [&](GridStreamSlab<Type, rank> const & slab) {
+		// the interior of the whole source that lies in this slab, in buffer coordinates
+		intN min(border), max = g.size - border;
+		min[last] = std::max(slab.begin, border) - slab.dataBegin;
+		max[last] = std::min(slab.end, n - border) - slab.dataBegin;
+		for (int i = 0; i < rank; ++i) {
+			if (max[i] <= min[i]) return;
+		}
+		// split the slab's layers into chunks for the pool.  fixed size, so same result for any pool.
+		int const layers = max[last] - min[last];
+		int const chunk = std::max(1, std::min(layers, gridSlabs(slab.data).depth));
+		pool.parallelFor((layers + chunk - 1) / chunk, [&](int c) {
+			intN cmin = min, cmax = max;
+			cmin[last] = min[last] + c * chunk;
+			cmax[last] = std::min(max[last], cmin[last] + chunk);
+			for (auto const & cursor : GridCursorRange<View, border>(const_cast<View*>(&slab.data), cmin, cmax)) {
+				intN const i = slab.toSource(cursor.index);
+				if constexpr (std::is_invocable_v<F, Cursor const &, intN const &>) {
+					dst(i) = f(cursor, i);
+				} else {
+					dst(i) = f(cursor);
+				}
+			}
+		});
+	}, prefetch);
+}
+
+/*
+parallelTransformReduce over a source that doesn't fit in memory
+each slab is reduced with parallelTransformReduce, then the slab results are folded in order: op(op(op(init, s0), s1), ...)
+so it is deterministic for a given depth (but not necessarily bit-identical to the in-memory reduction)
+*/
+template<typename S, typename Acc, typename Op, typename Map>
+Acc streamTransformReduce(S const & src, int depth, Acc init, Op && op, Map && map, ThreadPool & pool = ThreadPool::get(), bool prefetch = true) {
+	using G = GridStreamData<S>;
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	Acc acc = init;
+	streamGrid(src, depth, 0, [&](GridStreamSlab<Type, rank> const & slab) {
+		auto const interior = slab.interior();
+		if (interior.size.product() <= 0) return;
+		acc = op(acc, parallelTransformReduceNonEmpty<Acc>(interior, op, map, pool));
+	}, prefetch);
+	return acc;
+}
+
+template<typename S>
+auto streamSum(S const & src, int depth, ThreadPool & pool = ThreadPool::get(), bool prefetch = true) {
+	using Type = typename GridStreamData<S>::value_type;
+	return streamTransformReduce(src, depth, Type(), std::plus<>(), [](Type const & x) -> Type { return x; }, pool, prefetch);
+}
+
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "Tensor/Grid.h"
+#include "Tensor/Signature.h"
+#include "Common/Exception.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#error "MappedGrid is POSIX-only for now"
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+file-backed Grid, for fields bigger than memory
+
+the file is a one-page header followed by the raw cells, in the same layout as Grid (index 0 fastest).
+the whole file is mmap'd, so pages are read in lazily as they are touched and the OS can evict them again,
+and what we hand out points into the mapping: a const Grid to read, a GridView to write, so nothing can resize it out from under the file.
+
+	auto m = MappedGrid<float3s3, 3>::create("field.grid", int3(1024, 1024, 1024));
+	m.grid()(i) = ...;
+
+	auto m = MappedGrid<float3s3, 3>::open("field.grid");	// read-only
+	m.advise(MappedGrid<float3s3, 3>::Advice::Sequential);
+	for (auto x : m.cgrid()) ...
+*/
+
+namespace Tensor {
+
+struct MappedGridHeader {
+	static constexpr char magicValue[8] = {'T', 'N', 'S', 'R', 'G', 'R', 'I', 'D'};
+	static constexpr uint32_t currentVersion = 1;
+	static constexpr uint64_t headerBytes = 4096;	// also where the data starts, so it's page-aligned
+	static constexpr int maxRank = 16;
+	static constexpr int maxSignature = 256;
+
+	char magic[8] = {};
+	uint32_t version = {};
+	uint32_t endian = {};
+	uint32_t rank = {};
+	uint32_t elementSize = {};
+	uint64_t dataOffset = {};
+	int64_t size[maxRank] = {};
+	char signature[maxSignature] = {};	// storageSignature<Type>(), 0-terminated
+};
+static_assert(sizeof(MappedGridHeader) <= MappedGridHeader::headerBytes);
+
+template<typename Type_, int rank_>
+struct MappedGrid {
+	using Type = Type_;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	static_assert(std::is_trivially_copyable_v<Type>, "MappedGrid stores raw bytes, so Type must be trivially copyable");
+	static_assert(rank <= MappedGridHeader::maxRank);
+
+	enum class Mode { ReadOnly, ReadWrite };
+	enum class Advice { Normal, Sequential, Random, WillNeed, DontNeed };
+
+	std::string path;
+	Mode mode = Mode::ReadOnly;
+	int fd = -1;
+	char * mapping = {};
+	size_t mappingBytes = {};
+	Grid<Type, rank> g;	// non-owning, points into the mapping
+
+	MappedGrid() {}
+	MappedGrid(MappedGrid const &) = delete;
+	MappedGrid & operator=(MappedGrid const &) = delete;
+
+	MappedGrid(MappedGrid && o)
+	:	path(std::move(o.path)),
+		mode(o.mode),
+		fd(o.fd),
+		mapping(o.mapping),
+		mappingBytes(o.mappingBytes),
+		g(std::move(o.g))
+	{
+		o.fd = -1;
+		o.mapping = {};
+		o.mappingBytes = {};
+	}
+
+	MappedGrid & operator=(MappedGrid && o) {
+		if (this == &o) return *this;
+		close();
+		path = std::move(o.path);
+		mode = o.mode;
+		fd = o.fd;
+		mapping = o.mapping;
+		mappingBytes = o.mappingBytes;
+		g = std::move(o.g);
+		o.fd = -1;
+		o.mapping = {};
+		o.mappingBytes = {};
+		return *this;
+	}
+
+	~MappedGrid() {
+		close();
+	}
+
+	// creates (or truncates) the file, zero-filled, mapped read-write
+	static MappedGrid create(std::string const & path, intN const & size, bool populate = false) {
+		MappedGrid m;
+		m.path = path;
+		m.mode = Mode::ReadWrite;
+		m.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (m.fd < 0) throw Common::Exception() << "failed to create " << path << ": " << strerror(errno);
+
+		MappedGridHeader h;
+		std::memcpy(h.magic, MappedGridHeader::magicValue, sizeof(h.magic));
+		h.version = MappedGridHeader::currentVersion;
+		h.endian = endianTag;
+		h.rank = rank;
+		h.elementSize = sizeof(Type);
+		h.dataOffset = MappedGridHeader::headerBytes;
+		for (int i = 0; i < rank; ++i) {
+			h.size[i] = size[i];
+		}
+		std::string const sig = storageSignature<Type>();
+		if (sig.size() >= sizeof(h.signature)) throw Common::Exception() << "signature too long: " << sig;
+		std::memcpy(h.signature, sig.c_str(), sig.size());
+
+		size_t const fileBytes = h.dataOffset + (size_t)size.product() * sizeof(Type);
+		if (ftruncate(m.fd, (off_t)fileBytes) != 0) throw Common::Exception() << "failed to size " << path << ": " << strerror(errno);
+		if (pwrite(m.fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) throw Common::Exception() << "failed to write header of " << path << ": " << strerror(errno);
+
+		m.map(size, h.dataOffset, fileBytes, populate);
+		return m;
+	}
+
+	static MappedGrid open(std::string const & path, Mode mode = Mode::ReadOnly, bool populate = false) {
+		MappedGrid m;
+		m.path = path;
+		m.mode = mode;
+		m.fd = ::open(path.c_str(), mode == Mode::ReadWrite ? O_RDWR : O_RDONLY);
+		if (m.fd < 0) throw Common::Exception() << "failed to open " << path << ": " << strerror(errno);
+
+		MappedGridHeader h;
+		if (pread(m.fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) throw Common::Exception() << path << " is too small to be a MappedGrid";
+		if (std::memcmp(h.magic, MappedGridHeader::magicValue, sizeof(h.magic))) throw Common::Exception() << path << " is not a MappedGrid";
+		if (h.endian == endianTagSwapped) throw Common::Exception() << path << " was written on a machine of the other endianness, so it can't be mapped directly";
+		if (h.endian != endianTag) throw Common::Exception() << path << " has a bad endian tag";
+		if (h.version > MappedGridHeader::currentVersion) throw Common::Exception() << path << " is version " << h.version << " but we only know up to " << MappedGridHeader::currentVersion;
+		if (h.rank != (uint32_t)rank) throw Common::Exception() << path << " has rank " << h.rank << " but we expected " << rank;
+		if (h.elementSize != sizeof(Type)) throw Common::Exception() << path << " has element size " << h.elementSize << " but we expected " << sizeof(Type);
+		h.signature[sizeof(h.signature)-1] = 0;
+		std::string const sig = storageSignature<Type>();
+		if (sig != h.signature) throw Common::Exception() << path << " holds '" << h.signature << "' but we expected '" << sig << "'";
+
+		intN size;
+		for (int i = 0; i < rank; ++i) {
+			size[i] = (int)h.size[i];
+		}
+		size_t const fileBytes = h.dataOffset + (size_t)size.product() * sizeof(Type);
+		struct stat st;
+		if (fstat(m.fd, &st) != 0) throw Common::Exception() << "failed to stat " << path << ": " << strerror(errno);
+		if ((size_t)st.st_size < fileBytes) throw Common::Exception() << path << " is truncated: " << st.st_size << " bytes but the header says " << fileBytes;
+
+		m.map(size, h.dataOffset, fileBytes, populate);
+		return m;
+	}
+
+	// map fileBytes of fd and point the grid at dataOffset into it.  also used by other file formats, like mapNpy.
+	void map(intN const & size, uint64_t dataOffset, size_t fileBytes, bool populate) {
+		int prot = PROT_READ | (mode == Mode::ReadWrite ? PROT_WRITE : 0);
+		int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+		if (populate) flags |= MAP_POPULATE;
+#endif
+		void * p = mmap(nullptr, fileBytes, prot, flags, fd, 0);
+		if (p == MAP_FAILED) throw Common::Exception() << "failed to map " << path << ": " << strerror(errno);
+		mapping = (char*)p;
+		mappingBytes = fileBytes;
+		g = Grid<Type, rank>(size, (Type*)(mapping + dataOffset));
+	}
+
+	void close() {
+		g = Grid<Type, rank>();
+		if (mapping) {
+			munmap(mapping, mappingBytes);
+			mapping = {};
+			mappingBytes = {};
+		}
+		if (fd >= 0) {
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+	bool isOpen() const { return mapping != nullptr; }
+	bool isWritable() const { return mode == Mode::ReadWrite; }
+
+	// read-write access.  throws if we were opened read-only, since writing would segfault.
+	// a view and not a Grid &, since Grid::resize() would copy out of the mapping and stop writing to the file.
+	GridView<Type, rank> grid() {
+		if (!isWritable()) throw Common::Exception() << path << " is mapped read-only";
+		return g.view();
+	}
+
+	Grid<Type, rank> const & cgrid() const { return g; }
+	Grid<Type, rank> const & grid() const { return g; }
+	GridView<Type const, rank> view() const { return g.view(); }
+
+	/*
+	madvise over layers [begin, end) of the slowest axis, or the whole field by default
+	Sequential before a big sweep, WillNeed to prefetch the next slab, DontNeed to drop one we're done with
+	*/
+	void advise(Advice advice, int begin = 0, int end = -1) const {
+		if (!mapping) return;
+		int const n = g.size[rank-1];
+		if (end < 0 || end > n) end = n;
+		if (begin < 0) begin = 0;
+		if (end <= begin) return;
+		size_t const layerBytes = (size_t)g.step[rank-1] * sizeof(Type);
+		size_t const pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		char * start = (char*)g.v + (size_t)begin * layerBytes;
+		char * finish = (char*)g.v + (size_t)end * layerBytes;
+		char * pageStart = mapping + (size_t)(start - mapping) / pageSize * pageSize;
+		int flag = MADV_NORMAL;
+		switch (advice) {
+		case Advice::Normal: flag = MADV_NORMAL; break;
+		case Advice::Sequential: flag = MADV_SEQUENTIAL; break;
+		case Advice::Random: flag = MADV_RANDOM; break;
+		case Advice::WillNeed: flag = MADV_WILLNEED; break;
+		case Advice::DontNeed: flag = MADV_DONTNEED; break;
+		}
+		// just a hint, don't care if it fails
+		madvise(pageStart, (size_t)(finish - pageStart), flag);
+	}
+
+	// flush dirty pages to the file
+	void sync(bool async = false) {
+		if (!mapping || !isWritable()) return;
+		if (msync(mapping, mappingBytes, async ? MS_ASYNC : MS_SYNC) != 0) {
+			throw Common::Exception() << "failed to sync " << path << ": " << strerror(errno);
+		}
+	}
+};
+
+}
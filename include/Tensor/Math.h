@@ -642,9 +642,54 @@ typename T::Scalar normExt(T const & v) {
 	return (typename T::Scalar)sqrt(normExtSq(v));
 }
 
+/*
+parallelotope measure of the rows of an m x n matrix by Householder LQ: A = L Q, measure = |det L| = prod |L_kk|.
+that's O(m^2 n), while wedgeAll's asymR storage grows as n choose k for every row it wedges.
+*/
+template<typename T> requires (is_tensor_v<T> && T::rank == 2)
+typename T::Scalar measureHouseholder(T const & v) {
+	using S = typename T::Scalar;
+	constexpr int m = T::template dim<0>;
+	constexpr int n = T::template dim<1>;
+	auto a = mat<S,m,n>([&](int i, int j) -> S { return v(i,j); });
+	S result = 1;
+	for (int k = 0; k < m; ++k) {
+		// reflect row k's tail onto e_k, and everything below it along with it
+		S normSq = {};
+		for (int j = k; j < n; ++j) normSq += a(k,j) * a(k,j);
+		S const norm = (S)sqrt(normSq);
+		if (norm == 0) return {};
+		result *= norm;
+		S const alpha = a(k,k) > 0 ? -norm : norm;
+		a(k,k) -= alpha;
+		// |u|^2 = |x|^2 - 2 alpha x_k + alpha^2 = 2 (|x|^2 - alpha x_k)
+		S const uSq = 2 * (normSq + norm * std::abs(a(k,k) + alpha));
+		for (int i = k + 1; i < m; ++i) {
+			S dot = {};
+			for (int j = k; j < n; ++j) dot += a(i,j) * a(k,j);
+			S const f = 2 * dot / uSq;
+			for (int j = k; j < n; ++j) a(i,j) -= f * a(k,j);
+		}
+	}
+	return result;
+}
+
+/*
+m > 3 rows goes by Householder instead of the wedge product.  more rows than columns is always zero.
+innerExt is the full (Frobenius) contraction, which counts each component of an m-form m! times, so the wedge's normExt is sqrt(m!) times the measure.
+*/
 template<typename T> requires (is_tensor_v<T> && T::rank == 2)
 typename T::Scalar measure(T const & v) {
-	return v.wedgeAll().normExt();
+	using S = typename T::Scalar;
+	constexpr int m = T::template dim<0>;
+	constexpr int n = T::template dim<1>;
+	if constexpr (m > n) {
+		return {};
+	} else if constexpr (m > 3) {
+		return measureHouseholder(v);
+	} else {
+		return v.wedgeAll().normExt() / (S)sqrt((S)constexpr_factorial(m));
+	}
 }
 
 template<typename T> requires (is_tensor_v<T> && T::rank == 2)
@@ -122,6 +122,9 @@ typename T::Scalar normExtSq(T const & v);
 template<typename T> requires (is_tensor_v<T>)
 typename T::Scalar normExt(T const & v);
 
+template<typename T> requires (is_tensor_v<T> && T::rank == 2)
+typename T::Scalar measureHouseholder(T const & v);
+
 template<typename T> requires (is_tensor_v<T> && T::rank == 2)
 typename T::Scalar measure(T const & v);
 
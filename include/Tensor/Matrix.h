@@ -2,6 +2,8 @@
 
 #include "Tensor/Vector.h"
 #include "Tensor/Quat.h"
+#include <cstdint>
+#include <span>
 
 /*
 Here's some common OpenGL / 3D matrix operations
@@ -82,7 +84,7 @@ mat<real,4,4> lookAt(
 	return mat<real,4,4>{
 		{X.x, X.y, X.z, -eye.dot(X)},
 		{Y.x, Y.y, Y.z, -eye.dot(Y)},
-		{Z.x, Z.y, Z.x, -eye.dot(Z)},
+		{Z.x, Z.y, Z.z, -eye.dot(Z)},
 		{0, 0, 0, 1},
 	};
 }
@@ -115,10 +117,9 @@ mat<real,4,4> frustum(
 gluPerspective
 http://www.songho.ca/opengl/gl_transform.html
 https://www.khronos.org/opengl/wiki/GluPerspective_code
-TODO tempted to make an optimized storage class for this as well.
 It's *almost* a diagonal scale class (min(m,n) reals for m x n matrix) 
 though this have to be specialized for perspective since it has that one off-diagonal element...
-I see this as the library slowly creeping into sparse-matrix storage. 
+see perspectiveMat below for the compact version.
 */
 template<typename real>
 mat<real,4,4> perspective(
@@ -160,7 +161,295 @@ mat<real,4,4> ortho2D(
 	real bottom,
 	real top
 ) {
-	return ortho(left, right, bottom, top, -1, 1);
+	return ortho<real>(left, right, bottom, top, -1, 1);
+}
+
+/*
+compact projection matrices: just the nonzero values, with the multiplies and inverses written out.
+toMatrix() gives the same as the dense frustum / perspective / ortho above.
+
+perspectiveMat is
+	[sx  0 ox  0]
+	[ 0 sy oy  0]
+	[ 0  0 zz zw]
+	[ 0  0 -1  0]
+*/
+template<typename T>
+struct perspectiveMat {
+	T sx = {}, sy = {}, ox = {}, oy = {}, zz = {}, zw = {};
+
+	static perspectiveMat frustum(T left, T right, T bottom, T top, T near, T far) {
+		return {
+			2 * near / (right - left),
+			2 * near / (top - bottom),
+			(right + left) / (right - left),
+			(top + bottom) / (top - bottom),
+			-(far + near) / (far - near),
+			-2 * far * near / (far - near),
+		};
+	}
+
+	static perspectiveMat perspective(T fovY, T aspectRatio, T near, T far) {
+		auto ymax = near * std::tan(fovY * (T).5);
+		auto xmax = aspectRatio * ymax;
+		return frustum(-xmax, xmax, -ymax, ymax, near, far);
+	}
+
+	mat<T,4,4> toMatrix() const {
+		return mat<T,4,4>{
+			{sx, 0, ox, 0},
+			{0, sy, oy, 0},
+			{0, 0, zz, zw},
+			{0, 0, -1, 0},
+		};
+	}
+
+	vec4<T> operator*(vec4<T> const & v) const {
+		return vec4<T>(sx * v.x + ox * v.z, sy * v.y + oy * v.z, zz * v.z + zw * v.w, -v.z);
+	}
+
+	// this * m, 4 rows of 2 scaled rows each, instead of a dense 4x4 multiply.  m is usually a view or model-view.
+	mat<T,4,4> operator*(mat<T,4,4> const & m) const {
+		return mat<T,4,4>{
+			m[0] * sx + m[2] * ox,
+			m[1] * sy + m[2] * oy,
+			m[2] * zz + m[3] * zw,
+			-m[2],
+		};
+	}
+
+	// eye space point to normalized device coordinates, with the divide
+	vec3<T> project(vec3<T> const & p) const {
+		return vec3<T>(sx * p.x + ox * p.z, sy * p.y + oy * p.z, zz * p.z + zw) / -p.z;
+	}
+
+	// normalized device coordinates back to eye space
+	vec3<T> unproject(vec3<T> const & ndc) const {
+		T const w = (ndc.z + zz) / zw;
+		return vec3<T>((ndc.x + ox) / sx, (ndc.y + oy) / sy, -1) / w;
+	}
+
+	// the inverse isn't perspective-shaped, so it comes back dense, but without a general 4x4 inverse
+	mat<T,4,4> inverse() const {
+		return mat<T,4,4>{
+			{1 / sx, 0, 0, ox / sx},
+			{0, 1 / sy, 0, oy / sy},
+			{0, 0, 0, -1},
+			{0, 0, 1 / zw, zz / zw},
+		};
+	}
+};
+
+/*
+orthoMat is
+	[sx  0  0 tx]
+	[ 0 sy  0 ty]
+	[ 0  0 sz tz]
+	[ 0  0  0  1]
+*/
+template<typename T>
+struct orthoMat {
+	T sx = 1, sy = 1, sz = 1, tx = {}, ty = {}, tz = {};
+
+	static orthoMat ortho(T left, T right, T bottom, T top, T near, T far) {
+		return {
+			2 / (right - left),
+			2 / (top - bottom),
+			-2 / (far - near),
+			-(right + left) / (right - left),
+			-(top + bottom) / (top - bottom),
+			-(far + near) / (far - near),
+		};
+	}
+
+	static orthoMat ortho2D(T left, T right, T bottom, T top) {
+		return ortho(left, right, bottom, top, -1, 1);
+	}
+
+	mat<T,4,4> toMatrix() const {
+		return mat<T,4,4>{
+			{sx, 0, 0, tx},
+			{0, sy, 0, ty},
+			{0, 0, sz, tz},
+			{0, 0, 0, 1},
+		};
+	}
+
+	vec4<T> operator*(vec4<T> const & v) const {
+		return vec4<T>(sx * v.x + tx * v.w, sy * v.y + ty * v.w, sz * v.z + tz * v.w, v.w);
+	}
+
+	mat<T,4,4> operator*(mat<T,4,4> const & m) const {
+		return mat<T,4,4>{
+			m[0] * sx + m[3] * tx,
+			m[1] * sy + m[3] * ty,
+			m[2] * sz + m[3] * tz,
+			m[3],
+		};
+	}
+
+	orthoMat operator*(orthoMat const & o) const {
+		return {
+			sx * o.sx, sy * o.sy, sz * o.sz,
+			sx * o.tx + tx, sy * o.ty + ty, sz * o.tz + tz,
+		};
+	}
+
+	vec3<T> project(vec3<T> const & p) const {
+		return vec3<T>(sx * p.x + tx, sy * p.y + ty, sz * p.z + tz);
+	}
+
+	vec3<T> unproject(vec3<T> const & ndc) const {
+		return vec3<T>((ndc.x - tx) / sx, (ndc.y - ty) / sy, (ndc.z - tz) / sz);
+	}
+
+	orthoMat inverse() const {
+		return {1 / sx, 1 / sy, 1 / sz, -tx / sx, -ty / sy, -tz / sz};
+	}
+};
+
+
+/*
+batched transforms by a 4x4, for when one matrix (a model, a view, an mvp) is applied to lots of points.
+same as rotate(mat3x3, ...): points go through in blocks, split into x, y, z arrays, so the loops vectorize across points.
+src and dst can be the same span.
+*/
+
+// clip flags, set when a point is outside that plane of the clip volume -w <= x,y,z <= w.  for frustum culling.
+enum ClipFlags : uint8_t {
+	clipLeft = 1 << 0,
+	clipRight = 1 << 1,
+	clipBottom = 1 << 2,
+	clipTop = 1 << 3,
+	clipNear = 1 << 4,
+	clipFar = 1 << 5,
+};
+
+namespace MatrixDetail {
+inline constexpr int transformBlock = 16;
+
+// no homogeneous divide needed when the bottom row is 0 0 0 1
+template<typename T>
+bool isAffine(mat<T,4,4> const & m) {
+	return m(3,0) == 0 && m(3,1) == 0 && m(3,2) == 0 && m(3,3) == 1;
+}
+
+template<bool project, bool clip, typename T>
+void transformBlocks(mat<T,4,4> const & m, std::span<vec3<T> const> src, std::span<vec3<T>> dst, std::span<uint8_t> clipFlags) {
+	constexpr int B = transformBlock;
+	T const m00 = m(0,0), m01 = m(0,1), m02 = m(0,2), m03 = m(0,3);
+	T const m10 = m(1,0), m11 = m(1,1), m12 = m(1,2), m13 = m(1,3);
+	T const m20 = m(2,0), m21 = m(2,1), m22 = m(2,2), m23 = m(2,3);
+	T const m30 = m(3,0), m31 = m(3,1), m32 = m(3,2), m33 = m(3,3);
+	size_t const n = src.size();
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const count = (int)std::min<size_t>(B, n - begin);
+		T px[B] = {}, py[B] = {}, pz[B] = {};
+		for (int k = 0; k < count; ++k) {
+			auto const & p = src[begin + k];
+			px[k] = p.x;
+			py[k] = p.y;
+			pz[k] = p.z;
+		}
+		T ox[B], oy[B], oz[B];
+		int flags[B];
+		for (int k = 0; k < B; ++k) {
+			T const x = m00 * px[k] + m01 * py[k] + m02 * pz[k] + m03;
+			T const y = m10 * px[k] + m11 * py[k] + m12 * pz[k] + m13;
+			T const z = m20 * px[k] + m21 * py[k] + m22 * pz[k] + m23;
+			T const w = project ? m30 * px[k] + m31 * py[k] + m32 * pz[k] + m33 : T(1);
+			if constexpr (clip) {
+				// in clip space, before the divide, so points behind the eye still get flagged
+				flags[k] = (x < -w ? clipLeft : 0)
+					| (x > w ? clipRight : 0)
+					| (y < -w ? clipBottom : 0)
+					| (y > w ? clipTop : 0)
+					| (z < -w ? clipNear : 0)
+					| (z > w ? clipFar : 0);
+			}
+			if constexpr (project) {
+				T const invW = 1 / w;
+				ox[k] = x * invW;
+				oy[k] = y * invW;
+				oz[k] = z * invW;
+			} else {
+				ox[k] = x;
+				oy[k] = y;
+				oz[k] = z;
+			}
+		}
+		for (int k = 0; k < count; ++k) {
+			dst[begin + k] = vec3<T>(ox[k], oy[k], oz[k]);
+		}
+		if constexpr (clip) {
+			for (int k = 0; k < count; ++k) {
+				clipFlags[begin + k] = (uint8_t)flags[k];
+			}
+		}
+	}
+}
+
+template<bool clip, typename T>
+void transformPoints(mat<T,4,4> const & m, std::span<vec3<T> const> src, std::span<vec3<T>> dst, std::span<uint8_t> clipFlags) {
+	if (src.size() != dst.size()) throw Common::Exception() << "transform " << src.size() << " points into " << dst.size();
+	if (clip && clipFlags.size() != src.size()) throw Common::Exception() << clipFlags.size() << " clip flags for " << src.size() << " points";
+	if (isAffine(m)) {
+		transformBlocks<false, clip>(m, src, dst, clipFlags);
+	} else {
+		transformBlocks<true, clip>(m, src, dst, clipFlags);
+	}
+}
+}
+
+/*
+dst[i] = m * (src[i], 1), divided by its w.
+the divide is skipped when m is affine (translate, rotate, scale, lookAt, ortho and their products).
+a point with w = 0 comes out inf, so check clip flags first if that can happen.
+*/
+template<typename T>
+void transformPoints(mat<T,4,4> const & m, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	MatrixDetail::transformPoints<false, T>(m, src, dst, {});
+}
+
+// same, and clipFlags[i] gets the ClipFlags of src[i]'s clip space position.  0 means inside.
+template<typename T>
+void transformPoints(mat<T,4,4> const & m, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst, std::span<uint8_t> clipFlags) {
+	MatrixDetail::transformPoints<true, T>(m, src, dst, clipFlags);
+}
+
+// model-view-projection in one pass: the matrices are multiplied once up front instead of each point going through all three.
+// projection can be a dense mat4x4, or a perspectiveMat or orthoMat.
+template<typename Projection, typename T>
+void transformPoints(
+	Projection const & projection,
+	mat<T,4,4> const & view,
+	mat<std::type_identity_t<T>,4,4> const & model,
+	std::span<vec3<std::type_identity_t<T>> const> src,
+	std::span<vec3<std::type_identity_t<T>>> dst
+) {
+	MatrixDetail::transformPoints<false, T>(projection * view * model, src, dst, {});
+}
+
+template<typename Projection, typename T>
+void transformPoints(
+	Projection const & projection,
+	mat<T,4,4> const & view,
+	mat<std::type_identity_t<T>,4,4> const & model,
+	std::span<vec3<std::type_identity_t<T>> const> src,
+	std::span<vec3<std::type_identity_t<T>>> dst,
+	std::span<uint8_t> clipFlags
+) {
+	MatrixDetail::transformPoints<true, T>(projection * view * model, src, dst, clipFlags);
+}
+
+// dst[i] = m * (src[i], 0), for directions: no translation and no divide.
+template<typename T>
+void transformVectors(mat<T,4,4> const & m, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	rotate(mat3x3<T>{
+		{m(0,0), m(0,1), m(0,2)},
+		{m(1,0), m(1,1), m(1,2)},
+		{m(2,0), m(2,1), m(2,2)},
+	}, src, dst);
 }
 
 }
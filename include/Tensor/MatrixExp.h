@@ -0,0 +1,280 @@
+#pragma once
+
+#include "Tensor/Vector.h"
+#include "Tensor/Quat.h"
+#include <cmath>
+#include <limits>
+#include <utility>
+
+/*
+matrix exponential and logarithm
+
+closed form for rotations:
+	exp(asym3) = Rodrigues' formula, as a mat3x3 or a quat
+	logRotation(mat3x3) = the asym3 generator of a rotation
+the asym3 generator w^ of the angular velocity w is
+	[  0  -wz  wy]
+	[ wz   0  -wx]
+	[-wy  wx   0 ]
+i.e. wx = a(2,1), wy = a(0,2), wz = a(1,0), so a(i,j) v_j = (w x v)_i
+
+and scaling-and-squaring Pade for the rest, as in Higham, "The Scaling and Squaring Method for the Matrix Exponential Revisited", 2005:
+	exp(mat<T,N,N>) = mat
+	exp(sym<T,N>) = sym, with every product only computing its upper triangle
+	exp(asym<T,N>) = mat (orthogonal), with the even powers only computing their upper triangle
+*/
+
+namespace Tensor {
+
+namespace MatrixExpDetail {
+
+// sin(t)/t, (1 - cos(t))/t^2, and their series near zero
+template<typename T>
+void rodriguesCoeffs(T theta, T & a, T & b) {
+	T const theta2 = theta * theta;
+	if (theta2 < std::sqrt(std::numeric_limits<T>::epsilon())) {
+		a = 1 - theta2 / 6 * (1 - theta2 / 20);
+		b = (T).5 - theta2 / 24 * (1 - theta2 / 30);
+	} else {
+		a = std::sin(theta) / theta;
+		b = (1 - std::cos(theta)) / theta2;
+	}
+}
+
+template<typename T>
+vec3<T> asymToVec(asym<T,3> const & w) {
+	return vec3<T>(w(2,1), w(0,2), w(1,0));
+}
+
+// b_j of the [m/m] Pade approximant of exp, scaled so b_0 = 1
+template<int m>
+constexpr double padeCoeff(int j) {
+	double b = 1;
+	for (int i = 1; i <= j; ++i) {
+		b *= (double)(m - i + 1) / (double)(i * (2 * m - i + 1));
+	}
+	return b;
+}
+
+/*
+Higham's theta_m: the largest 1-norm where the degree m approximant is accurate to unit roundoff, without scaling.
+the last one is the degree that scaling targets.
+*/
+template<typename T>
+struct PadeDegrees;
+
+template<>
+struct PadeDegrees<double> {
+	static constexpr int count = 5;
+	static constexpr int degree[count] = {3, 5, 7, 9, 13};
+	static constexpr double theta[count] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1, 2.097847961257068e+0, 5.371920351148152e+0};
+};
+
+template<>
+struct PadeDegrees<float> {
+	static constexpr int count = 3;
+	static constexpr int degree[count] = {3, 5, 7};
+	static constexpr double theta[count] = {4.258730016922831e-1, 1.880152677804762e+0, 3.925724783138660e+0};
+};
+
+template<typename T>
+requires (std::is_same_v<T, long double>)
+struct PadeDegrees<T> : public PadeDegrees<double> {};
+
+template<typename T, int N>
+T norm1(mat<T,N,N> const & a) {
+	T result = {};
+	for (int j = 0; j < N; ++j) {
+		T sum = {};
+		for (int i = 0; i < N; ++i) {
+			sum += std::abs(a(i,j));
+		}
+		result = sum > result ? sum : result;
+	}
+	return result;
+}
+
+// a * b, when the result is known to be symmetric (powers of one symmetric matrix), only computing its upper triangle
+template<typename T, int N>
+mat<T,N,N> mulSym(mat<T,N,N> const & a, mat<T,N,N> const & b) {
+	mat<T,N,N> r;
+	for (int i = 0; i < N; ++i) {
+		for (int j = i; j < N; ++j) {
+			T sum = {};
+			for (int k = 0; k < N; ++k) {
+				sum += a(i,k) * b(k,j);
+			}
+			r(i,j) = r(j,i) = sum;
+		}
+	}
+	return r;
+}
+
+template<typename T, int N>
+mat<T,N,N> mul(mat<T,N,N> const & a, mat<T,N,N> const & b, bool symmetric) {
+	return symmetric ? mulSym(a, b) : a * b;
+}
+
+// solve d x = n by LU with partial pivoting.  d is V - U of the Pade approximant, which is well conditioned when the norm is under theta_m.
+template<typename T, int N>
+mat<T,N,N> solve(mat<T,N,N> d, mat<T,N,N> n) {
+	for (int k = 0; k < N; ++k) {
+		int p = k;
+		for (int i = k + 1; i < N; ++i) {
+			if (std::abs(d(i,k)) > std::abs(d(p,k))) p = i;
+		}
+		if (p != k) {
+			std::swap(d[p], d[k]);
+			std::swap(n[p], n[k]);
+		}
+		T const inv = 1 / d(k,k);
+		for (int i = k + 1; i < N; ++i) {
+			T const f = d(i,k) * inv;
+			if (f == 0) continue;
+			for (int j = k; j < N; ++j) d(i,j) -= f * d(k,j);
+			n[i] -= n[k] * f;
+		}
+	}
+	for (int k = N - 1; k >= 0; --k) {
+		for (int j = k + 1; j < N; ++j) {
+			n[k] -= n[j] * d(k,j);
+		}
+		n[k] /= d(k,k);
+	}
+	return n;
+}
+
+/*
+odd part U and even part V of the degree m approximant, exp(a) ~ (V - U)^-1 (V + U)
+evenSym: a is symmetric or antisymmetric, so a2, a4, a6 and V are symmetric, and those products only compute their upper triangle.
+aSym: a itself is symmetric, so U is too.
+*/
+template<int m, typename T, int N>
+void padeUV(mat<T,N,N> const & a, bool aSym, bool evenSym, mat<T,N,N> & u, mat<T,N,N> & v) {
+	constexpr auto b = [](int j) { return (T)padeCoeff<m>(j); };
+	auto const I = mat<T,N,N>([](int i, int j) -> T { return i == j; });
+	auto const a2 = mul(a, a, evenSym);
+	if constexpr (m == 13) {
+		auto const a4 = mul(a2, a2, evenSym);
+		auto const a6 = mul(a4, a2, evenSym);
+		u = mul(a, mul(a6, a6 * b(13) + a4 * b(11) + a2 * b(9), evenSym) + a6 * b(7) + a4 * b(5) + a2 * b(3) + I * b(1), aSym);
+		v = mul(a6, a6 * b(12) + a4 * b(10) + a2 * b(8), evenSym) + a6 * b(6) + a4 * b(4) + a2 * b(2) + I * b(0);
+	} else {
+		// sum the even powers up to a^(m-1), then one multiply by a for the odd part
+		mat<T,N,N> uEven = I * b(1);
+		v = I * b(0);
+		mat<T,N,N> p = I;
+		for (int j = 2; j <= m; j += 2) {
+			p = j == 2 ? a2 : mul(p, a2, evenSym);
+			uEven += p * b(j + 1);
+			v += p * b(j);
+		}
+		u = mul(a, uEven, aSym);
+	}
+}
+
+template<int m, typename T, int N>
+mat<T,N,N> padeExp(mat<T,N,N> const & a, bool aSym, bool evenSym) {
+	mat<T,N,N> u, v;
+	padeUV<m>(a, aSym, evenSym, u, v);
+	return solve<T,N>(v - u, v + u);
+}
+
+template<typename T, int N, size_t... is>
+mat<T,N,N> padeExpOfDegree(int degree, mat<T,N,N> const & a, bool aSym, bool evenSym, std::index_sequence<is...>) {
+	using D = PadeDegrees<T>;
+	mat<T,N,N> result;
+	((degree == D::degree[is] ? (result = padeExp<D::degree[is]>(a, aSym, evenSym), true) : false) || ...);
+	return result;
+}
+
+// pick the lowest degree that's accurate for a's norm, else scale a down to the top degree's and square back up
+template<typename T, int N>
+mat<T,N,N> exp(mat<T,N,N> a, bool aSym, bool evenSym) {
+	using D = PadeDegrees<T>;
+	T const norm = norm1(a);
+	for (int i = 0; i < D::count - 1; ++i) {
+		if (norm <= D::theta[i]) {
+			return padeExpOfDegree(D::degree[i], a, aSym, evenSym, std::make_index_sequence<D::count>());
+		}
+	}
+	constexpr int degree = D::degree[D::count - 1];
+	int s = 0;
+	if (norm > D::theta[D::count - 1]) {
+		s = (int)std::ceil(std::log2(norm / D::theta[D::count - 1]));
+		a *= std::ldexp((T)1, -s);
+	}
+	auto r = padeExp<degree>(a, aSym, evenSym);
+	for (int i = 0; i < s; ++i) {
+		// exp of a sym is sym, exp of an asym isn't
+		r = mul(r, r, aSym);
+	}
+	return r;
+}
+
+}
+
+// Rodrigues: exp(w^) = I + sin(t)/t w^ + (1 - cos(t))/t^2 w^ w^, t = |w|
+template<typename T>
+mat3x3<T> exp(asym<T,3> const & w) {
+	auto const v = MatrixExpDetail::asymToVec(w);
+	T const theta = v.length();
+	T a, b;
+	MatrixExpDetail::rodriguesCoeffs(theta, a, b);
+	// w^ w^ = w w^T - t^2 I
+	return mat3x3<T>{
+		{1 + b * (v.x * v.x - theta * theta), b * v.x * v.y - a * v.z, b * v.x * v.z + a * v.y},
+		{b * v.y * v.x + a * v.z, 1 + b * (v.y * v.y - theta * theta), b * v.y * v.z - a * v.x},
+		{b * v.z * v.x - a * v.y, b * v.z * v.y + a * v.x, 1 + b * (v.z * v.z - theta * theta)},
+	};
+}
+
+// the same rotation as a unit quat: (sin(t/2)/t w, cos(t/2))
+template<typename T>
+quat<T> expQuat(asym<T,3> const & w) {
+	auto const v = MatrixExpDetail::asymToVec(w);
+	T const half = v.length() / 2;
+	T a, b;
+	MatrixExpDetail::rodriguesCoeffs(half, a, b);
+	a /= 2;
+	return quat<T>(v.x * a, v.y * a, v.z * a, std::cos(half));
+}
+
+/*
+inverse of exp(asym3), for a rotation matrix.  the angle comes back in [0, pi].
+goes through quat::fromMatrix, so it's fine near pi, where the antisymmetric part of r vanishes.
+*/
+template<typename T>
+asym<T,3> logRotation(mat3x3<T> const & r) {
+	auto q = quat<T>::fromMatrix(r);
+	if (q.w < 0) q = -q;
+	T const s = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+	// t = 2 atan2(s, w), and w = t / s * q.xyz, with t / s -> 2 / w as s -> 0
+	T const f = s < std::numeric_limits<T>::epsilon() ? 2 / q.w : 2 * std::atan2(s, q.w) / s;
+	asym<T,3> w;
+	w(2,1) = q.x * f;
+	w(0,2) = q.y * f;
+	w(1,0) = q.z * f;
+	return w;
+}
+
+// exp of a general square matrix by scaling and squaring
+template<typename T, int N>
+mat<T,N,N> exp(mat<T,N,N> const & a) {
+	return MatrixExpDetail::exp<T,N>(a, false, false);
+}
+
+// exp of a symmetric matrix is symmetric
+template<typename T, int N>
+sym<T,N> exp(sym<T,N> const & a) {
+	auto const r = MatrixExpDetail::exp<T,N>(mat<T,N,N>([&](int i, int j) -> T { return a(i,j); }), true, true);
+	return sym<T,N>([&](int i, int j) -> T { return r(i,j); });
+}
+
+// exp of an antisymmetric matrix is orthogonal.  asym<T,3> has the closed form above.
+template<typename T, int N>
+mat<T,N,N> exp(asym<T,N> const & a) {
+	return MatrixExpDetail::exp<T,N>(mat<T,N,N>([&](int i, int j) -> T { return a(i,j); }), false, true);
+}
+
+}
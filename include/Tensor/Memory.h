@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*
+memory resources and allocators for Grid's Allocator parameter
+
+Grid defaults to std::pmr::polymorphic_allocator, so for example:
+	RecyclingResource pool(alignedResource);
+	Grid<float3, 3> g(size, std::pmr::polymorphic_allocator<float3>(&pool));
+*/
+
+namespace Tensor {
+
+inline constexpr size_t cacheLineSize = 64;
+inline constexpr size_t hugePageSize = 2 << 20;
+
+/*
+over-aligns everything it hands out, e.g. to a cache line or a SIMD width
+and optionally asks for transparent huge pages on blocks of at least hugePageSize (linux only, otherwise it's ignored)
+*/
+struct AlignedResource : public std::pmr::memory_resource {
+	size_t alignment = cacheLineSize;
+	bool hugePages = {};
+	std::pmr::memory_resource * upstream = {};
+
+	AlignedResource(
+		size_t alignment_ = cacheLineSize,
+		bool hugePages_ = false,
+		std::pmr::memory_resource * upstream_ = std::pmr::new_delete_resource()
+	) : alignment(alignment_), hugePages(hugePages_), upstream(upstream_) {}
+
+protected:
+	size_t alignmentFor(size_t bytes, size_t align) const {
+		size_t a = std::max(align, alignment);
+		if (hugePages && bytes >= hugePageSize) a = std::max(a, hugePageSize);
+		return a;
+	}
+
+	void * do_allocate(size_t bytes, size_t align) override {
+		void * p = upstream->allocate(bytes, alignmentFor(bytes, align));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		if (hugePages && bytes >= hugePageSize) {
+			// just a hint, don't care if it fails
+			madvise(p, bytes - bytes % hugePageSize, MADV_HUGEPAGE);
+		}
+#endif
+		return p;
+	}
+
+	void do_deallocate(void * p, size_t bytes, size_t align) override {
+		upstream->deallocate(p, bytes, alignmentFor(bytes, align));
+	}
+
+	bool do_is_equal(std::pmr::memory_resource const & o) const noexcept override {
+		return this == &o;
+	}
+};
+
+/*
+keeps freed blocks around and hands them back for the next allocation of the same size and alignment
+for grids that get reallocated every timestep at the same few sizes.
+thread-safe.
+blocks past maxCachedBytes go straight back upstream.  release() (or the dtor) frees everything cached.
+*/
+struct RecyclingResource : public std::pmr::memory_resource {
+	std::pmr::memory_resource * upstream = {};
+	size_t maxCachedBytes = {};
+
+	std::mutex mutex;
+	size_t cachedBytes = {};
+	std::map<std::pair<size_t, size_t>, std::vector<void*>> freeBlocks;	// (bytes, align) => blocks
+
+	RecyclingResource(
+		std::pmr::memory_resource * upstream_ = std::pmr::new_delete_resource(),
+		size_t maxCachedBytes_ = (size_t)-1
+	) : upstream(upstream_), maxCachedBytes(maxCachedBytes_) {}
+
+	~RecyclingResource() {
+		release();
+	}
+
+	void release() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto & [key, blocks] : freeBlocks) {
+			for (auto p : blocks) {
+				upstream->deallocate(p, key.first, key.second);
+			}
+		}
+		freeBlocks.clear();
+		cachedBytes = 0;
+	}
+
+	size_t getCachedBytes() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return cachedBytes;
+	}
+
+protected:
+	void * do_allocate(size_t bytes, size_t align) override {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto i = freeBlocks.find({bytes, align});
+			if (i != freeBlocks.end() && !i->second.empty()) {
+				void * p = i->second.back();
+				i->second.pop_back();
+				cachedBytes -= bytes;
+				return p;
+			}
+		}
+		return upstream->allocate(bytes, align);
+	}
+
+	void do_deallocate(void * p, size_t bytes, size_t align) override {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (cachedBytes + bytes <= maxCachedBytes) {
+				freeBlocks[{bytes, align}].push_back(p);
+				cachedBytes += bytes;
+				return;
+			}
+		}
+		upstream->deallocate(p, bytes, align);
+	}
+
+	bool do_is_equal(std::pmr::memory_resource const & o) const noexcept override {
+		return this == &o;
+	}
+};
+
+// plain stateless allocator with a fixed alignment, if you want alignment without the pmr indirection
+template<typename T, size_t alignment = cacheLineSize>
+struct AlignedAllocator {
+	using value_type = T;
+	static constexpr size_t align = std::max(alignment, alignof(T));
+
+	template<typename U>
+	struct rebind {
+		using other = AlignedAllocator<U, alignment>;
+	};
+
+	constexpr AlignedAllocator() noexcept {}
+	template<typename U>
+	constexpr AlignedAllocator(AlignedAllocator<U, alignment> const &) noexcept {}
+
+	T * allocate(size_t n) {
+		return (T*)::operator new(n * sizeof(T), std::align_val_t(align));
+	}
+
+	void deallocate(T * p, size_t) noexcept {
+		::operator delete((void*)p, std::align_val_t(align));
+	}
+
+	template<typename U>
+	constexpr bool operator==(AlignedAllocator<U, alignment> const &) const noexcept { return true; }
+};
+
+}
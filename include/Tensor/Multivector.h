@@ -0,0 +1,478 @@
+#pragma once
+
+/*
+geometric algebra multivectors, stored as exterior algebra forms
+
+multivector<T, dim, Metric, grades> keeps one block per grade it has:
+grade 0 is a T, 1 is a vec<T,dim>, 2 is an asym<T,dim>, k >= 3 is an asymR<T,dim,k>.
+a block's components are its stored (sorted-index) components, so the grade-2 block's s[w] is the coefficient of e_i ^ e_j for i < j,
+which is also what wedge() of two vecs gives.  so grade<2>()(i,j) reads and writes the way any asym does.
+
+'grades' is a bitmask of the grades present, so rotors (even grades) and vectors don't carry the others around,
+and products only compute the grades they can produce.
+
+products are tables built at compile time from the blade bitmasks of both operands' components:
+each term is one (component of a, component of b, component of result, sign) with a nonzero sign,
+and the term list is unrolled, so no zero products and no index arithmetic happen at runtime.
+
+Metric is MetricSignature<p, q, r>: p basis vectors square to 1, then q to -1, then r to 0.
+*/
+
+#include "Tensor/Tensor.h"
+#include "Common/Exception.h"
+#include <array>
+#include <bit>
+#include <tuple>
+#include <utility>
+
+namespace Tensor {
+
+template<int p, int q = 0, int r = 0>
+struct MetricSignature {
+	static constexpr int dim = p + q + r;
+	// e_i e_i
+	static constexpr int square(int i) { return i < p ? 1 : (i < p + q ? -1 : 0); }
+};
+
+namespace MultivectorDetail {
+
+template<typename T, int dim, int k> struct GradeBlockImpl { using type = asymR<T, dim, k>; };
+template<typename T, int dim> struct GradeBlockImpl<T, dim, 0> { using type = T; };
+template<typename T, int dim> struct GradeBlockImpl<T, dim, 1> { using type = vec<T, dim>; };
+template<typename T, int dim> struct GradeBlockImpl<T, dim, 2> { using type = asym<T, dim>; };
+
+template<typename T, int dim, int k>
+using GradeBlock = typename GradeBlockImpl<T, dim, k>::type;
+
+constexpr bool hasGrade(unsigned grades, int k) { return (grades >> k) & 1; }
+
+// where each component of a multivector with these grades lives, and which blade it's the coefficient of
+template<int dim, unsigned grades>
+struct Layout {
+	static constexpr int count = []{
+		int n = 0;
+		for (int k = 0; k <= dim; ++k) {
+			if (hasGrade(grades, k)) n += nChooseR(dim, k);
+		}
+		return n;
+	}();
+
+	// blade bitmask of the w'th stored component of grade k
+	template<int k>
+	static constexpr int bladeBits(int w) {
+		if constexpr (k == 0) {
+			return 0;
+		} else if constexpr (k == 1) {
+			return 1 << w;
+		} else {
+			auto const i = GradeBlock<int, dim, k>::getLocalReadForWriteIndex(w);
+			int bits = 0;
+			for (int j = 0; j < k; ++j) bits |= 1 << i[j];
+			return bits;
+		}
+	}
+
+	struct Slot {
+		int blade = {};
+		int grade = {};
+		int index = {};	// within the grade's block
+	};
+
+	static constexpr std::array<Slot, count> slots = []{
+		std::array<Slot, count> s = {};
+		int n = 0;
+		[&]<int... k>(std::integer_sequence<int, k...>) {
+			([&]{
+				if constexpr (hasGrade(grades, k)) {
+					for (int w = 0; w < nChooseR(dim, k); ++w) {
+						s[n++] = {bladeBits<k>(w), k, w};
+					}
+				}
+			}(), ...);
+		}(std::make_integer_sequence<int, dim + 1>{});
+		return s;
+	}();
+
+	// slot of a blade, or -1 if its grade isn't here
+	static constexpr int slotOf(int blade) {
+		for (int i = 0; i < count; ++i) {
+			if (slots[i].blade == blade) return i;
+		}
+		return -1;
+	}
+
+	// position of grade k's block in the tuple
+	static constexpr int blockIndex(int k) {
+		return std::popcount(grades & ((1u << k) - 1));
+	}
+};
+
+// sign from moving the vectors of blade b past those of blade a into sorted order
+constexpr int reorderSign(int a, int b) {
+	int swaps = 0;
+	for (a >>= 1; a; a >>= 1) swaps += std::popcount((unsigned)(a & b));
+	return swaps & 1 ? -1 : 1;
+}
+
+enum class Product {
+	Geometric,
+	Outer,
+	LeftContraction,
+};
+
+// a * b's sign, or 0 if the blades' product isn't part of this kind of product
+template<typename Metric>
+constexpr int productSign(Product kind, int a, int b) {
+	if (kind == Product::Outer && (a & b)) return 0;
+	if (kind == Product::LeftContraction && (a & b) != a) return 0;
+	int sign = reorderSign(a, b);
+	for (int i = 0, common = a & b; common; ++i, common >>= 1) {
+		if (common & 1) sign *= Metric::square(i);
+	}
+	return sign;
+}
+
+template<int dim, typename Metric, Product kind, unsigned gradesA, unsigned gradesB>
+constexpr unsigned productGrades() {
+	using LA = Layout<dim, gradesA>;
+	using LB = Layout<dim, gradesB>;
+	unsigned grades = 0;
+	for (auto const & a : LA::slots) {
+		for (auto const & b : LB::slots) {
+			if (productSign<Metric>(kind, a.blade, b.blade)) grades |= 1u << std::popcount((unsigned)(a.blade ^ b.blade));
+		}
+	}
+	return grades;
+}
+
+struct Term {
+	int a = {}, b = {}, r = {};	// slots
+	int sign = {};
+};
+
+// the nonzero terms of a (kind) b, keeping only the result grades in gradesR
+template<int dim, typename Metric, Product kind, unsigned gradesA, unsigned gradesB, unsigned gradesR>
+struct ProductTable {
+	using LA = Layout<dim, gradesA>;
+	using LB = Layout<dim, gradesB>;
+	using LR = Layout<dim, gradesR>;
+
+	static constexpr Term term(int i, int j) {
+		int const sign = productSign<Metric>(kind, LA::slots[i].blade, LB::slots[j].blade);
+		if (!sign) return {};
+		int const r = LR::slotOf(LA::slots[i].blade ^ LB::slots[j].blade);
+		if (r < 0) return {};
+		return {i, j, r, sign};
+	}
+
+	static constexpr int count = []{
+		int n = 0;
+		for (int i = 0; i < LA::count; ++i) {
+			for (int j = 0; j < LB::count; ++j) {
+				if (term(i, j).sign) ++n;
+			}
+		}
+		return n;
+	}();
+
+	static constexpr std::array<Term, count> terms = []{
+		std::array<Term, count> t = {};
+		int n = 0;
+		for (int i = 0; i < LA::count; ++i) {
+			for (int j = 0; j < LB::count; ++j) {
+				auto const x = term(i, j);
+				if (x.sign) t[n++] = x;
+			}
+		}
+		return t;
+	}();
+};
+
+}
+
+template<
+	typename T,
+	int dim_,
+	typename Metric_ = MetricSignature<dim_>,
+	unsigned grades_ = (1u << (dim_ + 1)) - 1
+>
+struct multivector {
+	using Scalar = T;
+	using Metric = Metric_;
+	static constexpr int dim = dim_;
+	static constexpr unsigned grades = grades_;
+	static_assert(Metric::dim == dim, "metric signature doesn't match the dimension");
+	static_assert(dim > 0 && dim < 16, "blades are bitmasks of the basis vectors");
+	static_assert((grades >> (dim + 1)) == 0, "grades past the dimension");
+
+	using Layout = MultivectorDetail::Layout<dim, grades>;
+	static constexpr int count = Layout::count;
+
+	template<int k>
+	static constexpr bool hasGrade = MultivectorDetail::hasGrade(grades, k);
+
+	template<int k>
+	using GradeBlock = MultivectorDetail::GradeBlock<T, dim, k>;
+
+	using Blocks = decltype([]<int... k>(std::integer_sequence<int, k...>) {
+		return std::tuple_cat(std::conditional_t<MultivectorDetail::hasGrade(grades, k), std::tuple<GradeBlock<k>>, std::tuple<>>()...);
+	}(std::make_integer_sequence<int, dim + 1>{}));
+
+	Blocks blocks = {};
+
+	constexpr multivector() {}
+
+	multivector(T const & s) requires (hasGrade<0>) { grade<0>() = s; }
+	multivector(vec<T, dim> const & v) requires (hasGrade<1>) { grade<1>() = v; }
+
+	// from other grades: the ones in common are copied, the rest are zero
+	template<unsigned grades2>
+	requires (grades2 != grades)
+	explicit multivector(multivector<T, dim, Metric, grades2> const & o) {
+		forEachComponent([&](int blade, T & x) {
+			x = o.component(blade);
+		});
+	}
+
+	// e_i
+	static multivector basis(int i) requires (hasGrade<1>) {
+		multivector m;
+		m.template grade<1>()[i] = 1;
+		return m;
+	}
+
+	// the T, vec, asym or asymR of grade k
+	// by value on temporaries, so (a * b).scalar() doesn't dangle
+	template<int k> requires (hasGrade<k>)
+	GradeBlock<k> & grade() & { return std::get<Layout::blockIndex(k)>(blocks); }
+
+	template<int k> requires (hasGrade<k>)
+	GradeBlock<k> const & grade() const & { return std::get<Layout::blockIndex(k)>(blocks); }
+
+	template<int k> requires (hasGrade<k>)
+	GradeBlock<k> grade() && { return std::get<Layout::blockIndex(k)>(blocks); }
+
+	T & scalar() & requires (hasGrade<0>) { return grade<0>(); }
+	T const & scalar() const & requires (hasGrade<0>) { return grade<0>(); }
+	T scalar() && requires (hasGrade<0>) { return grade<0>(); }
+
+	// component by slot, for the product tables
+	template<int slot>
+	T & at() {
+		constexpr auto s = Layout::slots[slot];
+		if constexpr (s.grade == 0) {
+			return grade<0>();
+		} else {
+			return grade<s.grade>().s[s.index];
+		}
+	}
+
+	template<int slot>
+	T const & at() const {
+		return const_cast<multivector &>(*this).template at<slot>();
+	}
+
+	// f(int blade, T & x) for every stored component
+	template<typename F>
+	void forEachComponent(F && f) {
+		[&]<int... i>(std::integer_sequence<int, i...>) {
+			(f(Layout::slots[i].blade, at<i>()), ...);
+		}(std::make_integer_sequence<int, count>{});
+	}
+
+	template<typename F>
+	void forEachComponent(F && f) const {
+		[&]<int... i>(std::integer_sequence<int, i...>) {
+			(f(Layout::slots[i].blade, at<i>()), ...);
+		}(std::make_integer_sequence<int, count>{});
+	}
+
+	// coefficient of the blade with basis vector bitmask 'blade', 0 if its grade isn't stored
+	T component(int blade) const {
+		T result = {};
+		forEachComponent([&](int b, T const & x) {
+			if (b == blade) result = x;
+		});
+		return result;
+	}
+
+	// (-1)^(k(k-1)/2) on grade k: reverses the order of the vectors in each blade
+	multivector reverse() const {
+		multivector r = *this;
+		r.forEachComponent([](int blade, T & x) {
+			int const k = std::popcount((unsigned)blade);
+			if ((k * (k - 1) / 2) & 1) x = -x;
+		});
+		return r;
+	}
+
+	// (-1)^k on grade k
+	multivector involute() const {
+		multivector r = *this;
+		r.forEachComponent([](int blade, T & x) {
+			if (std::popcount((unsigned)blade) & 1) x = -x;
+		});
+		return r;
+	}
+
+	// scalar part of x ~x.  the sum of squares for euclidean metrics.
+	T normSq() const;
+
+	multivector operator-() const {
+		multivector r = *this;
+		r.forEachComponent([](int, T & x) { x = -x; });
+		return r;
+	}
+
+	multivector & operator+=(multivector const & o) {
+		[&]<int... i>(std::integer_sequence<int, i...>) {
+			((at<i>() += o.template at<i>()), ...);
+		}(std::make_integer_sequence<int, count>{});
+		return *this;
+	}
+
+	multivector & operator-=(multivector const & o) {
+		[&]<int... i>(std::integer_sequence<int, i...>) {
+			((at<i>() -= o.template at<i>()), ...);
+		}(std::make_integer_sequence<int, count>{});
+		return *this;
+	}
+
+	multivector & operator*=(T const & s) {
+		forEachComponent([&](int, T & x) { x *= s; });
+		return *this;
+	}
+
+	multivector & operator/=(T const & s) {
+		forEachComponent([&](int, T & x) { x /= s; });
+		return *this;
+	}
+
+	bool operator==(multivector const & o) const {
+		bool eq = true;
+		[&]<int... i>(std::integer_sequence<int, i...>) {
+			((eq = eq && at<i>() == o.template at<i>()), ...);
+		}(std::make_integer_sequence<int, count>{});
+		return eq;
+	}
+	bool operator!=(multivector const & o) const { return !operator==(o); }
+};
+
+// even grades
+template<typename T, int dim, typename Metric = MetricSignature<dim>>
+using rotor = multivector<T, dim, Metric, 0x55555555u & ((1u << (dim + 1)) - 1)>;
+
+/*
+a (kind) b, only for the result grades in gradesR
+gradesR defaults to every grade the product can make
+*/
+template<
+	MultivectorDetail::Product kind,
+	unsigned gradesR = 0,
+	typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB
+>
+auto product(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	constexpr unsigned gradesOut = gradesR ? gradesR : MultivectorDetail::productGrades<dim, Metric, kind, gradesA, gradesB>();
+	using Table = MultivectorDetail::ProductTable<dim, Metric, kind, gradesA, gradesB, gradesOut>;
+	multivector<T, dim, Metric, gradesOut> r;
+	[&]<int... i>(std::integer_sequence<int, i...>) {
+		([&]{
+			constexpr auto t = Table::terms[i];
+			if constexpr (t.sign > 0) {
+				r.template at<t.r>() += a.template at<t.a>() * b.template at<t.b>();
+			} else {
+				r.template at<t.r>() -= a.template at<t.a>() * b.template at<t.b>();
+			}
+		}(), ...);
+	}(std::make_integer_sequence<int, Table::count>{});
+	return r;
+}
+
+// geometric product
+template<typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB>
+auto operator*(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	return product<MultivectorDetail::Product::Geometric>(a, b);
+}
+
+// outer product
+template<typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB>
+auto wedge(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	return product<MultivectorDetail::Product::Outer>(a, b);
+}
+
+// inner product, as the left contraction: grade(b) - grade(a) parts, zero where grade(a) > grade(b)
+template<typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB>
+auto inner(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	return product<MultivectorDetail::Product::LeftContraction>(a, b);
+}
+
+/*
+R x ~R, kept to x's grades
+for a versor R (a rotor, say) that's all there is, so the second product only computes those.
+*/
+template<typename T, int dim, typename Metric, unsigned gradesR, unsigned gradesX>
+multivector<T, dim, Metric, gradesX> sandwich(multivector<T, dim, Metric, gradesR> const & r, multivector<T, dim, Metric, gradesX> const & x) {
+	return product<MultivectorDetail::Product::Geometric, gradesX>(r * x, r.reverse());
+}
+
+template<typename T, int dim, typename Metric, unsigned grades>
+T multivector<T, dim, Metric, grades>::normSq() const {
+	return product<MultivectorDetail::Product::Geometric, 1>(*this, reverse()).scalar();
+}
+
+template<typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB>
+auto operator+(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	using R = multivector<T, dim, Metric, gradesA | gradesB>;
+	R r;
+	if constexpr (gradesA == (gradesA | gradesB)) r = a; else r = R(a);
+	if constexpr (gradesB == (gradesA | gradesB)) r += b; else r += R(b);
+	return r;
+}
+
+template<typename T, int dim, typename Metric, unsigned gradesA, unsigned gradesB>
+auto operator-(multivector<T, dim, Metric, gradesA> const & a, multivector<T, dim, Metric, gradesB> const & b) {
+	return a + -b;
+}
+
+template<typename T, int dim, typename Metric, unsigned grades>
+multivector<T, dim, Metric, grades> operator*(multivector<T, dim, Metric, grades> a, std::type_identity_t<T> const & s) {
+	return a *= s;
+}
+
+template<typename T, int dim, typename Metric, unsigned grades>
+multivector<T, dim, Metric, grades> operator*(std::type_identity_t<T> const & s, multivector<T, dim, Metric, grades> a) {
+	return a *= s;
+}
+
+template<typename T, int dim, typename Metric, unsigned grades>
+multivector<T, dim, Metric, grades> operator/(multivector<T, dim, Metric, grades> a, std::type_identity_t<T> const & s) {
+	return a /= s;
+}
+
+// like quat's: "1 + 2*e_0 + 3*e_01"
+template<typename T, int dim, typename Metric, unsigned grades>
+std::ostream & operator<<(std::ostream & o, multivector<T, dim, Metric, grades> const & m) {
+	char const * sep = "";
+	m.forEachComponent([&](int blade, T const & x) {
+		if (x == T{}) return;
+		o << sep;
+		if (!blade) {
+			o << x;
+		} else {
+			if (x == -1) {
+				o << "-";
+			} else if (x != 1) {
+				o << x << "*";
+			}
+			o << "e_";
+			for (int i = 0; i < dim; ++i) {
+				if (blade & (1 << i)) o << i;
+			}
+		}
+		sep = " + ";
+	});
+	if (!*sep) o << "0";
+	return o;
+}
+
+}
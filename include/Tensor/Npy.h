@@ -0,0 +1,698 @@
+#pragma once
+
+#include "Tensor/Grid.h"
+#include "Tensor/Signature.h"
+#include "Tensor/Checksum.h"
+#include "Tensor/MappedGrid.h"
+#include "Common/Exception.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+NumPy .npy / .npz reading and writing, no dependencies
+
+a Grid<T, rank> goes to an array of shape (size[rank-1], ..., size[0], <cell dims>)
+since Grid is index-0-fastest and numpy is last-axis-fastest, so the bytes line up and np.load gives you a[z,y,x].
+cell dims are either
+	NpyLayout::Expanded: the tensor's full dims, i.e. a sym3 is (3, 3).  the default, since it's what numpy code expects.
+	NpyLayout::Stored: just the stored scalars, i.e. a sym3 is (6,) in storage order.  smaller, and always the same bytes as the Grid.
+readers take either, telling them apart by the shape.
+
+mapNpy() is the zero-copy path: it mmaps the file and gives you a MappedGrid with a non-owning Grid into it,
+as long as the bytes on disk are already exactly our layout (native byte order, C order, and Stored or an Expanded that's the same thing, like float3x3).
+
+.npz is a zip of .npy's.  we write them uncompressed (like np.savez) and read uncompressed ones.
+*/
+
+namespace Tensor {
+
+enum class NpyLayout { Expanded, Stored };
+
+// '<f4' etc
+template<typename Scalar>
+std::string npyDescr() {
+	static_assert(std::is_arithmetic_v<Scalar>, "npy only does arithmetic scalars");
+	char const order = sizeof(Scalar) == 1 ? '|' : (std::endian::native == std::endian::little ? '<' : '>');
+	char const kind = std::is_same_v<Scalar, bool> ? 'b' : std::is_floating_point_v<Scalar> ? 'f' : std::is_signed_v<Scalar> ? 'i' : 'u';
+	return std::string() + order + kind + std::to_string(sizeof(Scalar));
+}
+
+/*
+how a cell maps between its stored scalars and its expanded (full dims, C order) scalars
+tables are built once per type by probing a double-valued copy of the type with 1, 2, 3... in its storage.
+*/
+template<typename T>
+struct NpyCell {
+	using Scalar = StorageScalar<T>;
+	static constexpr int storedCount = storedScalarCount<T>();
+
+	struct Entry {
+		int index = {};	// stored index when expanding, expanded index when collapsing
+		Scalar sign = {};	// 1, -1 for antisymmetric, 0 for the zero parts
+	};
+
+	struct Tables {
+		std::vector<int64_t> dims;	// expanded cell dims
+		std::vector<Entry> expand;	// per expanded scalar
+		std::vector<Entry> collapse;	// per stored scalar
+		bool expandedIsStored = {};
+	};
+
+	static Tables const & tables() {
+		static Tables const t = makeTables();
+		return t;
+	}
+
+	static Tables makeTables() {
+		Tables t;
+		if constexpr (!is_tensor_v<T>) {
+			t.expand = {{0, 1}};
+			t.collapse = {{0, 1}};
+		} else {
+			using Probe = typename T::template ReplaceScalar<double>;
+			static_assert(sizeof(Probe) == storedCount * sizeof(double));
+			constexpr int rank = T::rank;
+			auto const dims = T::dims();
+			for (int j = 0; j < rank; ++j) {
+				t.dims.push_back(dims[j]);
+			}
+			Probe probe;
+			double values[storedCount];
+			for (int k = 0; k < storedCount; ++k) {
+				values[k] = k + 1;
+			}
+			std::memcpy((void*)&probe, values, sizeof(values));
+
+			intN<rank> cstep;
+			cstep[rank-1] = 1;
+			for (int j = rank-2; j >= 0; --j) {
+				cstep[j] = cstep[j+1] * dims[j+1];
+			}
+			t.expand.resize(dims.product());
+			t.collapse.resize(storedCount, {-1, 0});
+			for (auto i : RangeObj<rank, false>(intN<rank>(), dims)) {
+				double const v = (double)probe(i);
+				int const e = i.dot(cstep);
+				if (v == 0) {
+					t.expand[e] = {0, 0};
+				} else {
+					int const k = (int)std::abs(v) - 1;
+					Scalar const sign = v > 0 ? 1 : -1;
+					t.expand[e] = {k, sign};
+					if (t.collapse[k].index < 0) t.collapse[k] = {e, sign};
+				}
+			}
+		}
+		t.expandedIsStored = (int)t.expand.size() == storedCount;
+		for (int e = 0; t.expandedIsStored && e < (int)t.expand.size(); ++e) {
+			t.expandedIsStored = t.expand[e].index == e && t.expand[e].sign == 1;
+		}
+		return t;
+	}
+
+	static std::vector<int64_t> cellDims(NpyLayout layout) {
+		if constexpr (!is_tensor_v<T>) return {};
+		if (layout == NpyLayout::Stored) return {storedCount};
+		return tables().dims;
+	}
+
+	static int cellCount(NpyLayout layout) {
+		return layout == NpyLayout::Stored ? storedCount : (int)tables().expand.size();
+	}
+
+	static void expand(T const & t, Scalar * out) {
+		Scalar s[storedCount];
+		std::memcpy(s, (void const *)&t, sizeof(s));
+		for (auto const & x : tables().expand) {
+			*out++ = x.sign * s[x.index];
+		}
+	}
+
+	static void collapse(Scalar const * in, T & t) {
+		Scalar s[storedCount];
+		int k = 0;
+		for (auto const & x : tables().collapse) {
+			s[k++] = x.index < 0 ? Scalar() : x.sign * in[x.index];
+		}
+		std::memcpy((void*)&t, s, sizeof(s));
+	}
+};
+
+struct NpyHeader {
+	std::string descr;
+	bool fortranOrder = {};
+	std::vector<int64_t> shape;
+	size_t dataOffset = {};	// from the start of the .npy
+
+	char order() const { return descr.empty() ? 0 : descr[0]; }
+	std::string kindAndSize() const { return descr.size() > 1 ? descr.substr(1) : std::string(); }
+	bool swapped() const {
+		char const foreign = std::endian::native == std::endian::little ? '>' : '<';
+		return order() == foreign;
+	}
+	int64_t count() const {
+		int64_t n = 1;
+		for (auto s : shape) n *= s;
+		return n;
+	}
+};
+
+namespace NpyDetail {
+
+inline constexpr char magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+inline void writeBytes(std::ostream & o, void const * p, size_t n) {
+	o.write((char const *)p, (std::streamsize)n);
+	if (!o) throw Common::Exception() << "failed to write " << n << " bytes";
+}
+
+inline void readBytes(std::istream & i, void * p, size_t n) {
+	i.read((char*)p, (std::streamsize)n);
+	if ((size_t)i.gcount() != n) throw Common::Exception() << "unexpected end of npy, wanted " << n << " bytes but got " << i.gcount();
+}
+
+inline void writeHeader(std::ostream & o, std::string const & descr, std::vector<int64_t> const & shape) {
+	std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (";
+	for (size_t j = 0; j < shape.size(); ++j) {
+		dict += std::to_string(shape[j]) + (shape.size() == 1 ? "," : j + 1 < shape.size() ? ", " : "");
+	}
+	dict += "), }";
+	// pad with spaces and a newline so the data starts 64-aligned
+	bool const v2 = dict.size() + 1 + 10 > 65535;
+	size_t const prefix = v2 ? 12 : 10;
+	size_t const total = (prefix + dict.size() + 1 + 63) / 64 * 64;
+	dict.append(total - prefix - dict.size() - 1, ' ');
+	dict += '\n';
+	writeBytes(o, magic, sizeof(magic));
+	uint8_t const version[2] = {(uint8_t)(v2 ? 2 : 1), 0};
+	writeBytes(o, version, 2);
+	uint32_t const len = (uint32_t)dict.size();
+	uint8_t le[4] = {(uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24)};
+	writeBytes(o, le, v2 ? 4 : 2);
+	writeBytes(o, dict.data(), dict.size());
+}
+
+// value of 'key' in the header dict, as text
+inline std::string dictValue(std::string const & dict, std::string const & key) {
+	auto i = dict.find("'" + key + "'");
+	if (i == std::string::npos) throw Common::Exception() << "npy header is missing " << key << ": " << dict;
+	i = dict.find(':', i);
+	if (i == std::string::npos) throw Common::Exception() << "bad npy header: " << dict;
+	++i;
+	while (i < dict.size() && dict[i] == ' ') ++i;
+	size_t end;
+	if (dict[i] == '\'') {
+		end = dict.find('\'', i + 1);
+		if (end == std::string::npos) throw Common::Exception() << "bad npy header: " << dict;
+		return dict.substr(i + 1, end - i - 1);
+	} else if (dict[i] == '(') {
+		end = dict.find(')', i);
+		if (end == std::string::npos) throw Common::Exception() << "bad npy header: " << dict;
+		return dict.substr(i + 1, end - i - 1);
+	}
+	end = dict.find_first_of(",}", i);
+	return dict.substr(i, end - i);
+}
+
+// swap every 'width'-byte word in place
+inline void byteSwapWords(char * p, size_t n, size_t width) {
+	if (width <= 1) return;
+	for (size_t i = 0; i + width <= n; i += width) {
+		std::reverse(p + i, p + i + width);
+	}
+}
+
+// how many rows' worth of scalars to buffer at once
+inline constexpr size_t chunkBytes = 1 << 20;
+
+/*
+forEachRun(run) calls run(T const * p, int n, int stride) for each run of cells in file order
+*/
+template<typename T, typename ForEachRun>
+void writeCells(std::ostream & o, NpyLayout layout, ForEachRun && forEachRun) {
+	using Cell = NpyCell<T>;
+	using Scalar = typename Cell::Scalar;
+	bool const raw = layout == NpyLayout::Stored || Cell::tables().expandedIsStored;
+	int const perCell = Cell::cellCount(layout);
+	std::vector<Scalar> buffer;
+	buffer.reserve(std::max<size_t>(perCell, chunkBytes / sizeof(Scalar)));
+	auto flush = [&]() {
+		writeBytes(o, buffer.data(), buffer.size() * sizeof(Scalar));
+		buffer.clear();
+	};
+	forEachRun([&](T const * p, int n, int stride) {
+		if (raw && stride == 1) {
+			if (!buffer.empty()) flush();
+			writeBytes(o, (void const *)p, n * sizeof(T));
+			return;
+		}
+		for (int k = 0; k < n; ++k) {
+			size_t const at = buffer.size();
+			buffer.resize(at + perCell);
+			if (raw) {
+				std::memcpy(buffer.data() + at, (void const *)(p + k * stride), sizeof(T));
+			} else {
+				Cell::expand(p[k * stride], buffer.data() + at);
+			}
+			if (buffer.size() + perCell > buffer.capacity()) flush();
+		}
+	});
+	if (!buffer.empty()) flush();
+}
+
+template<typename T, typename ForEachRun>
+void readCells(std::istream & i, NpyHeader const & h, NpyLayout layout, ForEachRun && forEachRun) {
+	using Cell = NpyCell<T>;
+	using Scalar = typename Cell::Scalar;
+	bool const raw = layout == NpyLayout::Stored || Cell::tables().expandedIsStored;
+	bool const swapped = h.swapped();
+	int const perCell = Cell::cellCount(layout);
+	std::vector<Scalar> buffer(perCell);
+	forEachRun([&](T * p, int n, int stride) {
+		if (raw && stride == 1) {
+			readBytes(i, (void*)p, n * sizeof(T));
+			if (swapped) byteSwapWords((char*)p, n * sizeof(T), sizeof(Scalar));
+			return;
+		}
+		for (int k = 0; k < n; ++k) {
+			readBytes(i, buffer.data(), perCell * sizeof(Scalar));
+			if (swapped) byteSwapWords((char*)buffer.data(), perCell * sizeof(Scalar), sizeof(Scalar));
+			if (raw) {
+				std::memcpy((void*)(p + k * stride), buffer.data(), sizeof(T));
+			} else {
+				Cell::collapse(buffer.data(), p[k * stride]);
+			}
+		}
+	});
+}
+
+/*
+checks that an npy header can be read as 'rank' axes of T
+returns the layout its cell dims match and the sizes of the leading axes, reversed into Grid order
+*/
+template<typename T>
+std::pair<NpyLayout, std::vector<int64_t>> checkHeader(NpyHeader const & h, int rank) {
+	using Cell = NpyCell<T>;
+	using Scalar = typename Cell::Scalar;
+	std::string const want = npyDescr<Scalar>().substr(1);
+	if (h.kindAndSize() != want) throw Common::Exception() << "npy has dtype " << h.descr << " but we want " << npyDescr<Scalar>();
+	if (h.order() != '<' && h.order() != '>' && h.order() != '|' && h.order() != '=') throw Common::Exception() << "bad npy dtype " << h.descr;
+	if (h.fortranOrder) throw Common::Exception() << "fortran_order npy files aren't supported";
+	if ((int)h.shape.size() < rank) throw Common::Exception() << "npy has " << h.shape.size() << " axes but we need at least " << rank;
+	std::vector<int64_t> const trailing(h.shape.begin() + rank, h.shape.end());
+	NpyLayout layout;
+	if (trailing == Cell::cellDims(NpyLayout::Expanded)) {
+		layout = NpyLayout::Expanded;
+	} else if (trailing == Cell::cellDims(NpyLayout::Stored)) {
+		layout = NpyLayout::Stored;
+	} else {
+		std::ostringstream ss;
+		ss << "npy cell shape (";
+		for (auto s : trailing) ss << s << ",";
+		ss << ") doesn't match " << storageSignature<T>();
+		throw Common::Exception() << ss.str();
+	}
+	std::vector<int64_t> size(h.shape.rend() - rank, h.shape.rend());
+	return {layout, size};
+}
+
+}
+
+template<typename T>
+std::vector<int64_t> npyShape(std::vector<int64_t> size, NpyLayout layout = NpyLayout::Expanded) {
+	std::reverse(size.begin(), size.end());
+	auto const cell = NpyCell<T>::cellDims(layout);
+	size.insert(size.end(), cell.begin(), cell.end());
+	return size;
+}
+
+inline NpyHeader readNpyHeader(std::istream & i) {
+	using namespace NpyDetail;
+	char m[6];
+	readBytes(i, m, 6);
+	if (std::memcmp(m, magic, 6)) throw Common::Exception() << "not an npy file";
+	uint8_t version[2];
+	readBytes(i, version, 2);
+	if (version[0] < 1 || version[0] > 3) throw Common::Exception() << "unknown npy version " << (int)version[0];
+	uint8_t le[4] = {};
+	size_t const lenBytes = version[0] == 1 ? 2 : 4;
+	readBytes(i, le, lenBytes);
+	size_t const len = le[0] | (le[1] << 8) | ((size_t)le[2] << 16) | ((size_t)le[3] << 24);
+	std::string dict(len, ' ');
+	readBytes(i, dict.data(), len);
+
+	NpyHeader h;
+	h.dataOffset = 8 + lenBytes + len;
+	h.descr = dictValue(dict, "descr");
+	h.fortranOrder = dictValue(dict, "fortran_order").find("True") != std::string::npos;
+	std::istringstream shape(dictValue(dict, "shape"));
+	std::string tok;
+	while (std::getline(shape, tok, ',')) {
+		if (tok.find_first_not_of(" ") == std::string::npos) continue;
+		h.shape.push_back(std::stoll(tok));
+	}
+	return h;
+}
+
+// G is a Grid or GridView
+template<typename G>
+void writeNpy(std::ostream & o, G const & g, NpyLayout layout = NpyLayout::Expanded) {
+	using Type = typename G::value_type;
+	constexpr int rank = G::rank;
+	using intN = Tensor::intN<rank>;
+	std::vector<int64_t> size(g.size.s.begin(), g.size.s.end());
+	NpyDetail::writeHeader(o, npyDescr<StorageScalar<Type>>(), npyShape<Type>(size, layout));
+	NpyDetail::writeCells<Type>(o, layout, [&](auto && run) {
+		forEachGridRow(g, intN(), g.size, [&](Type const * p, int n, intN const &) {
+			run(p, n, g.step[0]);
+		});
+	});
+}
+
+// a contiguous array of n tensors, as shape (n, <cell dims>)
+template<typename T>
+void writeNpy(std::ostream & o, T const * p, size_t n, NpyLayout layout = NpyLayout::Expanded) {
+	NpyDetail::writeHeader(o, npyDescr<StorageScalar<T>>(), npyShape<T>({(int64_t)n}, layout));
+	NpyDetail::writeCells<T>(o, layout, [&](auto && run) {
+		for (size_t k = 0; k < n; k += std::numeric_limits<int>::max()) {
+			run(p + k, (int)std::min<size_t>(n - k, std::numeric_limits<int>::max()), 1);
+		}
+	});
+}
+
+// reads into dst, which must already be the right size
+template<typename G>
+void readNpyInto(std::istream & i, G && dst) {
+	using GNoRef = std::remove_reference_t<G>;
+	using Type = typename GNoRef::value_type;
+	constexpr int rank = GNoRef::rank;
+	using intN = Tensor::intN<rank>;
+	auto const h = readNpyHeader(i);
+	auto const [layout, size] = NpyDetail::checkHeader<Type>(h, rank);
+	for (int j = 0; j < rank; ++j) {
+		if (size[j] != dst.size[j]) throw Common::Exception() << "npy has size " << size[j] << " along axis " << j << " but the destination has " << dst.size[j];
+	}
+	NpyDetail::readCells<Type>(i, h, layout, [&](auto && run) {
+		forEachGridRow(dst, intN(), dst.size, [&](Type * p, int n, intN const &) {
+			run(p, n, dst.step[0]);
+		});
+	});
+}
+
+template<typename Type, int rank, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+Grid<Type, rank, Allocator> readNpy(std::istream & i, Allocator const & alloc = {}) {
+	using intN = Tensor::intN<rank>;
+	auto const h = readNpyHeader(i);
+	auto const [layout, size64] = NpyDetail::checkHeader<Type>(h, rank);
+	intN size;
+	for (int j = 0; j < rank; ++j) {
+		if (size64[j] > std::numeric_limits<int>::max()) throw Common::Exception() << "size " << size64[j] << " is too big for a Grid";
+		size[j] = (int)size64[j];
+	}
+	auto g = Grid<Type, rank, Allocator>(size, alloc);
+	NpyDetail::readCells<Type>(i, h, layout, [&](auto && run) {
+		forEachGridRow(g, intN(), g.size, [&](Type * p, int n, intN const &) {
+			run(p, n, 1);
+		});
+	});
+	return g;
+}
+
+// file versions
+
+template<typename G>
+void writeNpy(std::string const & path, G const & g, NpyLayout layout = NpyLayout::Expanded) {
+	std::ofstream o(path, std::ios::binary);
+	if (!o) throw Common::Exception() << "failed to open " << path << " for writing";
+	writeNpy(o, g, layout);
+}
+
+template<typename Type, int rank, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+Grid<Type, rank, Allocator> readNpy(std::string const & path, Allocator const & alloc = {}) {
+	std::ifstream i(path, std::ios::binary);
+	if (!i) throw Common::Exception() << "failed to open " << path;
+	return readNpy<Type, rank, Allocator>(i, alloc);
+}
+
+/*
+zero-copy load: mmap the .npy and point a non-owning Grid at its data
+throws if the file isn't already in our layout, in which case use readNpy
+*/
+template<typename Type, int rank>
+MappedGrid<Type, rank> mapNpy(
+	std::string const & path,
+	typename MappedGrid<Type, rank>::Mode mode = MappedGrid<Type, rank>::Mode::ReadOnly,
+	bool populate = false
+) {
+	using M = MappedGrid<Type, rank>;
+	using Scalar = StorageScalar<Type>;
+	NpyHeader h;
+	{
+		std::ifstream i(path, std::ios::binary);
+		if (!i) throw Common::Exception() << "failed to open " << path;
+		h = readNpyHeader(i);
+	}
+	auto const [layout, size64] = NpyDetail::checkHeader<Type>(h, rank);
+	if (h.swapped() && sizeof(Scalar) > 1) throw Common::Exception() << path << " is in the other byte order, so it can't be mapped.  use readNpy";
+	if (layout == NpyLayout::Expanded && !NpyCell<Type>::tables().expandedIsStored) throw Common::Exception() << path << " is expanded, so it can't be mapped.  use readNpy, or write it with NpyLayout::Stored";
+	if (h.dataOffset % alignof(Type)) throw Common::Exception() << path << "'s data isn't aligned for mapping";
+	intN<rank> size;
+	for (int j = 0; j < rank; ++j) {
+		size[j] = (int)size64[j];
+	}
+
+	M m;
+	m.path = path;
+	m.mode = mode;
+	m.fd = ::open(path.c_str(), mode == M::Mode::ReadWrite ? O_RDWR : O_RDONLY);
+	if (m.fd < 0) throw Common::Exception() << "failed to open " << path << ": " << strerror(errno);
+	size_t const fileBytes = h.dataOffset + (size_t)size.product() * sizeof(Type);
+	struct stat st;
+	if (fstat(m.fd, &st) != 0) throw Common::Exception() << "failed to stat " << path << ": " << strerror(errno);
+	if ((size_t)st.st_size < fileBytes) throw Common::Exception() << path << " is truncated: " << st.st_size << " bytes but the header says " << fileBytes;
+	m.map(size, h.dataOffset, fileBytes, populate);
+	return m;
+}
+
+/*
+.npz writing: an uncompressed zip of .npy's, same as np.savez
+	NpzWriter npz("out.npz");
+	npz.add("rho", rho);
+	npz.add("sigma", sigma, NpyLayout::Stored);
+	npz.close();	// or let the dtor do it
+no zip64, so each array and the whole file have to stay under 4GB
+*/
+struct NpzWriter {
+	struct Entry {
+		std::string name;
+		uint32_t crc = {};
+		uint32_t size = {};
+		uint32_t offset = {};
+	};
+
+	std::ofstream o;
+	std::string path;
+	std::vector<Entry> entries;
+
+	NpzWriter(std::string const & path_) : o(path_, std::ios::binary), path(path_) {
+		if (!o) throw Common::Exception() << "failed to open " << path << " for writing";
+	}
+
+	~NpzWriter() {
+		try {
+			close();
+		} catch (...) {}
+	}
+
+	// name is without the .npy
+	template<typename G>
+	void add(std::string const & name, G const & g, NpyLayout layout = NpyLayout::Expanded) {
+		std::ostringstream npy;
+		writeNpy(npy, g, layout);
+		addFile(name + ".npy", npy.str());
+	}
+
+	void addFile(std::string const & filename, std::string const & data) {
+		if (!o.is_open()) throw Common::Exception() << path << " is already closed";
+		auto const offset = (uint64_t)o.tellp();
+		if (data.size() > 0xffffffffu || offset > 0xffffffffu) throw Common::Exception() << "npz past 4GB, which needs zip64, which we don't do";
+		Entry e{filename, crc32(data.data(), data.size()), (uint32_t)data.size(), (uint32_t)offset};
+		put32(0x04034b50);
+		put16(20);	// version needed
+		put16(0);	// flags
+		put16(0);	// stored
+		put16(0);	// time
+		put16(0x21);	// date: 1980-01-01
+		put32(e.crc);
+		put32(e.size);
+		put32(e.size);
+		put16((uint16_t)filename.size());
+		put16(0);
+		NpyDetail::writeBytes(o, filename.data(), filename.size());
+		NpyDetail::writeBytes(o, data.data(), data.size());
+		entries.push_back(e);
+	}
+
+	void close() {
+		if (!o.is_open()) return;
+		auto const dirOffset = (uint64_t)o.tellp();
+		for (auto const & e : entries) {
+			put32(0x02014b50);
+			put16(20);	// version made by
+			put16(20);	// version needed
+			put16(0);
+			put16(0);
+			put16(0);
+			put16(0x21);
+			put32(e.crc);
+			put32(e.size);
+			put32(e.size);
+			put16((uint16_t)e.name.size());
+			put16(0);	// extra
+			put16(0);	// comment
+			put16(0);	// disk
+			put16(0);	// internal attrs
+			put32(0);	// external attrs
+			put32(e.offset);
+			NpyDetail::writeBytes(o, e.name.data(), e.name.size());
+		}
+		auto const dirSize = (uint64_t)o.tellp() - dirOffset;
+		if (dirOffset > 0xffffffffu) throw Common::Exception() << "npz past 4GB, which needs zip64, which we don't do";
+		put32(0x06054b50);
+		put16(0);
+		put16(0);
+		put16((uint16_t)entries.size());
+		put16((uint16_t)entries.size());
+		put32((uint32_t)dirSize);
+		put32((uint32_t)dirOffset);
+		put16(0);
+		o.close();
+	}
+
+protected:
+	void put16(uint16_t x) {
+		uint8_t b[2] = {(uint8_t)x, (uint8_t)(x >> 8)};
+		NpyDetail::writeBytes(o, b, 2);
+	}
+	void put32(uint32_t x) {
+		uint8_t b[4] = {(uint8_t)x, (uint8_t)(x >> 8), (uint8_t)(x >> 16), (uint8_t)(x >> 24)};
+		NpyDetail::writeBytes(o, b, 4);
+	}
+};
+
+/*
+.npz reading, uncompressed entries only (np.savez, not np.savez_compressed)
+	NpzReader npz("in.npz");
+	auto rho = npz.read<float, 3>("rho");
+*/
+struct NpzReader {
+	struct Entry {
+		uint32_t crc = {};
+		uint32_t size = {};
+		uint16_t method = {};
+		uint64_t dataOffset = {};
+	};
+
+	std::string path;
+	std::ifstream i;
+	std::map<std::string, Entry> entries;	// by name, without the .npy
+
+	NpzReader(std::string const & path_) : path(path_), i(path_, std::ios::binary) {
+		if (!i) throw Common::Exception() << "failed to open " << path;
+		// find the end of central directory record, which is in the last 64k + 22 bytes
+		i.seekg(0, std::ios::end);
+		int64_t const fileSize = (int64_t)i.tellg();
+		int64_t const tailSize = std::min<int64_t>(fileSize, 65535 + 22);
+		std::string tail(tailSize, 0);
+		i.seekg(fileSize - tailSize);
+		NpyDetail::readBytes(i, tail.data(), tail.size());
+		int64_t eocd = -1;
+		for (int64_t k = tailSize - 22; k >= 0; --k) {
+			if (get32(tail.data() + k) == 0x06054b50) {
+				eocd = k;
+				break;
+			}
+		}
+		if (eocd < 0) throw Common::Exception() << path << " is not a zip file";
+		int const count = get16(tail.data() + eocd + 10);
+		uint32_t const dirOffset = get32(tail.data() + eocd + 16);
+
+		i.seekg(dirOffset);
+		for (int n = 0; n < count; ++n) {
+			char h[46];
+			NpyDetail::readBytes(i, h, sizeof(h));
+			if (get32(h) != 0x02014b50) throw Common::Exception() << path << " has a bad central directory";
+			Entry e;
+			e.method = get16(h + 10);
+			e.crc = get32(h + 16);
+			e.size = get32(h + 24);
+			uint32_t const compressedSize = get32(h + 20);
+			std::string name(get16(h + 28), 0);
+			int const extra = get16(h + 30);
+			int const comment = get16(h + 32);
+			uint32_t const localOffset = get32(h + 42);
+			NpyDetail::readBytes(i, name.data(), name.size());
+			i.seekg(extra + comment, std::ios::cur);
+			if (e.size == 0xffffffffu || localOffset == 0xffffffffu) throw Common::Exception() << path << " needs zip64, which we don't do";
+			if (e.method == 0 && compressedSize != e.size) throw Common::Exception() << path << " has a bad entry " << name;
+			e.dataOffset = localOffset;	// fixed up below, once we've read the local header
+			if (name.size() > 4 && name.substr(name.size() - 4) == ".npy") name.resize(name.size() - 4);
+			entries[name] = e;
+		}
+		for (auto & [name, e] : entries) {
+			char h[30];
+			i.seekg(e.dataOffset);
+			NpyDetail::readBytes(i, h, sizeof(h));
+			if (get32(h) != 0x04034b50) throw Common::Exception() << path << " has a bad local header for " << name;
+			e.dataOffset += 30 + get16(h + 26) + get16(h + 28);
+		}
+	}
+
+	std::vector<std::string> names() const {
+		std::vector<std::string> result;
+		for (auto const & [name, e] : entries) result.push_back(name);
+		return result;
+	}
+
+	// the raw .npy bytes of an entry, crc checked
+	std::string readFile(std::string const & name) {
+		auto it = entries.find(name);
+		if (it == entries.end()) throw Common::Exception() << path << " has no entry " << name;
+		auto const & e = it->second;
+		if (e.method != 0) throw Common::Exception() << path << "'s " << name << " is compressed, which we don't read.  use np.savez instead of np.savez_compressed";
+		std::string data(e.size, 0);
+		i.clear();
+		i.seekg(e.dataOffset);
+		NpyDetail::readBytes(i, data.data(), data.size());
+		if (crc32(data.data(), data.size()) != e.crc) throw Common::Exception() << path << "'s " << name << " failed its crc";
+		return data;
+	}
+
+	template<typename Type, int rank, typename Allocator = std::pmr::polymorphic_allocator<Type>>
+	Grid<Type, rank, Allocator> read(std::string const & name, Allocator const & alloc = {}) {
+		std::istringstream npy(readFile(name));
+		return readNpy<Type, rank, Allocator>(npy, alloc);
+	}
+
+protected:
+	static uint16_t get16(char const * p) {
+		auto b = (uint8_t const *)p;
+		return (uint16_t)(b[0] | (b[1] << 8));
+	}
+	static uint32_t get32(char const * p) {
+		auto b = (uint8_t const *)p;
+		return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+	}
+};
+
+}
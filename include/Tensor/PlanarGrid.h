@@ -0,0 +1,392 @@
+#pragma once
+
+/*
+component-planar (SoA) grids of tensors
+
+Grid<float3x3, 3> keeps each cell's 9 floats together.  PlanarGrid<float3x3, 3> keeps 9 planes instead,
+plane c holding the c'th stored scalar of every cell, so a kernel over one component reads one contiguous array,
+and kernels across cells vectorize.
+
+which scalars are planes comes from the cell type's write() iterator, so it's the stored ones only: sym3 gets 6 planes, asym3 gets 3.
+
+g(i) is a PlanarCellRef proxy that converts to and assigns from the cell type.
+each plane starts a multiple of cacheLineSize bytes after the first, so with an aligned allocator (see Memory.h) they're all aligned.
+*/
+
+#include "Tensor/Grid.h"
+#include "Tensor/Memory.h"
+#include "Tensor/Signature.h"
+#include "Tensor/ThreadPool.h"
+#include "Common/Exception.h"
+#include <array>
+#include <vector>
+
+namespace Tensor {
+
+template<typename Type>
+struct PlanarComponents {
+	using Scalar = StorageScalar<Type>;
+	static constexpr int count = storedScalarCount<Type>();
+
+	// byte offset within a cell of each plane's scalar, in write() order
+	static std::array<int, count> const & offsets() {
+		static std::array<int, count> const table = [](){
+			std::array<int, count> t = {};
+			if constexpr (is_tensor_v<Type>) {
+				Type probe = {};
+				int c = 0;
+				for (auto & x : probe.write()) {
+					if (c >= count) throw Common::Exception() << "more write() elements than stored scalars";
+					t[c++] = (int)((char const *)&x - (char const *)&probe);
+				}
+				if (c != count) throw Common::Exception() << "fewer write() elements than stored scalars";
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	static Scalar & get(Type & x, int c) { return *(Scalar *)((char *)&x + offsets()[c]); }
+	static Scalar const & get(Type const & x, int c) { return *(Scalar const *)((char const *)&x + offsets()[c]); }
+
+	// the cell that is 1 in component c and 0 elsewhere
+	static Type unit(int c) {
+		Type x = {};
+		get(x, c) = 1;
+		return x;
+	}
+};
+
+template<typename PlanarGridType>
+struct PlanarCellRef;
+
+template<
+	typename Type_,
+	int rank_,
+	typename Allocator_ = std::pmr::polymorphic_allocator<StorageScalar<Type_>>
+>
+struct PlanarGrid {
+	using Type = Type_;
+	using value_type = Type;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	using Components = PlanarComponents<Type>;
+	using Scalar = typename Components::Scalar;
+	static constexpr int components = Components::count;
+	using Allocator = Allocator_;
+	using Ref = PlanarCellRef<PlanarGrid>;
+	using ConstRef = PlanarCellRef<PlanarGrid const>;
+
+	intN size;
+	intN step;	// same as a Grid's, within each plane
+	int planeStride = {};	// scalars from one plane to the next
+	std::vector<Scalar, Allocator> storage;
+
+	PlanarGrid() {}
+
+	PlanarGrid(intN const & size_, Allocator const & alloc = {})
+	:	size(size_),
+		step(stepForSize(size_)),
+		planeStride(stridePerPlane(size_.product())),
+		storage((size_t)planeStride * components, alloc)
+	{}
+
+	// f(intN index), in memory order
+	template<typename F>
+	requires std::is_invocable_r_v<Type, F, intN>
+	PlanarGrid(intN const & size_, F && f, Allocator const & alloc = {})
+	: PlanarGrid(size_, alloc) {
+		int k = 0;
+		for (auto i : range()) {
+			store(k++, f(i));
+		}
+	}
+
+	template<typename A>
+	explicit PlanarGrid(Grid<Type, rank, A> const & g, Allocator const & alloc = {})
+	: PlanarGrid(g.size, alloc) {
+		int const n = size.product();
+		for (int k = 0; k < n; ++k) store(k, g.v[k]);
+	}
+
+	static int stridePerPlane(int n) {
+		constexpr int align = std::max<int>(1, cacheLineSize / sizeof(Scalar));
+		return (std::max(n, 0) + align - 1) / align * align;
+	}
+
+	int cellCount() const { return size.product(); }
+
+	Scalar * plane(int c) { return storage.data() + (size_t)c * planeStride; }
+	Scalar const * plane(int c) const { return storage.data() + (size_t)c * planeStride; }
+
+	GridView<Scalar, rank> planeView(int c) { return {size, step, plane(c)}; }
+	GridView<Scalar const, rank> planeView(int c) const { return {size, step, plane(c)}; }
+
+	// gather / scatter the cell at flat index k
+	Type load(int k) const {
+		Type x = {};
+		for (int c = 0; c < components; ++c) {
+			Components::get(x, c) = plane(c)[k];
+		}
+		return x;
+	}
+
+	void store(int k, Type const & x) {
+		for (int c = 0; c < components; ++c) {
+			plane(c)[k] = Components::get(x, c);
+		}
+	}
+
+	int flatIndex(intN const & i) const {
+#ifdef DEBUG
+		for (int j = 0; j < rank; ++j) {
+			if (i[j] < 0 || i[j] >= size[j]) {
+				throw Common::Exception() << "size is " << size << " but dereference is " << i;
+			}
+		}
+#endif
+		return i.dot(step);
+	}
+
+	Ref operator()(intN const & i) { return {this, flatIndex(i)}; }
+	ConstRef operator()(intN const & i) const { return {this, flatIndex(i)}; }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Ref operator()(int first, Rest... rest) { return (*this)(intN(first, rest...)); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	ConstRef operator()(int first, Rest... rest) const { return (*this)(intN(first, rest...)); }
+
+	RangeObj<rank> range() const {
+		return RangeObj<rank>(intN(), size);
+	}
+
+	// back to interleaved cells
+	template<typename A = std::pmr::polymorphic_allocator<Type>>
+	Grid<Type, rank, A> copy(A const & alloc = {}) const {
+		return Grid<Type, rank, A>(size, [&](int k) -> Type { return load(k); }, alloc);
+	}
+};
+
+/*
+stands in for a cell
+reads as the cell type, assigning a cell type writes every plane,
+and indexing returns a reference into the planes when the cell type's own indexing would return a reference into its storage
+*/
+template<typename PlanarGridType>
+struct PlanarCellRef {
+	using G = std::remove_const_t<PlanarGridType>;
+	using Type = typename G::Type;
+	using Components = typename G::Components;
+	using Scalar = typename G::Scalar;
+	using ScalarC = std::conditional_t<std::is_const_v<PlanarGridType>, Scalar const, Scalar>;
+
+	PlanarGridType * grid = {};
+	int k = {};
+
+	Type get() const { return grid->load(k); }
+	operator Type() const { return get(); }
+
+	PlanarCellRef const & operator=(Type const & x) const requires (!std::is_const_v<PlanarGridType>) {
+		grid->store(k, x);
+		return *this;
+	}
+	PlanarCellRef const & operator=(PlanarCellRef const & o) const requires (!std::is_const_v<PlanarGridType>) {
+		return *this = o.get();
+	}
+
+	// the c'th stored scalar
+	ScalarC & component(int c) const { return grid->plane(c)[k]; }
+
+	template<typename... Index>
+	decltype(auto) operator()(Index... index) const {
+		if constexpr (std::is_lvalue_reference_v<decltype(std::declval<Type &>()(index...))>) {
+			Type probe = {};
+			auto const ofs = (char const *)&probe(index...) - (char const *)&probe;
+			auto const & offsets = Components::offsets();
+			for (int c = 0; c < G::components; ++c) {
+				if (offsets[c] == ofs) return component(c);
+			}
+			throw Common::Exception() << "index isn't a stored component";
+		} else {
+			return get()(index...);
+		}
+	}
+
+	PlanarCellRef const & operator+=(Type const & x) const { return *this = get() + x; }
+	PlanarCellRef const & operator-=(Type const & x) const { return *this = get() - x; }
+	PlanarCellRef const & operator*=(Scalar s) const { return *this = get() * s; }
+	PlanarCellRef const & operator/=(Scalar s) const { return *this = get() / s; }
+
+	bool operator==(Type const & x) const { return get() == x; }
+	bool operator!=(Type const & x) const { return get() != x; }
+};
+
+template<typename G>
+std::ostream & operator<<(std::ostream & o, PlanarCellRef<G> const & r) {
+	return o << r.get();
+}
+
+/*
+kernels across cells
+cells are split into fixed blocks that fit in L1 with all their planes, blocks run in parallel,
+and the inner loops are plain loops over contiguous plane arrays for the compiler to vectorize.
+*/
+
+inline constexpr int planarBlockCells = 1024;
+
+namespace PlanarDetail {
+
+template<typename F>
+void forEachBlock(int n, ThreadPool & pool, F && f) {
+	int const blocks = (n + planarBlockCells - 1) / planarBlockCells;
+	pool.parallelFor(blocks, [&](int b) {
+		int const begin = b * planarBlockCells;
+		f(begin, std::min(n, begin + planarBlockCells));
+	});
+}
+
+template<typename D, typename... S>
+void checkSizes(D const & dst, S const & ... src) {
+	if (((src.size != dst.size) || ...)) throw Common::Exception() << "planar kernel over grids of different sizes";
+}
+
+// out component c += coeff * a component ia [* b component ib]
+template<typename Scalar>
+struct Term {
+	int c = {}, ia = {}, ib = {};
+	Scalar coeff = {};
+};
+
+// is dst one of the inputs?
+template<typename D, typename... S>
+bool aliases(D const & dst, S const & ... src) {
+	return (((void const *)dst.plane(0) == (void const *)src.plane(0)) || ...);
+}
+
+/*
+sum the terms over cells [begin, end) of dst.
+addTerm(d, t) does d[k] += t's product at cell begin + k, for k in [0, end - begin).
+dst is cleared first, so if it's also an input the sums go to a buffer, and are stored once every term has read its inputs.
+*/
+template<typename D, typename Scalar, typename F>
+void sumTerms(D & dst, std::vector<Term<Scalar>> const & terms, bool inPlace, int begin, int end, F && addTerm) {
+	int const n = end - begin;
+	std::vector<Scalar> buffer;
+	if (inPlace) buffer.assign((size_t)D::components * n, Scalar());
+	auto out = [&](int c) -> Scalar * { return inPlace ? buffer.data() + (size_t)c * n : dst.plane(c) + begin; };
+	if (!inPlace) {
+		for (int c = 0; c < D::components; ++c) std::fill(out(c), out(c) + n, Scalar());
+	}
+	for (auto const & t : terms) addTerm(out(t.c), t);
+	if (inPlace) {
+		for (int c = 0; c < D::components; ++c) std::copy(out(c), out(c) + n, dst.plane(c) + begin);
+	}
+}
+
+}
+
+/*
+dst.component(c) = op(a.component(c), ...) for every component of every cell, i.e. for componentwise ops like + - and scaling
+dst can be one of the inputs: each cell is read before it's written, so the pointers aren't __restrict.
+*/
+template<typename D, typename F, typename... S>
+void planarTransform(D & dst, F && op, ThreadPool & pool, S const & ... src) {
+	PlanarDetail::checkSizes(dst, src...);
+	PlanarDetail::forEachBlock(dst.cellCount(), pool, [&](int begin, int end) {
+		for (int c = 0; c < D::components; ++c) {
+			auto * d = dst.plane(c);
+			[&](auto const * ... s) {
+				for (int k = begin; k < end; ++k) {
+					d[k] = op(s[k]...);
+				}
+			}(src.plane(c)...);
+		}
+	});
+}
+
+template<typename D, typename F, typename... S>
+void planarTransform(D & dst, F && op, S const & ... src) {
+	planarTransform(dst, std::forward<F>(op), ThreadPool::get(), src...);
+}
+
+template<typename G>
+void planarAdd(G & dst, G const & a, G const & b, ThreadPool & pool = ThreadPool::get()) {
+	using Scalar = typename G::Scalar;
+	planarTransform(dst, [](Scalar x, Scalar y) { return x + y; }, pool, a, b);
+}
+
+// y += alpha * x
+template<typename G>
+void planarAxpy(G & y, typename G::Scalar alpha, G const & x, ThreadPool & pool = ThreadPool::get()) {
+	using Scalar = typename G::Scalar;
+	planarTransform(y, [alpha](Scalar yi, Scalar xi) { return yi + alpha * xi; }, pool, y, x);
+}
+
+/*
+dst(i) = f(src(i)) for a linear f, like transpose, trace, or multiplying by a constant tensor.
+f is probed once per component to get its coefficients, then applied as sums over planes.
+dst can be src.
+*/
+template<typename D, typename S, typename F>
+void planarLinear(D & dst, S const & src, F && f, ThreadPool & pool = ThreadPool::get()) {
+	using Scalar = typename D::Scalar;
+	using OutC = PlanarComponents<typename D::Type>;
+	using InC = PlanarComponents<typename S::Type>;
+	PlanarDetail::checkSizes(dst, src);
+	std::vector<PlanarDetail::Term<Scalar>> terms;
+	for (int a = 0; a < S::components; ++a) {
+		typename D::Type const y = f(InC::unit(a));
+		for (int c = 0; c < D::components; ++c) {
+			Scalar const coeff = (Scalar)OutC::get(y, c);
+			if (coeff != 0) terms.push_back({c, a, 0, coeff});
+		}
+	}
+	bool const inPlace = PlanarDetail::aliases(dst, src);
+	PlanarDetail::forEachBlock(dst.cellCount(), pool, [&](int begin, int end) {
+		PlanarDetail::sumTerms(dst, terms, inPlace, begin, end, [&](Scalar * __restrict d, auto const & t) {
+			auto const * __restrict x = src.plane(t.ia) + begin;
+			for (int k = 0; k < end - begin; ++k) {
+				d[k] += t.coeff * x[k];
+			}
+		});
+	});
+}
+
+/*
+dst(i) = f(a(i), b(i)) for a bilinear f, i.e. any contraction or product: matrix * matrix, matrix * vector, dot, cross, outer, ...
+f is probed once per pair of components, and only the nonzero products are computed.
+dst can be a or b.
+*/
+template<typename D, typename A, typename B, typename F>
+void planarBilinear(D & dst, A const & a, B const & b, F && f, ThreadPool & pool = ThreadPool::get()) {
+	using Scalar = typename D::Scalar;
+	using OutC = PlanarComponents<typename D::Type>;
+	using AC = PlanarComponents<typename A::Type>;
+	using BC = PlanarComponents<typename B::Type>;
+	PlanarDetail::checkSizes(dst, a, b);
+	std::vector<PlanarDetail::Term<Scalar>> terms;
+	for (int ia = 0; ia < A::components; ++ia) {
+		for (int ib = 0; ib < B::components; ++ib) {
+			typename D::Type const y = f(AC::unit(ia), BC::unit(ib));
+			for (int c = 0; c < D::components; ++c) {
+				Scalar const coeff = (Scalar)OutC::get(y, c);
+				if (coeff != 0) terms.push_back({c, ia, ib, coeff});
+			}
+		}
+	}
+	bool const inPlace = PlanarDetail::aliases(dst, a, b);
+	PlanarDetail::forEachBlock(dst.cellCount(), pool, [&](int begin, int end) {
+		PlanarDetail::sumTerms(dst, terms, inPlace, begin, end, [&](Scalar * __restrict d, auto const & t) {
+			auto const * __restrict x = a.plane(t.ia) + begin;
+			auto const * __restrict y = b.plane(t.ib) + begin;
+			for (int k = 0; k < end - begin; ++k) {
+				d[k] += t.coeff * x[k] * y[k];
+			}
+		});
+	});
+}
+
+}
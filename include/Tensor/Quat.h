@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Tensor/Vector.h"
+#include "Tensor/Eigen.h"
 #include "Tensor/clamp.h"
+#include <array>
 #include <cmath>
+#include <limits>
+#include <span>
+#include <utility>
 
 // TODO any vec& member return types, like operator+=, will have to be overloaded
 //  and it looks like I can't crtp the operator+= members due to vec having unions?
@@ -92,6 +97,26 @@ struct quat : public vec4<Inner_> {
 		return {this->x / scale, this->y / scale, this->z / scale, 2 * halfAngle};
 	}
 
+	/*
+	log and exp, for any quat, not just unit ones
+	for unit quats log is (axis * half angle, 0), and exp undoes it
+	*/
+	quat log() const {
+		Inner const n = this->axis().length();
+		Inner const len = this->length();
+		Inner const s = n <= angleAxisEpsilon * len
+			? (this->w >= 0 ? 1 / len : (Inner)0)	// atan2(n, w) / n -> 1/w as n -> 0, and there's no axis to go with a real negative quat
+			: std::atan2(n, this->w) / n;
+		return {this->x * s, this->y * s, this->z * s, std::log(len)};
+	}
+
+	quat exp() const {
+		Inner const n = this->axis().length();
+		Inner const e = std::exp(this->w);
+		Inner const s = n <= angleAxisEpsilon ? e : e * std::sin(n) / n;
+		return {this->x * s, this->y * s, this->z * s, e * std::cos(n)};
+	}
+
 	static quat mul(quat const &q, quat const &r) {
 		Inner const a = (q.w + q.x) * (r.w + r.x);
 		Inner const b = (q.z - q.y) * (r.y - r.z);
@@ -115,10 +140,27 @@ struct quat : public vec4<Inner_> {
 	vec3 & axis() { return Super::template subset<3>(); }
 	vec3 const & axis() const { return Super::template subset<3>(); }
 
+	// q v q* for any q, so non-unit quats scale by |q|^2
 	vec3 rotate(vec3 const & v) const {
 		return (*this * quat(v) * conjugate()).axis();
 	}
 
+	/*
+	same for unit quats, in the cross-product form:
+	t = 2 (u x v), v' = v + w t + u x t
+	which is 15 multiplies instead of two Hamilton products
+	*/
+	vec3 rotateUnit(vec3 const & v) const {
+		Inner const tx = 2 * (this->y * v.z - this->z * v.y);
+		Inner const ty = 2 * (this->z * v.x - this->x * v.z);
+		Inner const tz = 2 * (this->x * v.y - this->y * v.x);
+		return {
+			v.x + this->w * tx + (this->y * tz - this->z * ty),
+			v.y + this->w * ty + (this->z * tx - this->x * tz),
+			v.z + this->w * tz + (this->x * ty - this->y * tx),
+		};
+	}
+
 	vec3 xAxis() const {
 		return {
 			1 - 2 * (this->y * this->y + this->z * this->z),
@@ -143,8 +185,38 @@ struct quat : public vec4<Inner_> {
 		};
 	}
 
+	// columns are xAxis(), yAxis(), zAxis().  for unit quats.  once you have it, m * v is 9 multiplies per vector.
 	mat3x3 toMatrix() const {
-		return mat3x3(xAxis(), yAxis(), zAxis()).transpose();
+		Inner const x2 = this->x * 2, y2 = this->y * 2, z2 = this->z * 2;
+		Inner const xx = this->x * x2, yy = this->y * y2, zz = this->z * z2;
+		Inner const xy = this->x * y2, xz = this->x * z2, yz = this->y * z2;
+		Inner const wx = this->w * x2, wy = this->w * y2, wz = this->w * z2;
+		return mat3x3{
+			{1 - (yy + zz), xy - wz, xz + wy},
+			{xy + wz, 1 - (xx + zz), yz - wx},
+			{xz - wy, yz + wx, 1 - (xx + yy)},
+		};
+	}
+
+	/*
+	inverse of toMatrix(), for rotation matrices
+	Shepperd's method: build from whichever of w, x, y, z is largest, so nothing divides by a small number
+	*/
+	static quat fromMatrix(mat3x3 const & m) {
+		Inner const tr = m(0,0) + m(1,1) + m(2,2);
+		if (tr > 0) {
+			Inner const s = std::sqrt(tr + 1) * 2;
+			return {(m(2,1) - m(1,2)) / s, (m(0,2) - m(2,0)) / s, (m(1,0) - m(0,1)) / s, s / 4};
+		} else if (m(0,0) > m(1,1) && m(0,0) > m(2,2)) {
+			Inner const s = std::sqrt(1 + m(0,0) - m(1,1) - m(2,2)) * 2;
+			return {s / 4, (m(0,1) + m(1,0)) / s, (m(0,2) + m(2,0)) / s, (m(2,1) - m(1,2)) / s};
+		} else if (m(1,1) > m(2,2)) {
+			Inner const s = std::sqrt(1 + m(1,1) - m(0,0) - m(2,2)) * 2;
+			return {(m(0,1) + m(1,0)) / s, s / 4, (m(1,2) + m(2,1)) / s, (m(0,2) - m(2,0)) / s};
+		} else {
+			Inner const s = std::sqrt(1 + m(2,2) - m(0,0) - m(1,1)) * 2;
+			return {(m(0,2) + m(2,0)) / s, (m(1,2) + m(2,1)) / s, s / 4, (m(1,0) - m(0,1)) / s};
+		}
 	}
 
 	quat & operator*=(quat const & o) {
@@ -211,6 +283,363 @@ std::ostream & operator<<(std::ostream & o, quat<T> const & q) {
 
 
 
+/*
+batched rotation of unit quats, by quat::rotateUnit's cross-product form
+vectors go through in blocks: each block is split into x, y, z arrays, rotated by plain loops the compiler vectorizes, and put back.
+src and dst can be the same span.
+T is deduced from the quat or matrix, so vectors of vec3s convert to the spans.
+*/
+namespace QuatDetail {
+inline constexpr int rotateBlock = 16;
+
+// quatAt(i) is the quat for vector i
+template<typename T, typename Q>
+void rotateBlocks(Q && quatAt, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	if (src.size() != dst.size()) throw Common::Exception() << "rotate " << src.size() << " vectors into " << dst.size();
+	constexpr int B = rotateBlock;
+	size_t const n = src.size();
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const m = (int)std::min<size_t>(B, n - begin);
+		T vx[B] = {}, vy[B] = {}, vz[B] = {};
+		T qx[B] = {}, qy[B] = {}, qz[B] = {}, qw[B] = {};
+		for (int k = 0; k < m; ++k) {
+			auto const & v = src[begin + k];
+			vx[k] = v.x;
+			vy[k] = v.y;
+			vz[k] = v.z;
+			quat<T> const & q = quatAt(begin + k);
+			qx[k] = q.x;
+			qy[k] = q.y;
+			qz[k] = q.z;
+			qw[k] = q.w;
+		}
+		T rx[B], ry[B], rz[B];
+		for (int k = 0; k < B; ++k) {
+			T const tx = 2 * (qy[k] * vz[k] - qz[k] * vy[k]);
+			T const ty = 2 * (qz[k] * vx[k] - qx[k] * vz[k]);
+			T const tz = 2 * (qx[k] * vy[k] - qy[k] * vx[k]);
+			rx[k] = vx[k] + qw[k] * tx + (qy[k] * tz - qz[k] * ty);
+			ry[k] = vy[k] + qw[k] * ty + (qz[k] * tx - qx[k] * tz);
+			rz[k] = vz[k] + qw[k] * tz + (qx[k] * ty - qy[k] * tx);
+		}
+		for (int k = 0; k < m; ++k) {
+			dst[begin + k] = vec3<T>(rx[k], ry[k], rz[k]);
+		}
+	}
+}
+}
+
+// dst[i] = q.rotateUnit(src[i])
+template<typename T>
+void rotate(quat<T> const & q, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	QuatDetail::rotateBlocks<T>([&](size_t) -> quat<T> const & { return q; }, src, dst);
+}
+
+// dst[i] = q[i].rotateUnit(src[i])
+template<typename T>
+void rotate(std::span<quat<T> const> q, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	if (q.size() != src.size()) throw Common::Exception() << q.size() << " quats for " << src.size() << " vectors";
+	QuatDetail::rotateBlocks<T>([&](size_t i) -> quat<T> const & { return q[i]; }, src, dst);
+}
+
+// dst[i] = m * src[i], for when one rotation is applied to lots of vectors.  m can be a quat's toMatrix().
+template<typename T>
+void rotate(mat3x3<T> const & m, std::span<vec3<std::type_identity_t<T>> const> src, std::span<vec3<std::type_identity_t<T>>> dst) {
+	if (src.size() != dst.size()) throw Common::Exception() << "rotate " << src.size() << " vectors into " << dst.size();
+	T const m00 = m(0,0), m01 = m(0,1), m02 = m(0,2);
+	T const m10 = m(1,0), m11 = m(1,1), m12 = m(1,2);
+	T const m20 = m(2,0), m21 = m(2,1), m22 = m(2,2);
+	size_t const n = src.size();
+	for (size_t i = 0; i < n; ++i) {
+		T const x = src[i].x, y = src[i].y, z = src[i].z;
+		dst[i] = vec3<T>(
+			m00 * x + m01 * y + m02 * z,
+			m10 * x + m11 * y + m12 * z,
+			m20 * x + m21 * y + m22 * z
+		);
+	}
+}
+
+/*
+interpolation, for unit quats
+
+these all take the shortest path: b is negated when it's in the other hemisphere from a,
+so they return b or -b at t = 1, which are the same rotation.
+*/
+
+// normalized lerp.  not constant speed, but cheap, and close to slerp for small angles.
+template<typename T>
+quat<T> nlerp(quat<T> const & a, quat<T> b, std::type_identity_t<T> t) {
+	if (a.dot(b) < 0) b = -b;
+	return normalize((quat<T>)(a * (1 - t) + b * t));
+}
+
+// constant speed along the great arc.  nearly parallel quats fall back to nlerp.
+template<typename T>
+quat<T> slerp(quat<T> const & a, quat<T> b, std::type_identity_t<T> t) {
+	T c = a.dot(b);
+	if (c < 0) {
+		c = -c;
+		b = -b;
+	}
+	T const s = std::sqrt(std::max<T>(0, 1 - c * c));
+	if (s <= quat<T>::angleAxisEpsilon) return nlerp(a, b, t);
+	T const theta = std::atan2(s, c);
+	return (quat<T>)(a * (std::sin((1 - t) * theta) / s) + b * (std::sin(t * theta) / s));
+}
+
+/*
+spherical cubic between q0 and q1, with control points s0 and s1 from squadControl
+squad(q0, q1, s0, s1, t) = slerp(slerp(q0, q1, t), slerp(s0, s1, t), 2t(1-t))
+*/
+template<typename T>
+quat<T> squad(quat<T> const & q0, quat<T> const & q1, quat<T> const & s0, quat<T> const & s1, std::type_identity_t<T> t) {
+	return slerp(slerp(q0, q1, t), slerp(s0, s1, t), 2 * t * (1 - t));
+}
+
+/*
+the control point at key q, between keys prev and next, so the curve through consecutive keys has a continuous tangent:
+s = q exp(-(log(q* next) + log(q* prev)) / 4)
+at the ends of a sequence, pass the end key as its own missing neighbor.
+*/
+template<typename T>
+quat<T> squadControl(quat<T> const & prev, quat<T> const & q, quat<T> const & next) {
+	quat<T> const qc = q.conjugate();
+	auto const hemi = [&](quat<T> const & r) { return q.dot(r) < 0 ? -r : r; };
+	quat<T> const l = (qc * hemi(next)).log() + (qc * hemi(prev)).log();
+	return normalize(q * (quat<T>)(l * (T)-.25).exp());
+}
+
+/*
+weighted average of many rotations (Markley et al, "Averaging Quaternions")
+the eigenvector of the largest eigenvalue of sum_i w_i q_i q_i^T, so q and -q count the same.
+weights default to 1.  the result is in the hemisphere of q[0].
+*/
+template<typename T>
+quat<T> average(std::span<quat<T> const> q, std::span<std::type_identity_t<T> const> weights = {}) {
+	if (q.empty()) throw Common::Exception() << "can't average no quats";
+	if (!weights.empty() && weights.size() != q.size()) throw Common::Exception() << weights.size() << " weights for " << q.size() << " quats";
+	sym<T,4> m;
+	for (size_t i = 0; i < q.size(); ++i) {
+		T const w = weights.empty() ? 1 : weights[i];
+		for (int a = 0; a < 4; ++a) {
+			for (int b = a; b < 4; ++b) {
+				m(a,b) += w * q[i][a] * q[i][b];
+			}
+		}
+	}
+	// eigenvalues are ascending, so the last column
+	auto const e = eigen(m);
+	quat<T> r(e.vectors(0,3), e.vectors(1,3), e.vectors(2,3), e.vectors(3,3));
+	if (r.dot(q[0]) < 0) r = -r;
+	return normalize(r);
+}
+
+/*
+batched interpolation
+
+slerp and squad here use Eberly's polynomial slerp ("A Fast and Accurate Algorithm for Computing SLERP"),
+so there's no acos or sin per element:  with x = cos(angle) >= 0,
+sin(t angle) / sin(angle) = t (1 + b_0 (1 + b_1 (... (1 + b_7)))),  b_i = (u_i t^2 - v_i)(x - 1)
+with u_i = 1/(i(2i+1)), v_i = i/(2i+1) for i = 1..8, and the last term scaled by 1+mu to stand in for the truncated rest of the series.
+each weight is within 2.6e-5 of the exact one, worst near a 90 degree angle between the quats (180 degree rotation) and t = 1/2,
+so results are within 5e-5 of scalar slerp(), plus rounding.  they aren't renormalized, so they are unit to within that too.
+that's about 0.003 degrees.  use the scalar slerp() where that matters.
+
+nlerp here is exact, same as the scalar nlerp.  its loop only vectorizes with -fno-math-errno, because of the sqrt.
+like rotate(), quats go through in blocks, split into component arrays, so the loops vectorize.  dst can be the same span as an input.
+*/
+namespace QuatDetail {
+inline constexpr int interpBlock = 16;
+
+template<typename T>
+struct FastSlerp {
+	static constexpr T onePlusMu = (T)1.90110745351730037;
+	static constexpr int order = 8;
+
+	static constexpr std::array<T, order> u = []{
+		std::array<T, order> a = {};
+		for (int i = 1; i <= order; ++i) a[i-1] = (T)1 / (T)(i * (2 * i + 1));
+		a[order-1] *= onePlusMu;
+		return a;
+	}();
+
+	static constexpr std::array<T, order> v = []{
+		std::array<T, order> a = {};
+		for (int i = 1; i <= order; ++i) a[i-1] = (T)i / (T)(2 * i + 1);
+		a[order-1] *= onePlusMu;
+		return a;
+	}();
+
+	// ~ sin(t angle) / sin(angle), for x = cos(angle) in [0, 1]
+	static T weight(T x, T t) {
+		T const xm1 = x - 1;
+		T const tt = t * t;
+		// unrolled by hand so the loops calling this see straight-line code and vectorize
+		return t * [&]<size_t... i>(std::index_sequence<i...>) {
+			T r = 1;
+			((r = 1 + (u[order - 1 - i] * tt - v[order - 1 - i]) * xm1 * r), ...);
+			return r;
+		}(std::make_index_sequence<order>());
+	}
+};
+
+// one block of quats, as component arrays [x,y,z,w][k]
+template<typename T>
+using QuatBlock = T[4][interpBlock];
+
+template<typename T>
+void fastSlerpBlock(QuatBlock<T> const & a, QuatBlock<T> const & b, T const * t, QuatBlock<T> & out) {
+	constexpr int B = interpBlock;
+	for (int k = 0; k < B; ++k) {
+		T const d = a[0][k] * b[0][k] + a[1][k] * b[1][k] + a[2][k] * b[2][k] + a[3][k] * b[3][k];
+		T const sign = std::copysign((T)1, d);
+		T const x = std::abs(d);
+		T const ca = FastSlerp<T>::weight(x, 1 - t[k]);
+		T const cb = FastSlerp<T>::weight(x, t[k]) * sign;
+		out[0][k] = a[0][k] * ca + b[0][k] * cb;
+		out[1][k] = a[1][k] * ca + b[1][k] * cb;
+		out[2][k] = a[2][k] * ca + b[2][k] * cb;
+		out[3][k] = a[3][k] * ca + b[3][k] * cb;
+	}
+}
+
+template<typename T>
+void nlerpBlock(QuatBlock<T> const & a, QuatBlock<T> const & b, T const * t, QuatBlock<T> & out) {
+	constexpr int B = interpBlock;
+	for (int k = 0; k < B; ++k) {
+		T const d = a[0][k] * b[0][k] + a[1][k] * b[1][k] + a[2][k] * b[2][k] + a[3][k] * b[3][k];
+		T const cb = std::copysign(t[k], d);
+		T const ca = 1 - t[k];
+		T r[4];
+		for (int j = 0; j < 4; ++j) {
+			r[j] = a[j][k] * ca + b[j][k] * cb;
+		}
+		T const lenSq = r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3];
+		T const s = 1 / std::sqrt(lenSq);	// >= 1/2 for unit quats in the same hemisphere
+		for (int j = 0; j < 4; ++j) {
+			out[j][k] = r[j] * s;
+		}
+	}
+}
+
+// the first m quats of q into block b
+template<typename T>
+void loadBlock(QuatBlock<T> & b, std::span<quat<T> const> q, size_t begin, int m) {
+	for (int k = 0; k < m; ++k) {
+		for (int j = 0; j < 4; ++j) {
+			b[j][k] = q[begin + k][j];
+		}
+	}
+	for (int k = m; k < interpBlock; ++k) {
+		for (int j = 0; j < 4; ++j) {
+			b[j][k] = j == 3;
+		}
+	}
+}
+
+template<typename T>
+void storeBlock(QuatBlock<T> const & b, std::span<quat<T>> q, size_t begin, int m) {
+	for (int k = 0; k < m; ++k) {
+		q[begin + k] = quat<T>(b[0][k], b[1][k], b[2][k], b[3][k]);
+	}
+}
+
+// t[i] for every i, or one t for all when t has one element
+template<typename T>
+void loadParams(T * dst, std::span<T const> t, size_t begin, int m) {
+	for (int k = 0; k < m; ++k) {
+		dst[k] = t.size() == 1 ? t[0] : t[begin + k];
+	}
+	for (int k = m; k < interpBlock; ++k) {
+		dst[k] = 0;
+	}
+}
+
+template<typename T>
+void checkSizes(size_t n, size_t other, char const * what) {
+	if (other != n) throw Common::Exception() << other << " " << what << " for " << n << " quats";
+}
+
+// dst = blockOp(a, b, t) blockwise
+template<typename T, typename BlockOp>
+void interpBlocks(BlockOp && blockOp, std::span<quat<T> const> a, std::span<quat<T> const> b, std::span<T const> t, std::span<quat<T>> dst) {
+	size_t const n = a.size();
+	checkSizes<T>(n, b.size(), "quats");
+	checkSizes<T>(n, dst.size(), "outputs");
+	if (t.size() != 1) checkSizes<T>(n, t.size(), "parameters");
+	for (size_t begin = 0; begin < n; begin += interpBlock) {
+		int const m = (int)std::min<size_t>(interpBlock, n - begin);
+		QuatBlock<T> qa, qb, r;
+		T tb[interpBlock];
+		loadBlock(qa, a, begin, m);
+		loadBlock(qb, b, begin, m);
+		loadParams(tb, t, begin, m);
+		blockOp(qa, qb, tb, r);
+		storeBlock(r, dst, begin, m);
+	}
+}
+}
+
+// dst[i] = slerp(a[i], b[i], t[i]) to within 5e-5, by the polynomial above.  t can also be a single parameter for all.
+template<typename T>
+void slerp(
+	std::span<quat<T> const> a,
+	std::span<quat<std::type_identity_t<T>> const> b,
+	std::span<std::type_identity_t<T> const> t,
+	std::span<quat<std::type_identity_t<T>>> dst
+) {
+	QuatDetail::interpBlocks<T>([](auto const & qa, auto const & qb, T const * tb, auto & r) { QuatDetail::fastSlerpBlock<T>(qa, qb, tb, r); }, a, b, t, dst);
+}
+
+// dst[i] = nlerp(a[i], b[i], t[i]).  t can also be a single parameter for all.
+template<typename T>
+void nlerp(
+	std::span<quat<T> const> a,
+	std::span<quat<std::type_identity_t<T>> const> b,
+	std::span<std::type_identity_t<T> const> t,
+	std::span<quat<std::type_identity_t<T>>> dst
+) {
+	QuatDetail::interpBlocks<T>([](auto const & qa, auto const & qb, T const * tb, auto & r) { QuatDetail::nlerpBlock<T>(qa, qb, tb, r); }, a, b, t, dst);
+}
+
+// dst[i] = squad(q0[i], q1[i], s0[i], s1[i], t[i]), with the same polynomial slerps, so to within about 1.5e-4.  t can also be a single parameter for all.
+template<typename T>
+void squad(
+	std::span<quat<T> const> q0,
+	std::span<quat<std::type_identity_t<T>> const> q1,
+	std::span<quat<std::type_identity_t<T>> const> s0,
+	std::span<quat<std::type_identity_t<T>> const> s1,
+	std::span<std::type_identity_t<T> const> t,
+	std::span<quat<std::type_identity_t<T>>> dst
+) {
+	using namespace QuatDetail;
+	constexpr int B = interpBlock;
+	size_t const n = q0.size();
+	checkSizes<T>(n, q1.size(), "quats");
+	checkSizes<T>(n, s0.size(), "control points");
+	checkSizes<T>(n, s1.size(), "control points");
+	checkSizes<T>(n, dst.size(), "outputs");
+	if (t.size() != 1) checkSizes<T>(n, t.size(), "parameters");
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const m = (int)std::min<size_t>(B, n - begin);
+		QuatBlock<T> a, b, p, s;
+		T tb[B], h[B];
+		loadParams(tb, t, begin, m);
+		for (int k = 0; k < B; ++k) {
+			h[k] = 2 * tb[k] * (1 - tb[k]);
+		}
+		loadBlock(a, q0, begin, m);
+		loadBlock(b, q1, begin, m);
+		fastSlerpBlock(a, b, tb, p);
+		loadBlock(a, s0, begin, m);
+		loadBlock(b, s1, begin, m);
+		fastSlerpBlock(a, b, tb, s);
+		fastSlerpBlock(p, s, h, a);
+		storeBlock(a, dst, begin, m);
+	}
+}
+
 using quati = quat<int>;	// I don't judge
 using quatf = quat<float>;
 using quatd = quat<double>;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Tensor/Vector.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/*
+strings describing how a type is stored, for file headers
+so we can refuse to read a file of float3s into a grid of sym3s, etc.
+
+scalarTypeStr<float>() == "f32"
+storageSignature<float>() == "f32"
+storageSignature<float3>() == "f32 3"
+storageSignature<vec<sym<double,3>,4>>() == "f64 4, s 3"
+storageSignature<sym4<float>>() == "f32 s 4"
+
+the nesting part is each nesting's tensorxStr(), outermost first
+*/
+
+namespace Tensor {
+
+template<typename T>
+std::string scalarTypeStr() {
+	static_assert(std::is_arithmetic_v<T>, "don't know how to describe this scalar type");
+	if constexpr (std::is_same_v<T, bool>) {
+		return "b8";
+	} else if constexpr (std::is_floating_point_v<T>) {
+		return "f" + std::to_string(8 * sizeof(T));
+	} else if constexpr (std::is_signed_v<T>) {
+		return "i" + std::to_string(8 * sizeof(T));
+	} else {
+		return "u" + std::to_string(8 * sizeof(T));
+	}
+}
+
+template<typename T>
+std::string storageNestingStr() {
+	if constexpr (is_tensor_v<T>) {
+		std::string inner = storageNestingStr<typename T::Inner>();
+		return T::tensorxStr() + (inner.empty() ? "" : ", " + inner);
+	} else {
+		return "";
+	}
+}
+
+// the scalar we bottom out at, or T itself if it isn't a tensor
+template<typename T>
+struct StorageScalarImpl { using type = T; };
+
+template<typename T> requires is_tensor_v<T>
+struct StorageScalarImpl<T> { using type = typename T::Scalar; };
+
+template<typename T>
+using StorageScalar = typename StorageScalarImpl<T>::type;
+
+template<typename T>
+std::string storageSignature() {
+	std::string nesting = storageNestingStr<T>();
+	return scalarTypeStr<StorageScalar<T>>() + (nesting.empty() ? "" : " " + nesting);
+}
+
+// how many scalars T actually stores, i.e. 10 for sym4 and not 16
+template<typename T>
+constexpr int storedScalarCount() {
+	static_assert(sizeof(T) % sizeof(StorageScalar<T>) == 0);
+	return (int)(sizeof(T) / sizeof(StorageScalar<T>));
+}
+
+// written as-is into headers.  a reader that sees it come back as 0x04030201 knows to byte-swap.
+inline constexpr uint32_t endianTag = 0x01020304;
+inline constexpr uint32_t endianTagSwapped = 0x04030201;
+
+}
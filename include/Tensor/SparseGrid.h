@@ -0,0 +1,317 @@
+#pragma once
+
+/*
+sparse grid of bricks
+
+cells are grouped into bricks of brick^rank, and a brick is only allocated the first time one of its cells is written.
+everything else reads as 'background'.  indexes can be anywhere, negative included -- there's no bounding box.
+bricks are kept in allocation order, and found by a hash of their brick coordinates.
+each brick is its own allocation, so a Type & into one stays valid when more bricks are added later -- s(a) = s(b) is fine even if both bricks are new.
+
+operator() on a non-const SparseGrid is a write access and allocates the brick.  read through a const ref, or get(), to not do that.
+
+bricks() visits only the allocated bricks, each as a small dense GridView.
+cursors read neighbors across brick boundaries (and background outside of any brick),
+and have the same neighbor<axis, delta>() as GridCursor, so Derivative.h's partialDerivativeGrid(cursor, dx) works on them.
+*/
+
+#include "Tensor/Grid.h"
+#include "Tensor/ThreadPool.h"
+#include "Common/Exception.h"
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+namespace Tensor {
+
+template<typename SparseGridType>
+struct SparseGridCursor;
+
+template<
+	typename Type_,
+	int rank_,
+	int brick_ = 8,
+	typename Allocator_ = std::pmr::polymorphic_allocator<Type_>
+>
+struct SparseGrid {
+	using Type = Type_;
+	using value_type = Type;
+	static constexpr auto rank = rank_;
+	using intN = Tensor::intN<rank>;
+	using Allocator = Allocator_;
+	static constexpr int brick = brick_;
+	static_assert(brick > 0 && std::has_single_bit((unsigned)brick), "brick size must be a power of two");
+	static constexpr int brickShift = std::countr_zero((unsigned)brick);
+	static constexpr int brickMask = brick - 1;
+	static constexpr int brickCells = 1 << (brickShift * rank);
+
+	struct BrickHash {
+		size_t operator()(intN const & b) const {
+			size_t h = 0;
+			for (int j = 0; j < rank; ++j) {
+				h = h * 0x9E3779B97F4A7C15ull + (size_t)(unsigned)b[j];
+			}
+			return h ^ (h >> 29);
+		}
+	};
+
+	Type background = {};
+	Allocator alloc;
+	std::vector<std::vector<Type, Allocator>> brickData;	// brick k's brickCells cells, lexicographic within the brick
+	std::vector<intN> brickCoords;	// brick k covers cells brickCoords[k] * brick + [0, brick)
+	std::unordered_map<intN, int, BrickHash> lookup;
+
+	SparseGrid() {}
+
+	explicit SparseGrid(Type const & background_, Allocator const & alloc_ = {})
+	: background(background_), alloc(alloc_) {}
+
+	// which brick, and where in it.  >> rounds toward -inf, so negative indexes work too
+	static intN brickOf(intN const & i) {
+		intN b;
+		for (int j = 0; j < rank; ++j) b[j] = i[j] >> brickShift;
+		return b;
+	}
+
+	static int localOffset(intN const & i) {
+		int o = 0;
+		for (int j = rank-1; j >= 0; --j) o = (o << brickShift) | (i[j] & brickMask);
+		return o;
+	}
+
+	static constexpr int localStep(int axis) { return 1 << (brickShift * axis); }
+
+	// brick index of brick coords b, or -1
+	int findBrick(intN const & b) const {
+		auto it = lookup.find(b);
+		return it == lookup.end() ? -1 : it->second;
+	}
+
+	int touchBrick(intN const & b) {
+		auto [it, added] = lookup.emplace(b, (int)brickCoords.size());
+		if (added) {
+			brickCoords.push_back(b);
+			brickData.emplace_back((size_t)brickCells, background, alloc);
+		}
+		return it->second;
+	}
+
+	Type * brickPtr(int k) { return brickData[k].data(); }
+	Type const * brickPtr(int k) const { return brickData[k].data(); }
+
+	Type const & get(intN const & i) const {
+		int const k = findBrick(brickOf(i));
+		return k < 0 ? background : brickPtr(k)[localOffset(i)];
+	}
+
+	// allocates the brick if it isn't already
+	Type & ref(intN const & i) {
+		return brickPtr(touchBrick(brickOf(i)))[localOffset(i)];
+	}
+
+	void set(intN const & i, Type const & x) { ref(i) = x; }
+
+	bool isActive(intN const & i) const { return findBrick(brickOf(i)) >= 0; }
+
+	Type & operator()(intN const & i) { return ref(i); }
+	Type const & operator()(intN const & i) const { return get(i); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type & operator()(int first, Rest... rest) { return ref(intN(first, rest...)); }
+
+	template<typename... Rest>
+	requires (sizeof...(Rest) == rank-1)
+	Type const & operator()(int first, Rest... rest) const { return get(intN(first, rest...)); }
+
+	int brickCount() const { return (int)brickCoords.size(); }
+	size_t activeCellCount() const { return (size_t)brickCount() * brickCells; }
+
+	// the bounding box [min, max) of the allocated bricks
+	std::pair<intN, intN> bounds() const {
+		if (brickCoords.empty()) return {};
+		intN min = brickCoords[0], max = brickCoords[0];
+		for (auto const & b : brickCoords) {
+			for (int j = 0; j < rank; ++j) {
+				min[j] = std::min(min[j], b[j]);
+				max[j] = std::max(max[j], b[j]);
+			}
+		}
+		return {min * brick, (max + 1) * brick};
+	}
+
+	template<typename TypeC>
+	struct BrickRef {
+		intN min;	// first cell
+		TypeC * v = {};
+
+		GridView<TypeC, rank> view() const { return {intN(brick), stepForSize(intN(brick)), v}; }
+		intN max() const { return min + brick; }
+	};
+
+	template<typename GridC>
+	struct BrickRange {
+		using TypeC = std::conditional_t<std::is_const_v<GridC>, Type const, Type>;
+		GridC * grid = {};
+
+		struct iterator {
+			GridC * grid = {};
+			int k = {};
+			BrickRef<TypeC> operator*() const { return {grid->brickCoords[k] * brick, grid->brickPtr(k)}; }
+			iterator & operator++() { ++k; return *this; }
+			bool operator==(iterator const & o) const { return k == o.k; }
+			bool operator!=(iterator const & o) const { return k != o.k; }
+		};
+
+		iterator begin() const { return {grid, 0}; }
+		iterator end() const { return {grid, grid->brickCount()}; }
+	};
+
+	// only the allocated bricks, in allocation order
+	BrickRange<SparseGrid> bricks() { return {this}; }
+	BrickRange<SparseGrid const> bricks() const { return {this}; }
+
+	// f(intN index, Type & cell) for every cell of every allocated brick
+	template<typename F>
+	void forEachActive(F && f) {
+		for (int k = 0; k < brickCount(); ++k) forEachInBrick(k, f);
+	}
+
+	template<typename F>
+	void forEachActive(F && f) const {
+		for (int k = 0; k < brickCount(); ++k) forEachInBrick(k, f);
+	}
+
+	// same, bricks in parallel.  f can't write cells that aren't in an allocated brick.
+	template<typename F>
+	void parallelForEachActive(F && f, ThreadPool & pool = ThreadPool::get()) {
+		pool.parallelFor(brickCount(), [&](int k) { forEachInBrick(k, f); });
+	}
+
+	template<typename Self, typename F>
+	static void forEachInBrickImpl(Self & self, int k, F && f) {
+		auto * p = self.brickPtr(k);
+		intN const min = self.brickCoords[k] * brick;
+		intN i = min;
+		for (int o = 0; o < brickCells; ++o) {
+			f((intN const &)i, p[o]);
+			for (int j = 0; j < rank; ++j) {
+				if (++i[j] < min[j] + brick) break;
+				i[j] = min[j];
+			}
+		}
+	}
+
+	template<typename F> void forEachInBrick(int k, F && f) { forEachInBrickImpl(*this, k, f); }
+	template<typename F> void forEachInBrick(int k, F && f) const { forEachInBrickImpl(*this, k, f); }
+
+	SparseGridCursor<SparseGrid const> cursor(intN const & i) const;
+
+	// dense copy of the box [min, max), background where there are no bricks
+	template<typename A = std::pmr::polymorphic_allocator<Type>>
+	Grid<Type, rank, A> copy(intN const & min, intN const & max, A const & alloc = {}) const {
+		return Grid<Type, rank, A>(max - min, [&](intN const & i) -> Type { return get(min + i); }, alloc);
+	}
+
+	// sparse copy of a dense grid, only keeping bricks with some cell != background
+	template<typename G>
+	static SparseGrid fromDense(G const & g, Type const & background = {}, intN const & origin = {}) {
+		SparseGrid s(background);
+		for (auto i : g.range()) {
+			auto const & x = g(i);
+			if (x != background) s.ref(origin + i) = x;
+		}
+		return s;
+	}
+};
+
+/*
+a cell and its neighbors, for stencils
+neighbors in the same brick are a fixed offset away, neighbors past the brick's edge go through the hash.
+the cursor can sit in a brick that isn't allocated (brickIndex < 0), then it reads background there.
+*/
+template<typename SparseGridType>
+struct SparseGridCursor {
+	using G = std::remove_const_t<SparseGridType>;
+	static constexpr auto rank = G::rank;
+	using intN = Tensor::intN<rank>;
+	using Type = typename G::Type const;
+
+	SparseGridType * grid = {};
+	intN index;
+	int brickIndex = -1;
+	int local = {};	// offset within the brick
+	Type * cells = {};	// the brick's cells, if brickIndex >= 0
+
+	SparseGridCursor() {}
+	SparseGridCursor(SparseGridType * grid_, intN const & index_)
+	:	grid(grid_),
+		index(index_),
+		brickIndex(grid_->findBrick(G::brickOf(index_))),
+		local(G::localOffset(index_)),
+		cells(brickIndex < 0 ? nullptr : grid_->brickPtr(brickIndex))
+	{}
+
+	// when the caller already knows the brick
+	SparseGridCursor(SparseGridType * grid_, intN const & index_, int brickIndex_)
+	:	grid(grid_),
+		index(index_),
+		brickIndex(brickIndex_),
+		local(G::localOffset(index_)),
+		cells(brickIndex_ < 0 ? nullptr : grid_->brickPtr(brickIndex_))
+	{}
+
+	Type & operator*() const {
+		return brickIndex < 0 ? grid->background : cells[local];
+	}
+
+	template<int axis, int delta>
+	Type & neighbor() const {
+		static_assert(axis >= 0 && axis < rank, "neighbor axis out of bounds");
+		int const j = (index[axis] & G::brickMask) + delta;
+		if (brickIndex >= 0 && j >= 0 && j < G::brick) {
+			return cells[local + delta * G::localStep(axis)];
+		}
+		intN i = index;
+		i[axis] += delta;
+		return grid->get(i);
+	}
+
+	Type & neighbor(intN const & delta) const {
+		return grid->get(index + delta);
+	}
+};
+
+template<typename Type, int rank, int brick, typename Allocator>
+SparseGridCursor<SparseGrid<Type, rank, brick, Allocator> const> SparseGrid<Type, rank, brick, Allocator>::cursor(intN const & i) const {
+	return {this, i};
+}
+
+/*
+dst(i) = f(cursor into src at i) for every cell of every brick of dst,
+after giving dst every brick of src, and with grow > 0 every brick within 'grow' bricks of those, so things can spread into the background.
+dst's bricks are allocated up front, then filled in parallel.
+*/
+template<typename D, typename S, typename F>
+void sparseStencil(D & dst, S const & src, F && f, int grow = 0, ThreadPool & pool = ThreadPool::get()) {
+	using intN = typename S::intN;
+	constexpr int rank = S::rank;
+	static_assert(D::brick == S::brick, "sparseStencil needs the same brick size");
+	for (int k = 0; k < src.brickCount(); ++k) {
+		if (grow <= 0) {
+			dst.touchBrick(src.brickCoords[k]);
+		} else {
+			for (auto d : RangeObj<rank>(intN(-grow), intN(grow + 1))) {
+				dst.touchBrick(src.brickCoords[k] + d);
+			}
+		}
+	}
+	pool.parallelFor(dst.brickCount(), [&](int k) {
+		int const srcK = src.findBrick(dst.brickCoords[k]);
+		dst.forEachInBrick(k, [&](intN const & i, auto & x) {
+			x = f(SparseGridCursor<S const>(&src, i, srcK));
+		});
+	});
+}
+
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include "Tensor/Vector.h"
+#include "Tensor/Quat.h"
+#include "Common/Exception.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <utility>
+
+/*
+singular value and polar decompositions of small matrices
+
+svd(mat<T,M,N>) for M, N <= 4 returns A = U diag(sigma) V^T, with sigma descending and >= 0,
+U M x K and V N x K with orthonormal columns, K = min(M, N).
+
+3x3 goes the way of McAdams et al, "Computing the Singular Value Decomposition of 3x3 matrices with minimal branching and elementary floating point operations":
+	1) Jacobi on A^T A, a fixed number of sweeps, accumulating V as a quat
+	2) sort the columns of A V by length, as 90 degree rotations so V stays a rotation
+	3) QR of A V by Givens rotations, accumulating U as a quat.  R's diagonal is sigma.
+there's no branching, only selects, so the same steps run for every matrix of a batch.
+svdRotations(mat3x3) returns that as is: U and V are rotations (quats), and sigma[2] < 0 when det(A) < 0.
+that's the one deformation gradients want, since an inverted element stays a rotation times a (negative) stretch.
+the small singular values go through A^T A, so they're accurate relative to the largest one, not to themselves.
+
+everything else is one-sided Jacobi on the columns of A, or of A^T when M < N.
+
+polar(mat3x3) = R S, with R = U V^T a rotation (quat) and S = V diag(sigma) V^T, from svdRotations,
+so S has a negative eigenvalue when det(A) < 0.
+*/
+
+namespace Tensor {
+
+template<typename T, int M, int N>
+struct Svd {
+	static constexpr int K = M < N ? M : N;
+	mat<T,M,K> U;
+	vec<T,K> sigma;
+	mat<T,N,K> V;
+};
+
+template<typename T>
+struct SvdRotations {
+	quat<T> U;
+	vec3<T> sigma;
+	quat<T> V;
+};
+
+template<typename T>
+struct Polar {
+	quat<T> R;
+	sym<T,3> S;
+};
+
+namespace SvdDetail {
+
+// Jacobi sweeps on A^T A.  each converges quadratically, so these are plenty for 3x3
+template<typename T> constexpr int sweeps = 6;
+template<> constexpr int sweeps<float> = 4;
+
+// q *= (s e_k, c), a rotation about axis k
+template<int k, typename T>
+[[gnu::always_inline]] inline void mulAxis(T (&q)[4], T s, T c) {
+	T const x = q[0], y = q[1], z = q[2], w = q[3];
+	if constexpr (k == 0) {
+		q[0] = c * x + s * w;
+		q[1] = c * y + s * z;
+		q[2] = c * z - s * y;
+		q[3] = c * w - s * x;
+	} else if constexpr (k == 1) {
+		q[0] = c * x - s * z;
+		q[1] = c * y + s * w;
+		q[2] = c * z + s * x;
+		q[3] = c * w - s * y;
+	} else {
+		q[0] = c * x + s * y;
+		q[1] = c * y - s * x;
+		q[2] = c * z + s * w;
+		q[3] = c * w - s * z;
+	}
+}
+
+/*
+one Jacobi rotation J of the symmetric s, in the (p,q) plane: s <- J^T s J, zeroing s(p,q), and V <- V J.
+J = [c s; -s c] in (p,q), which is a rotation by -theta about the third axis r, or +theta for r = 1, since that one's the other way around.
+tan(theta/2) = s / (1 + c) = tau, so the quat doesn't need any more square roots than the rotation does.
+*/
+template<int p, int q, typename T>
+[[gnu::always_inline]] inline void jacobi(T (&s)[3][3], T (&qv)[4]) {
+	constexpr int r = 3 - p - q;
+	T const apq = s[p][q];
+	T const d = s[q][q] - s[p][p];
+	// t = tan(theta), the smaller root.  den only gets min() so apq = d = 0 gives t = 0 without a select around the division
+	T const den = std::abs(d) + std::sqrt(d * d + 4 * apq * apq) + std::numeric_limits<T>::min();
+	T const t = 2 * apq * (d >= 0 ? 1 : -1) / den;
+	T const c = 1 / std::sqrt(1 + t * t);
+	T const sn = t * c;
+	T const tau = sn / (1 + c);
+	s[p][p] -= t * apq;
+	s[q][q] += t * apq;
+	s[p][q] = s[q][p] = 0;
+	T const rp = s[r][p], rq = s[r][q];
+	s[r][p] = s[p][r] = rp - sn * (rq + tau * rp);
+	s[r][q] = s[q][r] = rq + sn * (rp - tau * rq);
+	T const ch = 1 / std::sqrt(1 + tau * tau);
+	T const sh = tau * ch;
+	mulAxis<r>(qv, r == 1 ? sh : -sh, ch);
+}
+
+// swap columns i and j of b when j is longer, as b <- b P, P = [0 -1; 1 0] in (i,j), a 90 degree rotation.  V <- V P.
+template<int i, int j, typename T>
+[[gnu::always_inline]] inline void sortColumns(T (&b)[3][3], T (&qv)[4]) {
+	constexpr int r = 3 - i - j;
+	T const ni = b[0][i] * b[0][i] + b[1][i] * b[1][i] + b[2][i] * b[2][i];
+	T const nj = b[0][j] * b[0][j] + b[1][j] * b[1][j] + b[2][j] * b[2][j];
+	bool const swap = ni < nj;
+	for (int k = 0; k < 3; ++k) {
+		T const bi = b[k][i], bj = b[k][j];
+		b[k][i] = swap ? bj : bi;
+		b[k][j] = swap ? -bi : bj;
+	}
+	// f = swap as 0 or 1.  not a select: GCC turns selects of constants that get multiplied into branches, which stop vectorization
+	T const h = (T)std::sqrt(.5);
+	T const f = (1 - std::copysign((T)1, ni - nj)) / 2;
+	mulAxis<r>(qv, f * (r == 1 ? -h : h), 1 + f * (h - 1));
+}
+
+/*
+Givens rotation G in the (p,q) rows of b, zeroing b(q,p), with the new b(p,p) >= 0.  U <- U G^T.
+with (c, s) = (cos phi, sin phi) = (b(p,p), b(q,p)) / r, the half angle is
+tan(phi/2) = b(q,p) / (r + b(p,p)) = (r - b(p,p)) / b(q,p), whichever doesn't cancel.
+as (ch, sh) that's (r + |b(p,p)|, b(q,p)) for b(p,p) >= 0, swapped otherwise, here divided through by big = r + |b(p,p)| and blended by f = 0 or 1.
+G^T is a rotation by +phi about the third axis, or -phi for r = 1.
+*/
+template<int p, int q, typename T>
+[[gnu::always_inline]] inline void givens(T (&b)[3][3], T (&qu)[4]) {
+	constexpr int r = 3 - p - q;
+	T const ap = b[p][p], aq = b[q][p];
+	T const rho = std::sqrt(ap * ap + aq * aq);
+	// min() so a zero column gets u = 0, i.e. c = +-1, s = 0: nothing to rotate but maybe a half turn
+	T const big = rho + std::abs(ap) + std::numeric_limits<T>::min();
+	T const f = (1 + std::copysign((T)1, ap)) / 2;
+	T const u = aq / big;
+	T const ch = f + (1 - f) * u;
+	T const sh = f * u + (1 - f);
+	T const n2 = 1 + u * u;
+	T const c = (2 * f - 1) * (1 - u * u) / n2;
+	T const s = 2 * u / n2;
+	for (int k = 0; k < 3; ++k) {
+		T const bp = b[p][k], bq = b[q][k];
+		b[p][k] = c * bp + s * bq;
+		b[q][k] = c * bq - s * bp;
+	}
+	T const invN = 1 / std::sqrt(n2);
+	mulAxis<r>(qu, (r == 1 ? -sh : sh) * invN, ch * invN);
+}
+
+template<typename T, size_t... is>
+[[gnu::always_inline]] inline void jacobiSweeps(T (&s)[3][3], T (&qv)[4], std::index_sequence<is...>) {
+	((jacobi<0,1>(s, qv), jacobi<1,2>(s, qv), jacobi<0,2>(s, qv), (void)is), ...);
+}
+
+// the whole 3x3 signed svd, on plain scalars.  it and its helpers are always_inline so the block loop below gets all of it, and vectorizes
+template<typename T>
+[[gnu::always_inline]] inline void svd3(T const (&a)[3][3], T (&qu)[4], T (&sigma)[3], T (&qv)[4]) {
+	T s[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			s[i][j] = a[0][i] * a[0][j] + a[1][i] * a[1][j] + a[2][i] * a[2][j];
+		}
+	}
+	qv[0] = qv[1] = qv[2] = 0;
+	qv[3] = 1;
+	jacobiSweeps(s, qv, std::make_index_sequence<sweeps<T>>());
+	T const n = 1 / std::sqrt(qv[0] * qv[0] + qv[1] * qv[1] + qv[2] * qv[2] + qv[3] * qv[3]);
+	for (int k = 0; k < 4; ++k) qv[k] *= n;
+
+	// b = a V
+	T const x = qv[0], y = qv[1], z = qv[2], w = qv[3];
+	T const v[3][3] = {
+		{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+		{2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+		{2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)},
+	};
+	T b[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			b[i][j] = a[i][0] * v[0][j] + a[i][1] * v[1][j] + a[i][2] * v[2][j];
+		}
+	}
+	sortColumns<0,1>(b, qv);
+	sortColumns<0,2>(b, qv);
+	sortColumns<1,2>(b, qv);
+
+	qu[0] = qu[1] = qu[2] = 0;
+	qu[3] = 1;
+	givens<0,1>(b, qu);
+	givens<0,2>(b, qu);
+	givens<1,2>(b, qu);
+	sigma[0] = b[0][0];
+	sigma[1] = b[1][1];
+	sigma[2] = b[2][2];
+}
+
+template<typename T>
+SvdRotations<T> svd3(mat3x3<T> const & m) {
+	T a[3][3], qu[4], sigma[3], qv[4];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) a[i][j] = m(i,j);
+	}
+	svd3(a, qu, sigma, qv);
+	return {
+		quat<T>(qu[0], qu[1], qu[2], qu[3]),
+		vec3<T>(sigma[0], sigma[1], sigma[2]),
+		quat<T>(qv[0], qv[1], qv[2], qv[3]),
+	};
+}
+
+template<typename T>
+Polar<T> polarFromSvd(SvdRotations<T> const & d) {
+	Polar<T> r;
+	r.R = d.U * d.V.conjugate();
+	auto const v = d.V.toMatrix();
+	for (int i = 0; i < 3; ++i) {
+		for (int j = i; j < 3; ++j) {
+			r.S(i,j) = v(i,0) * d.sigma[0] * v(j,0) + v(i,1) * d.sigma[1] * v(j,1) + v(i,2) * d.sigma[2] * v(j,2);
+		}
+	}
+	return r;
+}
+
+/*
+one-sided Jacobi for M >= N: rotate the columns of w = A until they're orthogonal, accumulating V.
+then sigma_k = |w_k| and U's columns are w_k / sigma_k.
+*/
+template<typename T, int M, int N>
+requires (M >= N)
+Svd<T,M,N> oneSided(mat<T,M,N> const & a) {
+	T w[N][M];
+	for (int k = 0; k < N; ++k) {
+		for (int i = 0; i < M; ++i) w[k][i] = a(i,k);
+	}
+	mat<T,N,N> v([](int i, int j) -> T { return i == j; });
+	constexpr T eps = std::numeric_limits<T>::epsilon();
+	for (int sweep = 0; sweep < 50; ++sweep) {
+		bool rotated = false;
+		for (int p = 0; p < N; ++p) {
+			for (int q = p + 1; q < N; ++q) {
+				T alpha = 0, beta = 0, gamma = 0;
+				for (int i = 0; i < M; ++i) {
+					alpha += w[p][i] * w[p][i];
+					beta += w[q][i] * w[q][i];
+					gamma += w[p][i] * w[q][i];
+				}
+				if (!(std::abs(gamma) > eps * std::sqrt(alpha * beta))) continue;
+				rotated = true;
+				T const zeta = (beta - alpha) / (2 * gamma);
+				T const t = (zeta >= 0 ? 1 : -1) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+				T const c = 1 / std::sqrt(1 + t * t);
+				T const s = t * c;
+				for (int i = 0; i < M; ++i) {
+					T const wp = w[p][i], wq = w[q][i];
+					w[p][i] = c * wp - s * wq;
+					w[q][i] = s * wp + c * wq;
+				}
+				for (int i = 0; i < N; ++i) {
+					T const vp = v(i,p), vq = v(i,q);
+					v(i,p) = c * vp - s * vq;
+					v(i,q) = s * vp + c * vq;
+				}
+			}
+		}
+		if (!rotated) break;
+	}
+
+	Svd<T,M,N> r;
+	int order[N];
+	for (int k = 0; k < N; ++k) {
+		order[k] = k;
+		T n = 0;
+		for (int i = 0; i < M; ++i) n += w[k][i] * w[k][i];
+		r.sigma[k] = std::sqrt(n);
+	}
+	std::sort(order, order + N, [&](int i, int j) { return r.sigma[i] > r.sigma[j]; });
+	vec<T,N> sigma = r.sigma;
+	for (int k = 0; k < N; ++k) {
+		int const o = order[k];
+		r.sigma[k] = sigma[o];
+		for (int i = 0; i < N; ++i) r.V(i,k) = v(i,o);
+		for (int i = 0; i < M; ++i) r.U(i,k) = w[o][i];
+	}
+	// U's columns: normalize, or for a zero sigma, Gram-Schmidt the unit vector that's furthest from the span of the rest.
+	// that one's residual is at least 1/sqrt(M), since the residuals' squares sum to M - k >= 1
+	T const tiny = eps * (r.sigma[0] > 0 ? r.sigma[0] : 1);
+	for (int k = 0; k < N; ++k) {
+		if (r.sigma[k] > tiny) {
+			for (int i = 0; i < M; ++i) r.U(i,k) /= r.sigma[k];
+			continue;
+		}
+		vec<T,M> best;
+		T bestLen = -1;
+		for (int e = 0; e < M; ++e) {
+			vec<T,M> u;
+			u[e] = 1;
+			for (int l = 0; l < k; ++l) {
+				T d = 0;
+				for (int i = 0; i < M; ++i) d += r.U(i,l) * u[i];
+				for (int i = 0; i < M; ++i) u[i] -= d * r.U(i,l);
+			}
+			T const len = u.length();
+			if (len > bestLen) {
+				best = u;
+				bestLen = len;
+			}
+		}
+		for (int i = 0; i < M; ++i) r.U(i,k) = best[i] / bestLen;
+	}
+	return r;
+}
+}
+
+template<typename T>
+SvdRotations<T> svdRotations(mat3x3<T> const & a) {
+	return SvdDetail::svd3(a);
+}
+
+template<typename T, int M, int N>
+requires (M <= 4 && N <= 4)
+Svd<T,M,N> svd(mat<T,M,N> const & a) {
+	if constexpr (M == 3 && N == 3) {
+		// unsign sigma[2] by flipping U's last column
+		auto const d = svdRotations(a);
+		Svd<T,3,3> r;
+		r.U = d.U.toMatrix();
+		r.V = d.V.toMatrix();
+		r.sigma = d.sigma;
+		if (r.sigma[2] < 0) {
+			r.sigma[2] = -r.sigma[2];
+			for (int i = 0; i < 3; ++i) r.U(i,2) = -r.U(i,2);
+		}
+		return r;
+	} else if constexpr (M >= N) {
+		return SvdDetail::oneSided(a);
+	} else {
+		auto const t = SvdDetail::oneSided(mat<T,N,M>([&](int i, int j) -> T { return a(j,i); }));
+		return {t.V, t.sigma, t.U};
+	}
+}
+
+template<typename T>
+Polar<T> polar(mat3x3<T> const & a) {
+	return SvdDetail::polarFromSvd(svdRotations(a));
+}
+
+/*
+batched
+3x3s go through in blocks, split into component arrays, and svd3 is inlined into a loop over the block, one matrix per SIMD lane.
+svd3 has no branches, so GCC vectorizes that loop at -O3, as long as std::sqrt doesn't have to set errno (-fno-math-errno).
+*/
+namespace SvdDetail {
+inline constexpr int block = 16;
+
+template<typename T, typename Store>
+void svd3Blocks(std::span<mat3x3<T> const> a, Store && store) {
+	constexpr int B = block;
+	size_t const n = a.size();
+	for (size_t begin = 0; begin < n; begin += B) {
+		int const count = (int)std::min<size_t>(B, n - begin);
+		T m[9][B] = {};
+		for (int k = 0; k < count; ++k) {
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 3; ++j) m[3 * i + j][k] = a[begin + k](i,j);
+			}
+		}
+		T qu[4][B], sigma[3][B], qv[4][B];
+		for (int k = 0; k < B; ++k) {
+			T const ak[3][3] = {
+				{m[0][k], m[1][k], m[2][k]},
+				{m[3][k], m[4][k], m[5][k]},
+				{m[6][k], m[7][k], m[8][k]},
+			};
+			T quk[4], sk[3], qvk[4];
+			svd3(ak, quk, sk, qvk);
+			for (int c = 0; c < 4; ++c) {
+				qu[c][k] = quk[c];
+				qv[c][k] = qvk[c];
+			}
+			for (int c = 0; c < 3; ++c) sigma[c][k] = sk[c];
+		}
+		for (int k = 0; k < count; ++k) {
+			store(begin + k, SvdRotations<T>{
+				quat<T>(qu[0][k], qu[1][k], qu[2][k], qu[3][k]),
+				vec3<T>(sigma[0][k], sigma[1][k], sigma[2][k]),
+				quat<T>(qv[0][k], qv[1][k], qv[2][k], qv[3][k]),
+			});
+		}
+	}
+}
+}
+
+template<typename T>
+void svdRotations(std::span<mat3x3<T> const> a, std::span<SvdRotations<std::type_identity_t<T>>> dst) {
+	if (a.size() != dst.size()) throw Common::Exception() << a.size() << " matrices for " << dst.size() << " decompositions";
+	SvdDetail::svd3Blocks<T>(a, [&](size_t i, SvdRotations<T> const & d) { dst[i] = d; });
+}
+
+template<typename T>
+void polar(std::span<mat3x3<T> const> a, std::span<Polar<std::type_identity_t<T>>> dst) {
+	if (a.size() != dst.size()) throw Common::Exception() << a.size() << " matrices for " << dst.size() << " decompositions";
+	SvdDetail::svd3Blocks<T>(a, [&](size_t i, SvdRotations<T> const & d) { dst[i] = SvdDetail::polarFromSvd(d); });
+}
+
+// other sizes go one at a time
+template<typename T, int M, int N>
+void svd(std::span<mat<T,M,N> const> a, std::span<Svd<std::type_identity_t<T>,M,N>> dst) {
+	if (a.size() != dst.size()) throw Common::Exception() << a.size() << " matrices for " << dst.size() << " decompositions";
+	for (size_t i = 0; i < a.size(); ++i) dst[i] = svd(a[i]);
+}
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tensor {
+
+/*
+small work-stealing thread pool
+
+each worker has its own deque of tasks.  it pops from the back of its own and steals from the front of everyone else's.
+parallelFor() hands out a batch of tasks round-robin, then the calling thread helps run tasks until its batch is done,
+so calling parallelFor() from inside a task won't deadlock.
+
+tasks are type-erased, so hand it coarse chunks of work (like a slab of a Grid), not single cells.
+*/
+struct ThreadPool {
+	using Task = std::function<void()>;
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;	// one per worker
+	std::vector<std::thread> threads;
+	std::atomic<int> pending = {};				// tasks queued but not yet picked up
+	std::atomic<int> nextQueue = {};			// round-robin for pushing
+	std::mutex sleepMutex;
+	std::condition_variable sleepCV;
+	bool done = {};
+
+	static int defaultNumThreads() {
+		return std::max<int>(1, std::thread::hardware_concurrency());
+	}
+
+	// numThreads counts the caller, since it helps out in parallelFor
+	// so ThreadPool(1) runs everything on the calling thread
+	explicit ThreadPool(int numThreads = defaultNumThreads()) {
+		int const numWorkers = std::max(0, numThreads - 1);
+		for (int i = 0; i < numWorkers; ++i) {
+			queues.emplace_back(std::make_unique<Queue>());
+		}
+		for (int i = 0; i < numWorkers; ++i) {
+			threads.emplace_back([this, i]() { workerLoop(i); });
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			done = true;
+		}
+		sleepCV.notify_all();
+		for (auto & t : threads) t.join();
+	}
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool & operator=(ThreadPool const &) = delete;
+
+	int numThreads() const { return (int)threads.size() + 1; }
+
+	// shared pool used by default by the Grid algorithms
+	static ThreadPool & get() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	/*
+	calls f(i) for i in [0,n) and blocks until they are all done
+	the first exception thrown by any f(i) is rethrown here, after the rest of the batch finishes
+	*/
+	template<typename F>
+	void parallelFor(int n, F && f) {
+		if (n <= 0) return;
+		if (n == 1 || queues.empty()) {
+			for (int i = 0; i < n; ++i) f(i);
+			return;
+		}
+
+		struct Batch {
+			std::atomic<int> remaining;
+			std::mutex errorMutex;
+			std::exception_ptr error;
+		} batch;
+		batch.remaining = n;
+
+		for (int i = 0; i < n; ++i) {
+			push([&batch, &f, i]() {
+				try {
+					f(i);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(batch.errorMutex);
+					if (!batch.error) batch.error = std::current_exception();
+				}
+				--batch.remaining;
+			});
+		}
+
+		// help out until our batch is done
+		while (batch.remaining > 0) {
+			if (!runOne(-1)) std::this_thread::yield();
+		}
+		if (batch.error) std::rethrow_exception(batch.error);
+	}
+
+	void push(Task task) {
+		auto & q = *queues[(unsigned)nextQueue++ % queues.size()];
+		{
+			std::lock_guard<std::mutex> lock(q.mutex);
+			q.tasks.emplace_back(std::move(task));
+		}
+		{
+			// hold sleepMutex so a worker can't check 'pending' and then miss this notify
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			++pending;
+		}
+		sleepCV.notify_one();
+	}
+
+	// run one task: from our own queue's back if we are a worker, else steal from the front of anyone's
+	bool runOne(int self) {
+		Task task;
+		if (self >= 0) {
+			auto & q = *queues[self];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (!q.tasks.empty()) {
+				task = std::move(q.tasks.back());
+				q.tasks.pop_back();
+			}
+		}
+		for (size_t k = 0; !task && k < queues.size(); ++k) {
+			auto & q = *queues[(self + 1 + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (!q.tasks.empty()) {
+				task = std::move(q.tasks.front());
+				q.tasks.pop_front();
+			}
+		}
+		if (!task) return false;
+		--pending;
+		task();
+		return true;
+	}
+
+	void workerLoop(int self) {
+		for (;;) {
+			if (runOne(self)) continue;
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepCV.wait(lock, [this]() { return done || pending > 0; });
+			if (done) return;
+		}
+	}
+};
+
+}
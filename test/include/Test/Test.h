@@ -6,6 +6,11 @@
 void test_AntiSymRef();
 void test_Vector();
 void test_Quat();
+void test_DualQuat();
+void test_Multivector();
+void test_MatrixExp();
+void test_Eigen();
+void test_Svd();
 void test_Identity();
 void test_Matrix();
 void test_Symmetric();
@@ -17,6 +22,19 @@ void test_TotallyAntisymmetric();
 void test_Math();
 void test_Index();
 void test_Derivative();
+void test_Grid();
+void test_GridParallel();
+void test_Memory();
+void test_MappedGrid();
+void test_GridStream();
+void test_GridIO();
+void test_Compression();
+void test_GridGhost();
+void test_GridDecomposition();
+void test_GridLayout();
+void test_PlanarGrid();
+void test_SparseGrid();
+void test_Npy();
 void test_Valence();
 
 template<typename T>
@@ -0,0 +1,136 @@
+#include "Test/Test.h"
+#include "Tensor/Compression.h"
+#include "Tensor/GridIO.h"
+#include <random>
+#include <sstream>
+
+void test_Compression() {
+	using namespace Tensor;
+
+	auto lzRoundTrip = [](std::vector<uint8_t> const & src) -> size_t {
+		auto packed = lzCompress(src.data(), src.size());
+		TEST_BOOL(packed.size() <= lzMaxCompressedSize(src.size()));
+		std::vector<uint8_t> back(src.size());
+		lzDecompress(packed.data(), packed.size(), back.data(), back.size());
+		TEST_BOOL(back == src);
+		return packed.size();
+	};
+
+	// lz: empty, tiny, random, repetitive, overlapping matches
+	{
+		std::mt19937 rng(1);
+		lzRoundTrip({});
+		lzRoundTrip({1, 2, 3});
+		std::vector<uint8_t> random(100000);
+		for (auto & b : random) b = (uint8_t)rng();
+		lzRoundTrip(random);
+		std::vector<uint8_t> runs(100000);
+		for (size_t k = 0; k < runs.size(); ++k) runs[k] = (uint8_t)(k / 1000);
+		TEST_BOOL(lzRoundTrip(runs) < runs.size() / 50);
+		std::vector<uint8_t> pattern(5000);
+		for (size_t k = 0; k < pattern.size(); ++k) pattern[k] = "abc"[k % 3];
+		TEST_BOOL(lzRoundTrip(pattern) < 100);
+
+		// corrupt input throws rather than writing out of bounds
+		auto packed = lzCompress(runs.data(), runs.size());
+		std::vector<uint8_t> back(runs.size());
+		bool threw = false;
+		try {
+			lzDecompress(packed.data(), packed.size() / 2, back.data(), back.size());
+		} catch (std::exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+
+	// shuffle
+	{
+		std::vector<uint8_t> src = {1, 2, 3, 4, 5, 6, 7, 8};
+		std::vector<uint8_t> dst(8), back(8);
+		byteShuffle(src.data(), 8, 4, dst.data());
+		TEST_BOOL((dst == std::vector<uint8_t>{1, 5, 2, 6, 3, 7, 4, 8}));
+		byteUnshuffle(dst.data(), 8, 4, back.data());
+		TEST_BOOL(back == src);
+	}
+
+	// lorenzo keeps every value within the bound, and NaN/inf exactly
+	{
+		std::vector<double> x(1000);
+		for (size_t k = 0; k < x.size(); ++k) x[k] = std::sin(k * .01) * 100;
+		x[10] = std::numeric_limits<double>::infinity();
+		x[20] = 1e+300;
+		auto r = lorenzoEncode(x.data(), x.size(), 2, 1e-3);
+		std::vector<double> y(x.size());
+		lorenzoDecode(r, y.data(), y.size(), 2, 1e-3);
+		double maxErr = 0;
+		for (size_t k = 0; k < x.size(); ++k) {
+			if (k != 10) maxErr = std::max(maxErr, std::abs(x[k] - y[k]));
+		}
+		TEST_BOOL(maxErr <= 1e-3);
+		TEST_EQ(y[10], x[10]);
+		TEST_EQ(y[20], x[20]);
+	}
+
+	// through GridIO
+	auto size = int3(32, 32, 16);
+	auto g = Grid<sym<float, 4>, 3>(size, [](int3 i) -> sym<float, 4> {
+		float const r = (float)(i.x * .1 + i.y * .05 + i.z * .02);
+		return sym<float, 4>(std::sin(r), std::cos(r), r, r * r, 1, 2, std::sin(2 * r), 0, 0, r);
+	});
+	ThreadPool pool4(4);
+	size_t rawBytes;
+	{
+		std::stringstream s;
+		writeGrid(s, g);
+		rawBytes = s.str().size();
+	}
+	// lossless is bit exact, and smaller for a smooth field
+	{
+		std::stringstream s;
+		writeGrid(s, g, {.chunkBytes = 1 << 16, .codec = GridCodec::Shuffle, .pool = &pool4});
+		TEST_BOOL(s.str().size() < rawBytes);
+		auto info = readGridInfo(s);
+		TEST_BOOL(info.codec == GridCodec::Shuffle);
+		s.seekg(0);
+		auto h = readGrid<sym<float, 4>, 3>(s, {}, pool4);
+		bool same = true;
+		for (auto i : g.range()) same = same && h(i) == g(i);
+		TEST_BOOL(same);
+	}
+	// lossy stays within its bound, and is smaller still
+	for (double bound : {1e-2, 1e-5}) {
+		std::stringstream s;
+		writeGrid(s, g, {.chunkBytes = 1 << 16, .codec = GridCodec::Lorenzo, .errorBound = bound, .pool = &pool4});
+		TEST_BOOL(s.str().size() < rawBytes / 2);
+		auto h = readGrid<sym<float, 4>, 3>(s, {}, pool4);
+		float maxErr = 0;
+		for (auto i : g.range()) {
+			for (int k = 0; k < 10; ++k) {
+				maxErr = std::max(maxErr, std::abs(h(i).s[k] - g(i).s[k]));
+			}
+		}
+		TEST_BOOL(maxErr <= bound);
+	}
+	// same bytes for any pool size
+	{
+		ThreadPool pool1(1);
+		std::stringstream s1, s4;
+		writeGrid(s1, g, {.chunkBytes = 1 << 14, .codec = GridCodec::Lorenzo, .errorBound = 1e-4, .pool = &pool1});
+		writeGrid(s4, g, {.chunkBytes = 1 << 14, .codec = GridCodec::Lorenzo, .errorBound = 1e-4, .pool = &pool4});
+		TEST_BOOL(s1.str() == s4.str());
+	}
+	// lossy needs floats and a bound
+	{
+		auto throws = [](auto f) -> bool {
+			try {
+				f();
+			} catch (std::exception const &) {
+				return true;
+			}
+			return false;
+		};
+		std::stringstream s;
+		TEST_BOOL(throws([&]() { writeGrid(s, Grid<int, 1>(intN<1>(4)), {.codec = GridCodec::Lorenzo, .errorBound = 1}); }));
+		TEST_BOOL(throws([&]() { writeGrid(s, g, {.codec = GridCodec::Lorenzo}); }));
+	}
+}
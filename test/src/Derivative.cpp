@@ -1,7 +1,43 @@
-#include "Tensor/Tensor.h"
+#include "Test/Test.h"
+#include "Tensor/Grid.h"
 #include "Tensor/Derivative.h"
 
 void test_Derivative() {
+	using namespace Tensor;
 
+	// f = x^2 + 3xy , df = (2x + 3y, 3x)
+	auto f = [](int2 i) -> double { return i.x * i.x + 3 * i.x * i.y; };
+	auto df = [](int2 i) -> double2 { return double2(2 * i.x + 3 * i.y, 3 * i.x); };
+	auto dx = double2(1, 1);
+	auto g = Grid<double, 2>(int2(8, 8), f);
 
+	// std::function version
+	TEST_EQ((partialDerivativeGrid<2, double, 2, double>(int2(3, 4), dx, f)), df(int2(3, 4)));
+	TEST_EQ_EPS(distance(partialDerivativeGrid<4, double, 2, double>(int2(3, 4), dx, f), df(int2(3, 4))), 0, 1e-12);
+
+	// cursor version
+	for (auto const & c : g.interiorRange<1>()) {
+		TEST_EQ(partialDerivativeGrid<2>(c, dx), df(c.index));
+	}
+	for (auto const & c : g.interiorRange<2>()) {
+		TEST_EQ_EPS(distance(partialDerivativeGrid<4>(c, dx), df(c.index)), 0, 1e-12);
+	}
+
+	// tensor-valued
+	auto gv = Grid<double2, 2>(g.size, [&](int2 i) -> double2 { return double2(f(i), 2 * f(i)); });
+	for (auto const & c : gv.interiorRange<1>()) {
+		auto d = partialDerivativeGrid<2>(c, dx);
+		static_assert(std::is_same_v<decltype(d), double2x2>);
+		TEST_EQ(d, double2x2(df(c.index), 2. * df(c.index)).transpose());
+	}
+
+	// Grids and views directly
+	TEST_EQ(partialDerivativeGrid<2>(int2(3, 4), dx, g), df(int2(3, 4)));
+	auto gt = g.view().transpose();
+	TEST_EQ(partialDerivativeGrid<2>(int2(4, 3), dx, gt), double2(3 * 3, 2 * 3 + 3 * 4));
+	auto g3 = Grid<double, 3>(int3(8, 8, 8), [&](int3 i) -> double { return f(int2(i.x, i.z)); });
+	auto plane = g3.view().fixAxis<1>(5);
+	for (auto const & c : plane.interiorRange<1>()) {
+		TEST_EQ(partialDerivativeGrid<2>(c, dx), df(c.index));
+	}
 }
@@ -0,0 +1,147 @@
+#include "Test/Test.h"
+#include "Tensor/DualQuat.h"
+
+void test_DualQuat() {
+	using namespace Tensor;
+	using DQ = dualquatd;
+	double const eps = 1e-9;
+
+	auto const r = normalize(quatd(.3, -.5, .7, .4));
+	double3 const t = {1, -2, 3};
+	auto const q = DQ::fromRotationTranslation(r, t);
+	double3 const p = {.5, 4, -1};
+
+	// rotate, then translate
+	TEST_EQ_EPS(q.translation().distance(t), 0, eps);
+	TEST_EQ_EPS(q.transformPoint(p).distance(r.rotate(p) + t), 0, eps);
+	TEST_EQ_EPS(q.transformVector(p).distance(r.rotate(p)), 0, eps);
+	TEST_EQ_EPS(DQ::identity().transformPoint(p).distance(p), 0, eps);
+	TEST_EQ_EPS(DQ::fromTranslation(t).transformPoint(p).distance(p + t), 0, eps);
+
+	// same as the matrices
+	auto const axisAngle = r.toAngleAxis();
+	auto const m = translate(t) * rotate(axisAngle.w, double3(axisAngle.x, axisAngle.y, axisAngle.z));
+	auto const qm = q.toMatrix();
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			TEST_EQ_EPS(qm(i,j), m(i,j), eps);
+		}
+	}
+	auto const fromM = DQ::fromMatrix(m);
+	TEST_EQ_EPS(fromM.transformPoint(p).distance(q.transformPoint(p)), 0, eps);
+	// quat::fromMatrix from each of its branches
+	for (auto const & rr : {
+		quatd(0, 0, 0, 1),
+		normalize(quatd(1, .1, .2, .05)),
+		normalize(quatd(.1, 1, .2, .05)),
+		normalize(quatd(.1, .2, 1, .05)),
+	}) {
+		auto const back = quatd::fromMatrix(rr.toMatrix());
+		TEST_EQ_EPS(back.distance(rr), 0, eps);
+	}
+
+	// compose: b first, then a
+	auto const b = DQ::fromRotationTranslation(normalize(quatd(-1, 2, .5, 1)), double3(.1, .2, -.3));
+	TEST_EQ_EPS((q * b).transformPoint(p).distance(q.transformPoint(b.transformPoint(p))), 0, eps);
+	auto const mqb = (q * b).toMatrix(), mq_mb = q.toMatrix() * b.toMatrix();
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			TEST_EQ_EPS(mqb(i,j), mq_mb(i,j), eps);
+		}
+	}
+
+	// inverse
+	TEST_EQ_EPS(q.conjugate().transformPoint(q.transformPoint(p)).distance(p), 0, eps);
+	auto const s = q * 2.;
+	auto const ss = s * s.inverse();
+	TEST_EQ_EPS(ss.real.distance(quatd(0, 0, 0, 1)), 0, eps);
+	TEST_EQ_EPS(ss.dual.length(), 0, eps);
+	auto const n = normalize(s);
+	TEST_EQ_EPS(n.real.distance(q.real), 0, eps);
+	TEST_EQ_EPS(n.dual.distance(q.dual), 0, eps);
+
+	// sclerp: ends, shortest path, and a screw motion about z at constant speed
+	TEST_EQ_EPS(sclerp(q, b, 0.).transformPoint(p).distance(q.transformPoint(p)), 0, eps);
+	TEST_EQ_EPS(sclerp(q, b, 1.).transformPoint(p).distance(b.transformPoint(p)), 0, eps);
+	TEST_EQ_EPS(sclerp(q, -b, 1.).transformPoint(p).distance(b.transformPoint(p)), 0, eps);
+	auto const rz = [](double angle) { return quatd(0, 0, 1, angle).fromAngleAxis(); };
+	auto const screw = DQ::fromRotationTranslation(rz(M_PI / 2), double3(0, 0, 4));
+	auto const half = sclerp(DQ::identity(), screw, .5);
+	TEST_EQ_EPS(half.real.distance(rz(M_PI / 4)), 0, eps);
+	TEST_EQ_EPS(half.translation().distance(double3(0, 0, 2)), 0, eps);
+	// off-axis: the screw about a z axis through (1, 0, 0)
+	auto const shift = DQ::fromTranslation(double3(1, 0, 0));
+	auto const offAxis = shift * screw * shift.conjugate();
+	auto const offHalf = sclerp(DQ::identity(), offAxis, .5);
+	TEST_EQ_EPS(offHalf.transformPoint(double3(1, 0, 0)).distance(double3(1, 0, 2)), 0, eps);
+	// pure translation
+	TEST_EQ_EPS(sclerp(DQ::identity(), DQ::fromTranslation(t), .25).translation().distance(t * .25), 0, eps);
+
+	// blend
+	{
+		std::vector<DQ> qs = {q, -q};
+		std::vector<double> w = {.3, .7};
+		auto const bl = blend(std::span<DQ const>(qs), std::span<double const>(w));
+		TEST_EQ_EPS(bl.transformPoint(p).distance(q.transformPoint(p)), 0, eps);
+		// equal weights about one axis is the halfway screw
+		std::vector<DQ> ends = {DQ::identity(), screw};
+		std::vector<double> halves = {.5, .5};
+		auto const mid = blend(std::span<DQ const>(ends), std::span<double const>(halves));
+		TEST_EQ_EPS(mid.real.distance(rz(M_PI / 4)), 0, eps);
+		TEST_EQ_EPS(mid.translation().distance(double3(0, 0, 2)), 0, eps);
+	}
+
+	// batched
+	{
+		int const count = 37;
+		std::vector<double3> src(count), dst(count);
+		std::vector<DQ> each(count);
+		for (int i = 0; i < count; ++i) {
+			src[i] = double3(i, 1 - i, .5 * i);
+			each[i] = DQ::fromRotationTranslation(normalize(quatd(1, i, -2, .1 * i)), double3(i, 0, -i));
+		}
+		transform(q, std::span<double3 const>(src), std::span<double3>(dst));
+		for (int i = 0; i < count; ++i) {
+			TEST_EQ_EPS(dst[i].distance(q.transformPoint(src[i])), 0, eps);
+		}
+		transform(std::span<DQ const>(each), std::span<double3 const>(src), std::span<double3>(dst));
+		for (int i = 0; i < count; ++i) {
+			TEST_EQ_EPS(dst[i].distance(each[i].transformPoint(src[i])), 0, eps);
+		}
+
+		// skinning: each vertex blends 3 of the bones
+		int const influences = 3;
+		std::vector<int> indices(count * influences);
+		std::vector<double> weights(count * influences);
+		for (int i = 0; i < count; ++i) {
+			for (int j = 0; j < influences; ++j) {
+				indices[i * influences + j] = (i * 7 + j * 5) % count;
+				// one negative weight, which keeps its sign whatever the bone's sign
+				weights[i * influences + j] = j == 0 ? .75 : (j == 1 ? .5 : -.25);
+			}
+		}
+		// a bone's sign shouldn't matter
+		each[3] = -each[3];
+		std::vector<DQ> skin(count);
+		blend(std::span<DQ const>(each), std::span<int const>(indices), std::span<double const>(weights), influences, std::span<DQ>(skin));
+		for (int i = 0; i < count; ++i) {
+			std::vector<DQ> bs;
+			for (int j = 0; j < influences; ++j) bs.push_back(each[indices[i * influences + j]]);
+			auto const expected = blend(std::span<DQ const>(bs), std::span<double const>(weights.data() + i * influences, influences));
+			TEST_EQ_EPS(skin[i].real.distance(expected.real), 0, eps);
+			TEST_EQ_EPS(skin[i].dual.distance(expected.dual), 0, eps);
+		}
+		// in place
+		transform(std::span<DQ const>(skin), std::span<double3 const>(src), std::span<double3>(src));
+		TEST_EQ_EPS(src[5].distance(skin[5].transformPoint(double3(5, -4, 2.5))), 0, eps);
+
+		bool threw = false;
+		indices[0] = count;
+		try {
+			blend(std::span<DQ const>(each), std::span<int const>(indices), std::span<double const>(weights), influences, std::span<DQ>(skin));
+		} catch (Common::Exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+}
@@ -0,0 +1,114 @@
+#include "Test/Test.h"
+#include "Tensor/Eigen.h"
+
+namespace {
+	// |a V - V diag(values)| and |V^T V - I|
+	template<typename T, int N>
+	void checkEigen(Tensor::sym<T,N> const & a, Tensor::EigenSym<T,N> const & e, T eps) {
+		T scale = 0;
+		for (int i = 0; i < N; ++i) {
+			for (int j = 0; j < N; ++j) {
+				scale = std::max<T>(scale, std::abs(a(i,j)));
+			}
+		}
+		for (int k = 0; k < N; ++k) {
+			if (k > 0) TEST_BOOL(e.values[k - 1] <= e.values[k]);
+			for (int i = 0; i < N; ++i) {
+				T av = 0;
+				for (int j = 0; j < N; ++j) av += a(i,j) * e.vectors(j,k);
+				TEST_EQ_EPS(av, e.values[k] * e.vectors(i,k), eps * std::max<T>(scale, 1));
+			}
+			for (int l = 0; l < N; ++l) {
+				T dot = 0;
+				for (int i = 0; i < N; ++i) dot += e.vectors(i,k) * e.vectors(i,l);
+				TEST_EQ_EPS(dot, k == l ? 1 : 0, eps);
+			}
+		}
+	}
+}
+
+void test_Eigen() {
+	using namespace Tensor;
+	double const eps = 1e-12;
+
+	// closed form sym3, including repeated values and scales far from 1
+	{
+		std::vector<double3s3> cases;
+		auto const make = [](double a00, double a01, double a02, double a11, double a12, double a22) {
+			double3s3 m;
+			m(0,0) = a00; m(0,1) = a01; m(0,2) = a02;
+			m(1,1) = a11; m(1,2) = a12; m(2,2) = a22;
+			return m;
+		};
+		cases.push_back(make(2, -1, 0, 2, -1, 2));
+		cases.push_back(make(1, .5, .25, 3, -.7, -2));
+		cases.push_back(make(4, 0, 0, 4, 0, 4));		// all equal
+		cases.push_back(make(1, 0, 0, 1, 0, 5));		// double, smallest
+		cases.push_back(make(3, 1, 1, 3, 1, 3));		// double, 2 2 5
+		cases.push_back(make(1e-3, 2e-4, 0, 5e-4, 1e-4, 7e-4));
+		cases.push_back(make(1e8, 3e7, -2e7, 5e7, 1e7, 2e8));
+		cases.push_back(make(0, 0, 0, 0, 0, 0));
+		for (auto const & a : cases) {
+			auto const e = eigen(a);
+			checkEigen(a, e, 1e-10);
+			// values alone are only good to about sqrt(epsilon) around the repeated ones
+			auto const values = eigenvalues(a);
+			TEST_EQ_EPS(values.distance(e.values), 0, 1e-7 * std::max(1., e.values.length()));
+			// matches Jacobi
+			auto const j = eigenJacobi(a);
+			TEST_EQ_EPS(j.values.distance(e.values), 0, 1e-10 * std::max(1., e.values.length()));
+		}
+		auto const e = eigen(cases[0]);
+		TEST_EQ_EPS(e.values[0], 2 - std::sqrt(2.), eps);
+		TEST_EQ_EPS(e.values[1], 2, eps);
+		TEST_EQ_EPS(e.values[2], 2 + std::sqrt(2.), eps);
+
+		// batched values match, including the all-equal and zero ones
+		std::vector<double3> values(cases.size());
+		eigenvalues(std::span<double3s3 const>(cases), std::span<double3>(values));
+		for (size_t i = 0; i < cases.size(); ++i) {
+			TEST_EQ_EPS(values[i].distance(eigenvalues(cases[i])), 0, 1e-7 * std::max(1., values[i].length()));
+		}
+		std::vector<EigenSym<double,3>> all(cases.size());
+		eigen(std::span<double3s3 const>(cases), std::span<EigenSym<double,3>>(all));
+		checkEigen(cases[1], all[1], 1e-10);
+	}
+
+	// Jacobi for other sizes, on floats too
+	{
+		sym<double,6> a;
+		for (int i = 0; i < 6; ++i) {
+			for (int j = i; j < 6; ++j) {
+				a(i,j) = std::sin(1. + 3 * i + 7 * j);
+			}
+		}
+		auto const e = eigen(a);
+		checkEigen(a, e, 1e-12);
+		TEST_EQ_EPS(eigenvalues(a).distance(e.values), 0, eps);
+		double trace = 0;
+		for (int i = 0; i < 6; ++i) trace += a(i,i);
+		TEST_EQ_EPS(e.values.sum(), trace, eps);
+
+		sym<float,2> f;
+		f(0,0) = 1;
+		f(0,1) = 2;
+		f(1,1) = 1;
+		auto const ef = eigen(f);
+		checkEigen(f, ef, 1e-6f);
+		TEST_EQ_EPS(ef.values[0], -1, 1e-6f);
+		TEST_EQ_EPS(ef.values[1], 3, 1e-6f);
+
+		std::vector<sym<double,6>> many(5, a);
+		std::vector<vec<double,6>> values(5);
+		eigenvalues(std::span<sym<double,6> const>(many), std::span<vec<double,6>>(values));
+		TEST_EQ_EPS(values[4].distance(e.values), 0, eps);
+
+		bool threw = false;
+		try {
+			eigenvalues(std::span<sym<double,6> const>(many), std::span<vec<double,6>>(values.data(), 4));
+		} catch (Common::Exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+}
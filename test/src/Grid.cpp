@@ -0,0 +1,243 @@
+#include "Test/Test.h"
+#include "Tensor/Grid.h"
+
+void test_Grid() {
+	using namespace Tensor;
+
+	// ctor from a callback, and range() order
+	auto g = Grid<float, 2>(int2(4, 3), [](int2 i) -> float { return i.x + 10 * i.y; });
+	TEST_EQ(g.size, int2(4, 3));
+	TEST_EQ(g.step, int2(1, 4));
+	TEST_EQ(g(2, 1), 12);
+	TEST_EQ(g(int2(3, 2)), 23);
+
+	// linear-index ctor, called in memory order
+	{
+		int next = 0;
+		auto gl = Grid<float, 2>(int2(4, 3), [&](int k) -> float {
+			TEST_EQ(k, next);
+			++next;
+			return k;
+		});
+		for (auto i : gl.range()) {
+			TEST_EQ(gl(i), i.dot(gl.step));
+		}
+	}
+
+	// the intN-index ctor also goes in memory order
+	{
+		int next = 0;
+		auto gi = Grid<int3, 3>(int3(2, 3, 4), [&](int3 i) -> int3 {
+			TEST_EQ(i.dot(stepForSize(int3(2, 3, 4))), next);
+			++next;
+			return i;
+		});
+		TEST_EQ(next, 2 * 3 * 4);
+		for (auto i : gi.range()) {
+			TEST_EQ(gi(i), i);
+		}
+	}
+
+	// map
+	{
+		auto gd = g.map([](float x) { return 2. * x; });
+		static_assert(std::is_same_v<decltype(gd), Grid<double, 2>>);
+		auto gf = g.map<float>(std::function<float(float)>([](float x) -> float { return x + 1; }));
+		static_assert(std::is_same_v<decltype(gf), Grid<float, 2>>);
+		for (auto i : g.range()) {
+			TEST_EQ(gd(i), 2. * g(i));
+			TEST_EQ(gf(i), g(i) + 1);
+		}
+	}
+
+	// cursorRange visits the same cells in the same order as range(), and keeps its offset in sync
+	{
+		auto r = g.range();
+		auto ri = r.begin();
+		int n = 0;
+		for (auto const & c : g.cursorRange()) {
+			TEST_EQ(c.index, *ri);
+			TEST_EQ(c.offset, c.index.dot(g.step));
+			TEST_EQ(&*c, &g(c.index));
+			TEST_EQ(*c, g(c.index));
+			++ri;
+			++n;
+		}
+		TEST_EQ(n, g.size.product());
+		TEST_BOOL(ri == r.end());
+	}
+
+	// neighbors
+	for (auto const & c : g.cursorRange()) {
+		if (c.index.x < g.size.x-1) TEST_EQ((c.neighbor<0,1>()), g(c.index + int2(1,0)));
+		if (c.index.y > 0) TEST_EQ((c.neighbor<1,-1>()), g(c.index - int2(0,1)));
+		TEST_EQ(c.neighbor(int2(0,0)), *c);
+	}
+
+	// writing through a cursor
+	{
+		auto h = g;
+		for (auto const & c : h.cursorRange()) {
+			*c *= 2;
+		}
+		for (auto i : g.range()) {
+			TEST_EQ(h(i), 2 * g(i));
+		}
+	}
+
+	// interior range
+	{
+		auto g3 = Grid<float, 3>(int3(5, 6, 7), [](int3 i) -> float { return i.x + 10 * i.y + 100 * i.z; });
+		int n = 0;
+		for (auto const & c : g3.interiorRange<2>()) {
+			for (int k = 0; k < 3; ++k) {
+				TEST_BOOL(c.index[k] >= 2 && c.index[k] < g3.size[k] - 2);
+			}
+			TEST_EQ(*c, g3(c.index));
+			TEST_EQ((c.neighbor<2,-2>()), g3(c.index - int3(0,0,2)));
+			TEST_EQ((c.neighbor<1,2>()), g3(c.index + int3(0,2,0)));
+			++n;
+		}
+		TEST_EQ(n, 1 * 2 * 3);
+
+		// const grids give const cursors
+		auto const & cg3 = g3;
+		for (auto const & c : cg3.interiorRange<1>()) {
+			static_assert(std::is_same_v<decltype(*c), float const &>);
+			TEST_EQ((c.neighbor<0,1>()) - (c.neighbor<0,-1>()), 2);
+		}
+
+		// border bigger than the grid means an empty range
+		n = 0;
+		for ([[maybe_unused]] auto const & c : g3.interiorRange<3>()) ++n;
+		TEST_EQ(n, 0);
+	}
+
+	// views
+	{
+		auto g3 = Grid<float3, 3>(int3(4, 5, 6), [](int3 i) -> float3 { return float3(i); });
+
+		auto v = g3.view();
+		static_assert(std::is_same_v<decltype(v), GridView<float3, 3>>);
+		TEST_EQ(v(1, 2, 3), float3(1, 2, 3));
+		v(1, 2, 3) = float3(7, 8, 9);
+		TEST_EQ(g3(1, 2, 3), float3(7, 8, 9));
+		g3(1, 2, 3) = float3(1, 2, 3);
+
+		auto const & cg3 = g3;
+		auto cv = cg3.view();
+		static_assert(std::is_same_v<decltype(cv), GridView<float3 const, 3>>);
+		GridView<float3 const, 3> cv2 = v;
+		TEST_EQ(&cv2(0, 0, 0), &cv(0, 0, 0));
+
+		// slice
+		auto s = v.slice(int3(1, 1, 2), int3(3, 4, 6));
+		TEST_EQ(s.size, int3(2, 3, 4));
+		for (auto i : s.range()) {
+			TEST_EQ(s(i), float3(i + int3(1, 1, 2)));
+		}
+
+		// fix axis
+		auto plane = v.fixAxis<1>(3);
+		static_assert(std::is_same_v<decltype(plane), GridView<float3, 2>>);
+		TEST_EQ(plane.size, int2(4, 6));
+		for (auto i : plane.range()) {
+			TEST_EQ(plane(i), float3(i.x, 3, i.y));
+		}
+
+		// transpose
+		auto t = v.transpose<0, 2>();
+		TEST_EQ(t.size, int3(6, 5, 4));
+		for (auto i : t.range()) {
+			TEST_EQ(t(i), float3(i.z, i.y, i.x));
+		}
+
+		// components
+		auto y = v.component(1);
+		static_assert(std::is_same_v<decltype(y), GridView<float, 3>>);
+		auto z = cv.component(intN<1>(2));
+		static_assert(std::is_same_v<decltype(z), GridView<float const, 3>>);
+		for (auto i : v.range()) {
+			TEST_EQ(y(i), (float)i.y);
+			TEST_EQ(z(i), (float)i.z);
+		}
+
+		// all of them at once, and copying back out to a Grid
+		auto yz = v.transpose<0, 2>().fixAxis<2>(1).slice(int2(1, 1), int2(5, 4)).component(1);
+		TEST_EQ(yz.size, int2(4, 3));
+		auto yzCopy = yz.copy();
+		static_assert(std::is_same_v<decltype(yzCopy), Grid<float, 2>>);
+		for (auto i : yz.range()) {
+			TEST_EQ(yzCopy(i), (float)(i.y + 1));
+		}
+
+		// components of nested tensors
+		auto gm = Grid<float2x2, 1>(intN<1>(3), [](int k) -> float2x2 { float x = k; return float2x2{{x, 2*x}, {3*x, 4*x}}; });
+		auto row1 = gm.view().component(1);
+		static_assert(std::is_same_v<decltype(row1), GridView<float2, 1>>);
+		TEST_EQ(row1(2), float2(6, 8));
+		TEST_EQ(row1.component(0)(2), 6);
+		TEST_EQ(gm.view().component(int2(0, 1))(2), 4);
+
+		auto gs = Grid<float3s3, 1>(intN<1>(2), [](int k) -> float3s3 { return float3s3(k, 2*k, 3*k, 4*k, 5*k, 6*k); });
+		TEST_EQ(gs.view().component(int2(2, 0))(1), gs(1)(2, 0));
+		TEST_EQ(gs.view().component(int2(0, 2))(1), gs(1)(2, 0));
+
+		// cursors over views
+		for (auto const & c : plane.interiorRange<1>()) {
+			TEST_EQ((c.neighbor<0, 1>()), plane(c.index + int2(1, 0)));
+			TEST_EQ((c.neighbor<1, -1>()), plane(c.index - int2(0, 1)));
+		}
+	}
+
+	// resize
+	{
+		// any axis: the overlap stays, the rest is zero.  big enough to be copied in parallel slabs
+		auto const f = [](int3 i) -> int { return i.dot(int3(1, 1000, 1000000)) + 1; };
+		auto g = Grid<int, 3>(int3(90, 80, 70), f);
+		g.resize(int3(100, 60, 75));
+		TEST_EQ(g.step, int3(1, 100, 6000));
+		bool ok = true;
+		for (auto i : g.range()) {
+			ok = ok && g(i) == (i.x < 90 && i.z < 70 ? f(i) : 0);
+		}
+		TEST_BOOL(ok);
+
+		// only the slowest axis: in place, keeping the capacity when shrinking
+		int * const p = g.v;
+		g.resize(int3(100, 60, 20));
+		TEST_EQ(g.v, p);
+		TEST_EQ(g.capacity, 100 * 60 * 75);
+		g.resize(int3(100, 60, 50));
+		TEST_EQ(g.v, p);
+		TEST_EQ(g(99, 59, 19), 0);
+		TEST_EQ(g(89, 59, 19), f(int3(89, 59, 19)));
+		TEST_EQ(g(5, 5, 49), 0);
+		g.resize(int3(100, 60, 80));	// past the capacity, so it moves
+		TEST_EQ(g.capacity, 100 * 60 * 80);
+		TEST_EQ(g(89, 59, 19), f(int3(89, 59, 19)));
+		TEST_EQ(g(5, 5, 79), 0);
+
+		// reserve ahead of appending layers
+		auto h = Grid<float, 2>(int2(4, 0));
+		h.reserve(4 * 10);
+		float * const q = h.v;
+		for (int k = 0; k < 10; ++k) {
+			h.resize(int2(4, k + 1));
+			h(3, k) = (float)k;
+		}
+		TEST_EQ(h.v, q);
+		TEST_EQ(h(3, 7), 7.f);
+
+		// non-trivial cells
+		auto s = Grid<std::string, 2>(int2(2, 2), [](int2 i) -> std::string { return std::to_string(i.x + 2 * i.y); });
+		s.resize(int2(3, 1));
+		TEST_EQ(s(1, 0), "1");
+		TEST_EQ(s(2, 0), "");
+		s.resize(int2(3, 4));
+		TEST_EQ(s(0, 0), "0");
+		TEST_EQ(s(2, 3), "");
+		auto s2 = s;
+		TEST_EQ(s2(1, 0), "1");
+	}
+}
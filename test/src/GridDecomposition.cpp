@@ -0,0 +1,103 @@
+#include "Test/Test.h"
+#include "Tensor/GridDecomposition.h"
+#include <thread>
+
+void test_GridDecomposition() {
+	using namespace Tensor;
+
+	TEST_EQ(DomainDecomposition<3>::chooseParts(int3(64, 64, 64), 8), int3(2, 2, 2));
+	TEST_EQ(DomainDecomposition<2>::chooseParts(int2(100, 10), 4), int2(4, 1));
+	TEST_EQ(DomainDecomposition<2>::chooseParts(int2(3, 100), 5), int2(1, 5));
+
+	// blocks tile the domain
+	{
+		auto d = DomainDecomposition<2>(int2(17, 13), int2(3, 2), int2(1, 1));
+		TEST_EQ(d.count(), 6);
+		int cells = 0;
+		for (int id = 0; id < d.count(); ++id) {
+			TEST_EQ(d.idOf(d.blockOf(id)), id);
+			cells += d.blockSize(id).product();
+		}
+		TEST_EQ(cells, 17 * 13);
+		TEST_EQ(d.blockMax(d.idOf(int2(2, 1))), int2(17, 13));
+		TEST_EQ(d.neighbor(0, 0, 0), -1);
+		TEST_EQ(d.neighbor(0, 0, 1), 1);
+		TEST_EQ(d.neighbor(0, 1, 1), 3);
+	}
+
+	/*
+	periodic along x, constant -1 along y
+	after an exchange every ghost cell should match what a single grid of the whole domain would have
+	*/
+	auto const size = int2(17, 13);
+	auto whole = Grid<int2, 2>(size, [](int2 i) -> int2 { return i; });
+	auto expected = [&](int2 i) -> int2 {
+		if (i.y < 0 || i.y >= size.y) return int2(-1, -1);
+		return int2((i.x + size.x) % size.x, i.y);
+	};
+	auto check = [&](Subdomain<int2, 2> const & s) -> bool {
+		auto const & g = s.grid;
+		bool same = true;
+		for (auto i : RangeObj<2>(-g.ghost, g.size + g.ghost)) {
+			same = same && g(i) == expected(i + s.min);
+		}
+		return same;
+	};
+	auto d = DomainDecomposition<2>(size, 6, int2(2, 3), {true, false});
+	GhostBoundary<int2> const edge = {GhostFill::Constant, int2(-1, -1)};
+
+	// one thread per block
+	{
+		SharedMemoryHaloTransport transport;
+		std::vector<Subdomain<int2, 2>> subs(d.count());
+		std::vector<std::thread> threads;
+		for (int id = 0; id < d.count(); ++id) {
+			threads.emplace_back([&, id]() {
+				subs[id] = d.subdomain<int2>(id, edge);
+				subs[id].scatterFrom(whole);
+				exchangeHalos(d, subs[id], transport);
+				// and a second time, to see the mailboxes keep messages in order
+				exchangeHalos(d, subs[id], transport);
+			});
+		}
+		for (auto & t : threads) t.join();
+		for (auto const & s : subs) TEST_BOOL(check(s));
+
+		auto back = Grid<int2, 2>(size);
+		for (auto const & s : subs) s.gatherInto(back);
+		bool same = true;
+		for (auto i : whole.range()) same = same && back(i) == whole(i);
+		TEST_BOOL(same);
+	}
+
+	// all blocks in one call, e.g. one process owning them all
+	{
+		SharedMemoryHaloTransport transport;
+		std::vector<Subdomain<int2, 2>> subs;
+		for (int id = 0; id < d.count(); ++id) {
+			subs.push_back(d.subdomain<int2>(id, edge));
+			subs.back().scatterFrom(whole);
+		}
+		exchangeHalos(d, std::span(subs), transport);
+		for (auto const & s : subs) TEST_BOOL(check(s));
+	}
+
+	// a single periodic block exchanges with itself
+	{
+		auto one = DomainDecomposition<2>(size, 1, int2(1, 1), {true, true});
+		SharedMemoryHaloTransport transport;
+		auto s = one.subdomain<int2>(0);
+		s.scatterFrom(whole);
+		exchangeHalos(one, s, transport);
+		TEST_EQ(s.grid(-1, -1), int2(16, 12));
+		TEST_EQ(s.grid(17, 5), int2(0, 5));
+	}
+
+	bool threw = false;
+	try {
+		DomainDecomposition<2>(size, int2(9, 1), int2(2, 0));	// blocks of 1 or 2 can't fill 2 ghost layers
+	} catch (std::exception const &) {
+		threw = true;
+	}
+	TEST_BOOL(threw);
+}
@@ -0,0 +1,100 @@
+#include "Test/Test.h"
+#include "Tensor/GridGhost.h"
+
+void test_GridGhost() {
+	using namespace Tensor;
+
+	// each policy, in 1D
+	{
+		auto g = GhostGrid<double, 1>(intN<1>(4), intN<1>(3));
+		for (int i = 0; i < 4; ++i) g(i) = 10 + i;	// 10 11 12 13
+
+		g.fillGhosts();	// periodic by default
+		TEST_EQ(g(-1), 13.);
+		TEST_EQ(g(-3), 11.);
+		TEST_EQ(g(4), 10.);
+		TEST_EQ(g(6), 12.);
+
+		g.setBoundary(0, {GhostFill::Reflect});
+		g.fillGhosts();
+		TEST_EQ(g(-1), 10.);
+		TEST_EQ(g(-3), 12.);
+		TEST_EQ(g(4), 13.);
+		TEST_EQ(g(6), 11.);
+
+		g.setBoundary(0, {GhostFill::Extrapolate});
+		g.fillGhosts();
+		TEST_EQ(g(-1), 9.);
+		TEST_EQ(g(-3), 7.);
+		TEST_EQ(g(6), 16.);
+
+		g.setBoundary(0, 0, {GhostFill::Constant, -1.});
+		g.setBoundary(0, 1, {GhostFill::Constant, 2.});
+		g.fillGhosts();
+		TEST_EQ(g(-2), -1.);
+		TEST_EQ(g(5), 2.);
+		TEST_EQ(g(0), 10.);
+	}
+
+	// wider ghosts than the interior still wrap and mirror
+	{
+		auto g = GhostGrid<int, 1>(intN<1>(2), intN<1>(5));
+		g(0) = 1;
+		g(1) = 2;
+		g.fillGhosts();
+		TEST_EQ(g(-5), 2);
+		TEST_EQ(g(6), 1);
+		g.setBoundary(0, {GhostFill::Reflect});
+		g.fillGhosts();
+		TEST_EQ(g(-3), 2);	// -1 -> 0, -2 -> 1, -3 -> 1, -4 -> 0 ...
+		TEST_EQ(g(-4), 1);
+		TEST_EQ(g(6), 2);
+	}
+
+	// corners and edges in 3D: periodic everywhere is the same as wrapping the index
+	{
+		auto const size = int3(5, 4, 3);
+		auto g = GhostGrid<float3, 3>(size, int3(2, 1, 2));
+		for (auto i : g.range()) g(i) = float3(i);
+		g.fillGhosts();
+		bool same = true;
+		for (auto i : RangeObj<3>(-g.ghost, size + g.ghost)) {
+			int3 w;
+			for (int j = 0; j < 3; ++j) w[j] = (i[j] + size[j]) % size[j];
+			same = same && g(i) == float3(w);
+		}
+		TEST_BOOL(same);
+
+		// extrapolating a linear field reproduces it, corners included
+		g.setBoundary(0, {GhostFill::Extrapolate});
+		g.setBoundary(1, {GhostFill::Extrapolate});
+		g.setBoundary(2, {GhostFill::Extrapolate});
+		g.fillGhosts();
+		same = true;
+		for (auto i : RangeObj<3>(-g.ghost, size + g.ghost)) {
+			same = same && g(i) == float3(i);
+		}
+		TEST_BOOL(same);
+	}
+
+	// stencils over the interior don't need any edge handling
+	{
+		auto g = GhostGrid<double, 2>(int2(8, 6), int2(1, 1));
+		for (auto i : g.range()) g(i) = i.x * i.x + i.y;
+		g.setBoundary(0, {GhostFill::Extrapolate});
+		g.setBoundary(1, {GhostFill::Extrapolate});
+		g.fillGhosts();
+		double sum = 0;
+		for (auto const & c : g.interiorRange<1>()) {
+			sum += c.neighbor<1, 1>() - c.neighbor<1, -1>();	// 2 everywhere, since y is linear
+		}
+		TEST_EQ(sum, 2. * 8 * 6);
+		bool threw = false;
+		try {
+			g.interiorRange<2>();
+		} catch (std::exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+}
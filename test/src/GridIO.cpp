@@ -0,0 +1,156 @@
+#include "Test/Test.h"
+#include "Tensor/GridIO.h"
+#include "Tensor/MappedGrid.h"
+#include <filesystem>
+#include <sstream>
+
+void test_GridIO() {
+	using namespace Tensor;
+
+	TEST_EQ(crc32("123456789", 9), 0xCBF43926u);	// the standard check value
+	TEST_EQ(crc32("", 0), 0u);
+	TEST_EQ(crc32("56789", 5, crc32("1234", 4)), 0xCBF43926u);
+
+	auto size = int3(5, 4, 3);
+	auto g = Grid<float3s3, 3>(size, [](int3 i) -> float3s3 {
+		return float3s3(i.x, i.y, i.z, i.x * i.y, i.y * i.z, .5f * i.x);
+	});
+	auto headerBytes = [](int rank, std::string const & sig) -> size_t {
+		return sizeof(GridIOHeader) + 8 * rank + 4 + sig.size() + 4 + 8;
+	};
+
+	// round trip, with and without checksums, with chunks that don't line up with rows
+	for (bool checksums : {true, false}) {
+		for (size_t chunkBytes : {(size_t)1 << 20, sizeof(float3s3) * 7}) {
+			std::stringstream s;
+			writeGrid(s, g, {.checksums = checksums, .chunkBytes = chunkBytes});
+			size_t const chunks = checksums ? (size.product() * sizeof(float3s3) + chunkBytes - 1) / chunkBytes : 0;
+			TEST_EQ(s.str().size(), headerBytes(3, "f32 s 3") + size.product() * sizeof(float3s3) + 4 * chunks);
+
+			auto info = readGridInfo(s);
+			TEST_EQ(info.rank, 3);
+			TEST_EQ(info.signature, "f32 s 3");
+			TEST_EQ(info.checksums, checksums);
+			TEST_BOOL(!info.swapped);
+
+			s.seekg(0);
+			auto h = readGrid<float3s3, 3>(s);
+			TEST_EQ(h.size, size);
+			bool same = true;
+			for (auto i : g.range()) same = same && h(i) == g(i);
+			TEST_BOOL(same);
+		}
+	}
+
+	// only stored elements go to disk
+	{
+		std::stringstream s;
+		writeGrid(s, Grid<sym<float, 4>, 1>(intN<1>(10)), {.checksums = false});
+		TEST_EQ(s.str().size(), headerBytes(1, "f32 s 4") + 10 * 10 * sizeof(float));
+	}
+
+	// views are written in their own order, and read back into views
+	{
+		std::stringstream s;
+		auto t = g.view().transpose<0, 2>();
+		writeGrid(s, t);
+		auto h = readGrid<float3s3, 3>(s);
+		TEST_EQ(h.size, int3(3, 4, 5));
+		TEST_EQ(h(2, 1, 4), g(4, 1, 2));
+
+		s.str("");
+		s.clear();
+		writeGrid(s, h);
+		auto back = Grid<float3s3, 3>(size);
+		readGridInto(s, back.view().transpose<0, 2>());
+		bool same = true;
+		for (auto i : g.range()) same = same && back(i) == g(i);
+		TEST_BOOL(same);
+	}
+
+	// mismatches and corruption throw
+	{
+		auto throws = [](auto f) -> bool {
+			try {
+				f();
+			} catch (std::exception const &) {
+				return true;
+			}
+			return false;
+		};
+		std::stringstream s;
+		writeGrid(s, g);
+		std::string const good = s.str();
+		auto in = [](std::string const & str) { return std::stringstream(str); };
+
+		TEST_BOOL(!throws([&]() { auto i = in(good); readGrid<float3s3, 3>(i); }));
+		TEST_BOOL(throws([&]() { auto i = in(good); readGrid<float3s3, 2>(i); }));
+		TEST_BOOL(throws([&]() { auto i = in(good); readGrid<float3x3, 3>(i); }));
+		TEST_BOOL(throws([&]() { auto i = in(good); readGrid<vec<float, 6>, 3>(i); }));
+		TEST_BOOL(throws([&]() { auto i = in(good); auto h = Grid<float3s3, 3>(int3(5, 4, 2)); readGridInto(i, h); }));
+		TEST_BOOL(throws([&]() { auto i = in(good.substr(0, good.size() - 10)); readGrid<float3s3, 3>(i); }));
+		TEST_BOOL(throws([&]() { auto i = in("not a grid file at all, definitely not"); readGrid<float3s3, 3>(i); }));
+
+		std::string bad = good;
+		bad[bad.size() - 20] ^= 1;
+		TEST_BOOL(throws([&]() { auto i = in(bad); readGrid<float3s3, 3>(i); }));
+	}
+
+	// a file from the other endianness gets swapped on the way in
+	{
+		auto small = Grid<double, 2>(int2(3, 2), [](int2 i) -> double { return i.x + 10 * i.y + .25; });
+		std::stringstream s;
+		writeGrid(s, small);
+		std::string str = s.str();
+		auto swap = [&](size_t at, size_t n) { std::reverse(str.begin() + at, str.begin() + at + n); };
+		for (size_t at = 8; at < 32; at += 4) swap(at, 4);	// version .. cellBytes
+		swap(32, 8);	// chunkCells
+		swap(40, 8);
+		swap(48, 8);	// size
+		swap(56, 4);	// signature length
+		swap(63, 4);	// after "f64": codec
+		swap(67, 8);	// error bound
+		size_t const data = 75;
+		for (int k = 0; k < 6; ++k) swap(data + 8 * k, 8);
+		// the crc is of the bytes as they were written, and stored in the writer's order
+		uint32_t const c = crc32(str.data() + data, 48);
+		std::memcpy(str.data() + data + 48, &c, 4);
+		swap(data + 48, 4);
+
+		std::stringstream si(str);
+		auto info = readGridInfo(si);
+		TEST_BOOL(info.swapped);
+		TEST_EQ(info.size[0], 3);
+		si.seekg(0);
+		auto h = readGrid<double, 2>(si);
+		TEST_EQ(h(2, 1), 12.25);
+		TEST_EQ(h(0, 0), .25);
+	}
+
+	// tensors, and reading straight into a MappedGrid
+	{
+		std::stringstream s;
+		auto x = float3x3{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+		writeTensor(s, x);
+		writeTensor(s, 3.5);
+		TEST_EQ(readTensor<float3x3>(s), x);
+		TEST_EQ(readTensor<double>(s), 3.5);
+
+		auto dir = std::filesystem::temp_directory_path();
+		auto gridPath = (dir / "Tensor_test_GridIO.tgrid").string();
+		auto mapPath = (dir / "Tensor_test_GridIO.grid").string();
+		writeGrid(gridPath, g);
+		{
+			auto m = MappedGrid<float3s3, 3>::create(mapPath, size);
+			readGridInto(gridPath, m.grid());
+		}
+		{
+			auto m = MappedGrid<float3s3, 3>::open(mapPath);
+			TEST_EQ(m.cgrid()(4, 3, 2), g(4, 3, 2));
+		}
+		auto h = readGrid<float3s3, 3>(gridPath);
+		TEST_EQ(h(1, 2, 1), g(1, 2, 1));
+		std::filesystem::remove(gridPath);
+		std::filesystem::remove(mapPath);
+	}
+}
@@ -0,0 +1,84 @@
+#include "Test/Test.h"
+#include "Tensor/GridLayout.h"
+#include <set>
+
+void test_GridLayout() {
+	using namespace Tensor;
+
+	// Morton is bit interleaving, lowest axis first
+	{
+		auto l = MortonLayout<2>(int2(4, 4));
+		TEST_EQ(l.storageSize, 16);
+		TEST_EQ(l.offset(int2(1, 0)), 1);
+		TEST_EQ(l.offset(int2(0, 1)), 2);
+		TEST_EQ(l.offset(int2(3, 3)), 15);
+		TEST_EQ(l.offset(int2(2, 1)), 6);
+		TEST_EQ(l.decode(6), int2(2, 1));
+	}
+
+	// bricks
+	{
+		auto l = TiledLayout<3, 4>(int3(9, 5, 4));
+		TEST_EQ(l.tiles, int3(3, 2, 1));
+		TEST_EQ(l.storageSize, 6 * 64);
+		TEST_EQ(l.offset(int3(1, 1, 1)), 1 + 4 + 16);
+		TEST_EQ(l.offset(int3(4, 0, 0)), 64);
+		TEST_EQ(l.offset(int3(0, 4, 0)), 3 * 64);
+	}
+
+	/*
+	for every layout, and sizes that need padding:
+	offsets are unique and inside the storage, range() visits every index once in increasing offset order,
+	and a grid round trips through a lexicographic Grid
+	*/
+	auto check = [](auto layoutTag, int3 size) {
+		using Layout = typename decltype(layoutTag)::type;
+		auto g = LayoutGrid<int3, 3, Layout>(size, [](int3 i) -> int3 { return i; });
+		std::set<int> offsets;
+		bool ok = true;
+		for (auto i : RangeObj<3>(int3(), size)) {
+			int const o = g.layout.offset(i);
+			ok = ok && o >= 0 && o < g.layout.storageSize && g.layout.decode(o) == i;
+			offsets.insert(o);
+			ok = ok && g(i) == i;
+		}
+		TEST_BOOL(ok);
+		TEST_EQ((int)offsets.size(), size.product());
+
+		int count = 0, last = -1;
+		for (auto i : g.range()) {
+			int const o = g.layout.offset(i);
+			ok = ok && o > last;
+			last = o;
+			++count;
+		}
+		TEST_BOOL(ok);
+		TEST_EQ(count, size.product());
+
+		auto lex = g.copy();
+		TEST_EQ(lex(size - 1), size - 1);
+		auto h = LayoutGrid<int3, 3, Layout>(size);
+		h.assign(lex);
+		TEST_BOOL(h.cells == g.cells);
+
+		ThreadPool pool(4);
+		std::atomic<int> visited = 0;
+		h.parallelForEach([&](int3 const & i, int3 & x) { x = -i; ++visited; }, pool);
+		TEST_EQ(visited.load(), size.product());
+		TEST_EQ(h(size - 1), 1 - size);
+	};
+	for (auto size : {int3(8, 8, 8), int3(5, 17, 3), int3(1, 1, 33), int3(64, 40, 70)}) {
+		check(std::type_identity<MortonLayout<3>>(), size);
+		check(std::type_identity<TiledLayout<3, 8>>(), size);
+		check(std::type_identity<TiledLayout<3, 3>>(), size);
+		check(std::type_identity<LinearLayout<3>>(), size);
+	}
+
+	// empty is fine
+	{
+		auto g = LayoutGrid<float, 2>(int2(0, 5));
+		int count = 0;
+		for ([[maybe_unused]] auto i : g.range()) ++count;
+		TEST_EQ(count, 0);
+	}
+}
@@ -0,0 +1,93 @@
+#include "Test/Test.h"
+#include "Tensor/GridParallel.h"
+
+void test_GridParallel() {
+	using namespace Tensor;
+
+	ThreadPool pool1(1);
+	ThreadPool pool4(4);
+
+	// parallelFor covers every index exactly once, and passes exceptions back
+	{
+		std::vector<int> hits(1000);
+		pool4.parallelFor((int)hits.size(), [&](int i) { ++hits[i]; });
+		for (auto h : hits) TEST_EQ(h, 1);
+
+		bool caught = false;
+		try {
+			pool4.parallelFor(10, [](int i) { if (i == 7) throw Common::Exception() << "7"; });
+		} catch (std::exception const &) {
+			caught = true;
+		}
+		TEST_BOOL(caught);
+
+		// nested
+		std::atomic<int> count = {};
+		pool4.parallelFor(8, [&](int) {
+			pool4.parallelFor(8, [&](int) { ++count; });
+		});
+		TEST_EQ((int)count, 64);
+	}
+
+	// big enough to get several slabs
+	auto size = int3(64, 64, 40);
+	auto f = [](int3 i) -> float { return std::sin((float)i.x) + std::cos((float)(i.y * i.z)) * 1e-3f; };
+	auto g = Grid<float, 3>(size, f);
+	TEST_BOOL(gridSlabs(g).count > 1);
+
+	// forEach / fill / transform
+	{
+		auto h = g;
+		parallelForEach(h, [](float & x) { x *= 2; }, pool4);
+		for (auto i : g.range()) TEST_EQ(h(i), 2 * g(i));
+
+		parallelForEach(h, [](int3 const & i, float & x) { x = (float)i.dot(int3(1, 100, 10000)); }, pool4);
+		for (auto i : g.range()) TEST_EQ(h(i), (float)i.dot(int3(1, 100, 10000)));
+
+		parallelFill(h, 3.f, pool4);
+		for (auto x : h) TEST_EQ(x, 3.f);
+
+		parallelTransform(h, g, [](float x) { return x + 1; }, pool4);
+		for (auto i : g.range()) TEST_EQ(h(i), g(i) + 1);
+
+		auto hd = parallelMap(g, [](float x) { return (double)x * x; }, pool4);
+		static_assert(std::is_same_v<decltype(hd), Grid<double, 3>>);
+		for (auto i : g.range()) TEST_EQ(hd(i), (double)g(i) * g(i));
+	}
+
+	// reductions are bit-identical across thread counts
+	{
+		float sum1 = parallelSum(g, pool1);
+		float sum4 = parallelSum(g, pool4);
+		TEST_EQ(sum1, sum4);
+		double serialSum = {};
+		for (auto x : g) serialSum += x;
+		TEST_EQ_EPS(sum4, serialSum, 1e-2);
+
+		TEST_EQ(parallelNorm(g, pool1), parallelNorm(g, pool4));
+		TEST_EQ(parallelMin(g, pool4), *std::min_element(g.begin(), g.end()));
+		TEST_EQ(parallelMax(g, pool4), *std::max_element(g.begin(), g.end()));
+		TEST_EQ(parallelTransformReduce(g, 0, std::plus<>(), [](float) { return 1; }, pool4), g.size.product());
+	}
+
+	// tensor-valued
+	{
+		auto gv = Grid<float3, 2>(int2(100, 100), [](int2 i) -> float3 { return float3(i.x, i.y, 1); });
+		TEST_EQ(parallelSum(gv, pool4), float3(99 * 100 / 2 * 100, 99 * 100 / 2 * 100, 100 * 100));
+		TEST_EQ_EPS(parallelNorm(gv, pool4), std::sqrt(parallelTransformReduce(gv, 0.f, std::plus<>(), [](float3 x) { return x.lenSq(); }, pool1)), 1e-3);
+	}
+
+	// views
+	{
+		auto h = Grid<float, 3>(size);
+		auto sub = h.view().slice(int3(8, 8, 8), int3(40, 48, 32));
+		parallelFill(sub, 1.f, pool4);
+		TEST_EQ(parallelSum(h, pool4), (float)(32 * 40 * 24));
+		parallelFill(h.view().transpose<0, 2>().fixAxis<0>(0), 2.f, pool4);
+		TEST_EQ(h(5, 6, 0), 2);
+		parallelTransform(h.view().fixAxis<2>(1), g.view().fixAxis<2>(3), [](float x) { return -x; }, pool4);
+		TEST_EQ(h(5, 6, 1), -g(5, 6, 3));
+		TEST_EQ(parallelSum(h.view().fixAxis<2>(1), pool1), parallelSum(h.view().fixAxis<2>(1), pool4));
+		TEST_EQ(parallelMax(g.view().fixAxis<0>(3), pool4), parallelMax(g.view().fixAxis<0>(3).copy(), pool1));
+	}
+}
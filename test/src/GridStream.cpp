@@ -0,0 +1,94 @@
+#include "Test/Test.h"
+#include "Tensor/GridStream.h"
+#include "Tensor/MappedGrid.h"
+#include "Tensor/Derivative.h"
+#include <filesystem>
+
+void test_GridStream() {
+	using namespace Tensor;
+
+	ThreadPool pool4(4);
+	auto size = int3(9, 7, 23);
+	auto f = [](int3 i) -> double { return i.x * i.y + 2 * i.z * i.z - i.x * i.z; };
+	auto g = Grid<double, 3>(size, f);
+
+	// every layer is handed out exactly once, and the halo matches the source
+	for (bool prefetch : {true, false}) {
+		for (int depth : {1, 4, 23, 100}) {
+			std::vector<int> hits(size.z);
+			bool same = true;
+			streamGrid(g, depth, 2, [&](GridStreamSlab<double, 3> const & slab) {
+				int const dataBegin = std::max(0, slab.begin - 2);
+				int const dataEnd = std::min(size.z, slab.end + 2);
+				TEST_EQ(slab.dataBegin, dataBegin);
+				TEST_EQ(slab.dataBegin + slab.data.size.z, dataEnd);
+				for (int k = slab.begin; k < slab.end; ++k) ++hits[k];
+				for (auto i : slab.data.range()) {
+					same = same && slab.data(i) == g(slab.toSource(i));
+				}
+			}, prefetch);
+			for (auto h : hits) TEST_EQ(h, 1);
+			TEST_BOOL(same);
+		}
+	}
+
+	// streamed stencil matches the in-memory one, for any depth
+	{
+		auto dx = double3(1, 1, 1);
+		auto expected = Grid<double3, 3>(size);
+		for (auto const & c : g.interiorRange<1>()) {
+			expected(c.index) = partialDerivativeGrid<2>(c, dx);
+		}
+		for (int depth : {1, 3, 100}) {
+			auto result = Grid<double3, 3>(size);
+			streamStencil<1>(result, g, depth, [&](auto const & c) { return partialDerivativeGrid<2>(c, dx); }, pool4);
+			for (auto i : g.range()) TEST_EQ(result(i), expected(i));
+		}
+
+		// the (cursor, index) form sees source coordinates
+		auto where = Grid<int3, 3>(size);
+		streamStencil<1>(where, g, 5, [](auto const &, int3 const & i) { return i; }, pool4);
+		TEST_EQ(where(4, 3, 21), int3(4, 3, 21));
+		TEST_EQ(where(0, 3, 21), int3());	// border cells aren't touched
+
+		auto wrongSize = Grid<double3, 3>(int3(1, 1, 1));
+		bool threw = false;
+		try {
+			streamStencil<1>(wrongSize, g, 5, [&](auto const & c) { return partialDerivativeGrid<2>(c, dx); }, pool4);
+		} catch (std::exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+
+	// reductions, straight off a MappedGrid
+	{
+		std::string const path = (std::filesystem::temp_directory_path() / "Tensor_test_GridStream.grid").string();
+		{
+			auto m = MappedGrid<double, 3>::create(path, size);
+			for (auto i : g.range()) m.grid()(i) = g(i);
+		}
+		{
+			auto m = MappedGrid<double, 3>::open(path);
+			double const sum = parallelSum(g, pool4);	// all integers, so the order doesn't matter
+			TEST_EQ(streamSum(m, 4, pool4), sum);
+			TEST_EQ(streamSum(m, 4, pool4, false), sum);
+			TEST_EQ(gridStreamDepth(m, 2 * 9 * 7 * 8 * 10, 1), 8);
+			TEST_EQ(gridStreamDepth(m, 1, 1), 1);
+			TEST_EQ(gridStreamDepth(m, 1 << 30), 23);
+
+			double const max = streamTransformReduce(m, 5, -1e+30, [](double a, double b) { return std::max(a, b); }, [](double x) { return x; }, pool4);
+			TEST_EQ(max, parallelMax(g, pool4));
+
+			// exceptions come back out, after the prefetch is done
+			bool threw = false;
+			try {
+				streamGrid(m, 3, 0, [](auto const & slab) { if (slab.begin > 5) throw Common::Exception() << "stop"; });
+			} catch (std::exception const &) {
+				threw = true;
+			}
+			TEST_BOOL(threw);
+		}
+		std::filesystem::remove(path);
+	}
+}
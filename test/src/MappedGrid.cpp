@@ -0,0 +1,96 @@
+#include "Test/Test.h"
+#include "Tensor/MappedGrid.h"
+#include <filesystem>
+
+void test_MappedGrid() {
+	using namespace Tensor;
+
+	// signatures
+	{
+		TEST_EQ(storageSignature<float>(), "f32");
+		TEST_EQ(storageSignature<int>(), "i32");
+		TEST_EQ(storageSignature<float3>(), "f32 3");
+		TEST_EQ(storageSignature<double3s3>(), "f64 s 3");
+		TEST_EQ((storageSignature<vec<sym<double, 3>, 4>>()), "f64 4, s 3");
+		TEST_EQ((storageSignature<asym<float, 4>>()), "f32 a 4");
+		TEST_NE(storageSignature<float3x3>(), storageSignature<float3s3>());
+		TEST_EQ(storedScalarCount<float3s3>(), 6);
+		TEST_EQ(storedScalarCount<float3x3>(), 9);
+	}
+
+	std::string const path = (std::filesystem::temp_directory_path() / "Tensor_test_MappedGrid.grid").string();
+
+	// write through a read-write mapping, read back through a read-only one
+	{
+		{
+			auto m = MappedGrid<float3s3, 3>::create(path, int3(5, 6, 7));
+			TEST_BOOL(m.isWritable());
+			// a view, so it can't be resized away from the file
+			static_assert(std::is_same_v<decltype(m.grid()), GridView<float3s3, 3>>);
+			TEST_EQ(m.grid().size, int3(5, 6, 7));
+			TEST_EQ(m.grid()(4, 5, 6), float3s3());	// fresh files are zeroes
+			for (auto i : m.grid().range()) {
+				m.grid()(i) = float3s3(i.x, i.y, i.z, i.x + i.y, i.y + i.z, i.x + i.z);
+			}
+			m.sync();
+		}
+		{
+			auto m = MappedGrid<float3s3, 3>::open(path);
+			TEST_BOOL(!m.isWritable());
+			TEST_EQ(m.cgrid().size, int3(5, 6, 7));
+			m.advise(MappedGrid<float3s3, 3>::Advice::Sequential);
+			m.advise(MappedGrid<float3s3, 3>::Advice::WillNeed, 2, 4);
+			bool same = true;
+			for (auto i : m.cgrid().range()) {
+				same = same && m.cgrid()(i) == float3s3(i.x, i.y, i.z, i.x + i.y, i.y + i.z, i.x + i.z);
+			}
+			TEST_BOOL(same);
+			TEST_EQ(m.view()(1, 2, 3), float3s3(1, 2, 3, 3, 5, 4));
+
+			bool threw = false;
+			try {
+				m.grid();
+			} catch (std::exception const &) {
+				threw = true;
+			}
+			TEST_BOOL(threw);
+
+			// moving hands the mapping over
+			auto m2 = std::move(m);
+			TEST_BOOL(!m.isOpen());
+			TEST_BOOL(m2.isOpen());
+			TEST_EQ(m2.cgrid()(4, 5, 6), float3s3(4, 5, 6, 9, 11, 10));
+		}
+		// read-write reopen
+		{
+			auto m = MappedGrid<float3s3, 3>::open(path, MappedGrid<float3s3, 3>::Mode::ReadWrite);
+			m.grid()(0, 0, 0) = float3s3(7, 7, 7, 7, 7, 7);
+		}
+		{
+			auto m = MappedGrid<float3s3, 3>::open(path);
+			TEST_EQ(m.cgrid()(0, 0, 0), float3s3(7, 7, 7, 7, 7, 7));
+		}
+	}
+
+	// the header has to match what we ask for
+	{
+		auto throws = [&](auto f) -> bool {
+			try {
+				f();
+			} catch (std::exception const &) {
+				return true;
+			}
+			return false;
+		};
+		TEST_BOOL(throws([&]() { MappedGrid<float3x3, 3>::open(path); }));	// same size as nothing, different signature
+		TEST_BOOL(throws([&]() { MappedGrid<float3s3, 2>::open(path); }));	// wrong rank
+		TEST_BOOL(throws([&]() { MappedGrid<double3s3, 3>::open(path); }));	// wrong element size
+		TEST_BOOL(throws([&]() { MappedGrid<vec<float, 6>, 3>::open(path); }));	// same bytes, different structure
+		TEST_BOOL(!throws([&]() { MappedGrid<float3s3, 3>::open(path); }));
+		std::filesystem::resize_file(path, 4096 + 10);
+		TEST_BOOL(throws([&]() { MappedGrid<float3s3, 3>::open(path); }));	// truncated
+		TEST_BOOL(throws([&]() { MappedGrid<float3s3, 3>::open(path + ".doesnt.exist"); }));
+	}
+
+	std::filesystem::remove(path);
+}
@@ -232,4 +232,30 @@ void test_Math() {
 		ECHO(c);
 	}
 #endif
+
+	// measure: the wedge product for m <= 3 rows, Householder past that, both = sqrt(det(A A^T))
+	{
+		auto const gram = [](auto const & a) {
+			return (double)sqrt(determinant(a * a.transpose()));
+		};
+		auto const a23 = double2x3{{1, 2, 3}, {-2, .5, 4}};
+		TEST_EQ_EPS(a23.measure(), gram(a23), 1e-12);
+		TEST_EQ_EPS(measureHouseholder(a23), gram(a23), 1e-12);
+		auto const a34 = mat<double,3,4>([](int i, int j) -> double { return std::sin(1. + 3 * i + j) + (i == j) + .5 * (i == j + 1); });
+		TEST_EQ_EPS(a34.measure(), gram(a34), 1e-12);
+		TEST_EQ_EPS(measureHouseholder(a34), a34.measure(), 1e-12);
+		auto const a46 = mat<double,4,6>([](int i, int j) -> double { return std::cos(2. + i - 2 * j) + (i == j); });
+		TEST_EQ_EPS(a46.measure(), gram(a46), 1e-12);
+		TEST_EQ_EPS(a46.measureSimplex(), gram(a46) / 24, 1e-12);
+		// square: |det|
+		auto const a55 = mat<double,5,5>([](int i, int j) -> double { return std::sin(1. + i * 5 + j * 3) + 2 * (i == j); });
+		TEST_EQ_EPS(a55.measure(), std::abs(determinant(a55)), 1e-12);
+		// dependent rows
+		auto b46 = a46;
+		b46[3] = b46[0] * 2. - b46[1];
+		TEST_EQ_EPS(b46.measure(), 0, 1e-12);
+		// more rows than dimensions
+		auto const a54 = mat<double,5,4>([](int i, int j) -> double { return i + j; });
+		TEST_EQ(a54.measure(), 0.);
+	}
 }
@@ -284,4 +284,118 @@ void test_Matrix() {
 
 	// operators
 	operatorScalarTest(m);
+
+	// batched transforms by the OpenGL matrices
+	{
+		using namespace Tensor;
+		double const eps = 1e-12;
+		auto const model = translate(double3(1, -2, 3)) * rotate(.7, double3(1, 2, -1).normalize()) * scale(double3(2, 1, .5));
+		auto const view = lookAt(double3(0, 0, 10), double3(0, 0, 0), double3(0, 1, 0));
+		auto const proj = perspective(1., 1.5, 1., 100.);
+		int const n = 37;
+		std::vector<double3> src(n), dst(n), viaMVP(n);
+		for (int i = 0; i < n; ++i) {
+			src[i] = double3(i - 18, .5 * i - 9, .25 * i);
+		}
+		auto const mvp = proj * view * model;
+		auto const perPoint = [](mat<double,4,4> const & m, double3 const & p) {
+			auto const c = m * double4(p.x, p.y, p.z, 1);
+			return double3(c.x, c.y, c.z) / c.w;
+		};
+
+		// affine, no divide
+		transformPoints(model, src, dst);
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(dst[i].distance(perPoint(model, src[i])), 0, eps);
+		}
+		// directions ignore the translation
+		transformVectors(model, src, dst);
+		for (int i = 0; i < n; ++i) {
+			auto const c = model * double4(src[i].x, src[i].y, src[i].z, 0);
+			TEST_EQ_EPS(dst[i].distance(double3(c.x, c.y, c.z)), 0, eps);
+		}
+		// projective, with the divide, and fused
+		transformPoints(mvp, src, dst);
+		transformPoints(proj, view, model, src, viaMVP);
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(dst[i].distance(perPoint(mvp, src[i])), 0, 1e-9);
+			TEST_EQ_EPS(dst[i].distance(viaMVP[i]), 0, 1e-9);
+		}
+
+		// clip flags
+		std::vector<double3> pts = {
+			double3(0, 0, 0),		// in view
+			double3(0, 0, 20),		// behind the eye
+			double3(0, 0, -200),	// past far
+			double3(50, 0, 0),		// right
+			double3(0, -50, 0),		// bottom
+		};
+		std::vector<double3> out(pts.size());
+		std::vector<uint8_t> flags(pts.size());
+		transformPoints(proj, view, translate(double3(0, 0, 0)), pts, out, flags);
+		TEST_EQ((int)flags[0], 0);
+		TEST_BOOL(flags[1] & clipNear);
+		TEST_EQ((int)flags[2], (int)clipFar);
+		TEST_EQ((int)flags[3], (int)clipRight);
+		TEST_EQ((int)flags[4], (int)clipBottom);
+		TEST_EQ_EPS(out[0].z, perPoint(proj * view, pts[0]).z, eps);
+
+		// in place
+		transformPoints(mvp, src, src);
+		TEST_EQ_EPS(src[5].distance(perPoint(mvp, double3(-13, -6.5, 1.25))), 0, 1e-9);
+
+		bool threw = false;
+		try {
+			transformPoints(mvp, src, std::span<double3>(dst.data(), n - 1));
+		} catch (Common::Exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+
+	// compact projection matrices match the dense ones
+	{
+		using namespace Tensor;
+		double const eps = 1e-12;
+		auto const near = [](mat<double,4,4> const & a, mat<double,4,4> const & b) {
+			double d = 0;
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					d = std::max(d, std::abs(a(i,j) - b(i,j)));
+				}
+			}
+			return d;
+		};
+		auto const I = translate(double3(0, 0, 0));
+		auto const modelView = lookAt(double3(1, 2, 10), double3(0, 0, 0), double3(0, 1, 0)) * rotate(.3, double3(0, 1, 0));
+		double3 const p = {.5, -.25, -3};
+
+		auto const P = perspectiveMat<double>::frustum(-1, 2, -.5, 1, 1, 50);
+		TEST_EQ_EPS(near(P.toMatrix(), frustum(-1., 2., -.5, 1., 1., 50.)), 0, eps);
+		TEST_EQ_EPS(near(perspectiveMat<double>::perspective(1, 1.5, 1, 100).toMatrix(), perspective(1., 1.5, 1., 100.)), 0, eps);
+		TEST_EQ_EPS(near(P * modelView, P.toMatrix() * modelView), 0, eps);
+		TEST_EQ_EPS((P * double4(1, 2, 3, 4)).distance(P.toMatrix() * double4(1, 2, 3, 4)), 0, eps);
+		TEST_EQ_EPS(near(P.inverse() * P.toMatrix(), I), 0, eps);
+		auto const ndc = P.project(p);
+		auto const c = P.toMatrix() * double4(p.x, p.y, p.z, 1);
+		TEST_EQ_EPS(ndc.distance(double3(c.x, c.y, c.z) / c.w), 0, eps);
+		TEST_EQ_EPS(P.unproject(ndc).distance(p), 0, eps);
+
+		auto const O = orthoMat<double>::ortho(-1, 2, -.5, 1, -3, 50);
+		TEST_EQ_EPS(near(O.toMatrix(), ortho(-1., 2., -.5, 1., -3., 50.)), 0, eps);
+		TEST_EQ_EPS(near(orthoMat<double>::ortho2D(0, 4, 0, 3).toMatrix(), ortho2D(0., 4., 0., 3.)), 0, eps);
+		TEST_EQ_EPS(near(O * modelView, O.toMatrix() * modelView), 0, eps);
+		auto const O2 = orthoMat<double>::ortho(0, 1, 0, 1, 0, 1);
+		TEST_EQ_EPS(near((O * O2).toMatrix(), O.toMatrix() * O2.toMatrix()), 0, eps);
+		TEST_EQ_EPS(near(O.inverse().toMatrix() * O.toMatrix(), I), 0, eps);
+		TEST_EQ_EPS(O.unproject(O.project(p)).distance(p), 0, eps);
+
+		// fused mvp through the compact projection
+		std::vector<double3> src = {p, double3(1, 1, -2), double3(-2, 0, -5)}, a(3), b(3);
+		transformPoints(P, modelView, I, src, a);
+		transformPoints(P.toMatrix(), modelView, I, src, b);
+		for (int i = 0; i < 3; ++i) {
+			TEST_EQ_EPS(a[i].distance(b[i]), 0, 1e-9);
+		}
+	}
 }
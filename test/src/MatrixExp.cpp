@@ -0,0 +1,135 @@
+#include "Test/Test.h"
+#include "Tensor/MatrixExp.h"
+
+void test_MatrixExp() {
+	using namespace Tensor;
+	double const eps = 1e-12;
+	auto const maxDiff = [](auto const & a, auto const & b) {
+		double d = 0;
+		constexpr int n = std::decay_t<decltype(a)>::template dim<0>;
+		for (int i = 0; i < n; ++i) {
+			for (int j = 0; j < n; ++j) {
+				d = std::max<double>(d, std::abs(a(i,j) - b(i,j)));
+			}
+		}
+		return d;
+	};
+	auto const hat = [](double3 const & v) {
+		asym<double,3> w;
+		w(2,1) = v.x;
+		w(0,2) = v.y;
+		w(1,0) = v.z;
+		return w;
+	};
+	auto const dense = [](auto const & a) {
+		constexpr int n = std::decay_t<decltype(a)>::template dim<0>;
+		return mat<double,n,n>([&](int i, int j) -> double { return a(i,j); });
+	};
+
+	// Rodrigues matches the quat rotation, the Pade exp, and expQuat
+	for (auto const & v : {
+		double3(.3, -.2, .5),
+		double3(1, 2, -.5),
+		double3(0, 0, 3),
+		double3(1e-5, 2e-5, 0),
+		double3(0, 0, 0),
+	}) {
+		auto const w = hat(v);
+		auto const r = exp(w);
+		double3 const p = {1, -2, .5};
+		auto const q = expQuat(w);
+		TEST_EQ_EPS(maxDiff(r, q.toMatrix()), 0, eps);
+		if (v.lenSq() > 0) {
+			auto const aa = quatd(v.x, v.y, v.z, v.length()).fromAngleAxis();
+			TEST_EQ_EPS((r * p).distance(aa.rotate(p)), 0, eps);
+		}
+		TEST_EQ_EPS(maxDiff(r, exp(dense(w))), 0, 1e-11);
+		// and it's the generator: w^ p = v x p
+		TEST_EQ_EPS((dense(w) * p).distance(v.cross(p)), 0, eps);
+	}
+
+	// log inverts it, near 0 and near pi too
+	for (auto const & v : {
+		double3(.3, -.2, .5),
+		double3(1e-9, 0, 2e-9),
+		double3(0, 3.1, 0),
+		double3(1, 1, 1).normalize() * (M_PI - 1e-7),
+	}) {
+		auto const w = logRotation(exp(hat(v)));
+		TEST_EQ_EPS(MatrixExpDetail::asymToVec(w).distance(v), 0, 1e-9);
+	}
+	{
+		// at pi, either sign of the axis is right
+		auto const r = exp(hat(double3(0, M_PI, 0)));
+		TEST_EQ_EPS(maxDiff(exp(logRotation(r)), r), 0, eps);
+	}
+
+	// general matrices
+	{
+		// diagonal
+		auto const d = exp(double3x3{{1, 0, 0}, {0, -2, 0}, {0, 0, .5}});
+		TEST_EQ_EPS(d(0,0), std::exp(1.), eps);
+		TEST_EQ_EPS(d(1,1), std::exp(-2.), eps);
+		TEST_EQ_EPS(d(2,2), std::exp(.5), eps);
+		TEST_EQ_EPS(d(0,1), 0, eps);
+		// nilpotent
+		auto const n = exp(double2x2{{0, 3}, {0, 0}});
+		TEST_EQ_EPS(maxDiff(n, double2x2{{1, 3}, {0, 1}}), 0, eps);
+		// big enough to need scaling and squaring
+		auto const big = exp(double2x2{{0, -20}, {20, 0}});
+		TEST_EQ_EPS(maxDiff(big, double2x2{{std::cos(20.), -std::sin(20.)}, {std::sin(20.), std::cos(20.)}}), 0, 1e-11);
+		// exp(a) exp(-a) = I
+		using M5 = mat<double,5,5>;
+		auto const a = M5([](int i, int j) -> double { return std::sin(1. + i * 5 + j * 3) * .8; });
+		auto const I = M5([](int i, int j) -> double { return i == j; });
+		TEST_EQ_EPS(maxDiff(exp(a) * exp(-a), I), 0, 1e-10);
+		// exp(2a) = exp(a)^2, across the degree choices
+		for (double scale : {.001, .1, .5, 1., 3., 10.}) {
+			auto const ea = exp(a * scale);
+			TEST_EQ_EPS(maxDiff(exp(a * (2 * scale)), ea * ea) / std::max(1., maxDiff(ea * ea, M5())), 0, 1e-10);
+		}
+		// float
+		auto const f = exp(float2x2{{0, -2}, {2, 0}});
+		TEST_EQ_EPS(f(1,0), std::sin(2.f), 1e-6f);
+	}
+
+	// sym stays sym and matches the dense one
+	{
+		sym<double,4> s;
+		for (int i = 0; i < 4; ++i) {
+			for (int j = i; j < 4; ++j) {
+				s(i,j) = std::cos(1. + i + 2 * j);
+			}
+		}
+		auto const es = exp(s);
+		static_assert(std::is_same_v<std::decay_t<decltype(es)>, sym<double,4>>);
+		TEST_EQ_EPS(maxDiff(es, exp(dense(s))), 0, 1e-11);
+		auto const big = exp(s * 8.);
+		TEST_EQ_EPS(maxDiff(big, exp(dense(s) * 8.)) / maxDiff(big, mat<double,4,4>()), 0, 1e-12);
+	}
+
+	// asym4: a double rotation in the 01 and 23 planes
+	{
+		double const a1 = .7, a2 = -2.5;
+		asym<double,4> w;
+		w(1,0) = a1;
+		w(3,2) = a2;
+		auto const r = exp(w);
+		auto const expected = mat<double,4,4>{
+			{std::cos(a1), -std::sin(a1), 0, 0},
+			{std::sin(a1), std::cos(a1), 0, 0},
+			{0, 0, std::cos(a2), -std::sin(a2)},
+			{0, 0, std::sin(a2), std::cos(a2)},
+		};
+		TEST_EQ_EPS(maxDiff(r, expected), 0, 1e-12);
+		// orthogonal in general
+		asym<double,4> g;
+		for (int i = 0; i < 4; ++i) {
+			for (int j = i + 1; j < 4; ++j) {
+				g(i,j) = 1.5 * std::sin(1. + i + 3 * j);
+			}
+		}
+		auto const o = exp(g);
+		TEST_EQ_EPS(maxDiff(o.transpose() * o, mat<double,4,4>([](int i, int j) -> double { return i == j; })), 0, 1e-12);
+	}
+}
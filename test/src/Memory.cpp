@@ -0,0 +1,90 @@
+#include "Test/Test.h"
+#include "Tensor/Grid.h"
+#include "Tensor/Memory.h"
+
+void test_Memory() {
+	using namespace Tensor;
+	auto isAligned = [](void const * p, size_t a) -> bool { return (uintptr_t)p % a == 0; };
+
+	// static alignment
+	{
+		auto g = Grid<float, 2, AlignedAllocator<float, 64>>(int2(3, 5), [](int2 i) -> float { return i.x + i.y; });
+		TEST_BOOL(isAligned(g.v, 64));
+		auto h = g.map([](float x) { return 2 * x; });
+		static_assert(std::is_same_v<decltype(h), Grid<float, 2, AlignedAllocator<float, 64>>>);
+		TEST_BOOL(isAligned(h.v, 64));
+		TEST_EQ(h(2, 4), 12);
+	}
+
+	// pmr aligned
+	{
+		AlignedResource aligned(256);
+		auto g = Grid<float3, 3>(int3(4, 4, 4), std::pmr::polymorphic_allocator<float3>(&aligned));
+		TEST_BOOL(isAligned(g.v, 256));
+		TEST_EQ(g(1, 2, 3), float3());
+		// copies from select_on_container_copy_construction go back to the default resource, like std::pmr containers
+		auto h = g;
+		TEST_BOOL(h.alloc.resource() == std::pmr::get_default_resource());
+	}
+
+	// recycling: same size gets the same buffer back
+	{
+		RecyclingResource pool;
+		auto alloc = std::pmr::polymorphic_allocator<double>(&pool);
+		double * first = {};
+		{
+			auto g = Grid<double, 3>(int3(8, 8, 8), alloc);
+			first = g.v;
+		}
+		TEST_EQ(pool.getCachedBytes(), (size_t)(8 * 8 * 8 * sizeof(double)));
+		auto g = Grid<double, 3>(int3(8, 8, 8), alloc);
+		TEST_EQ(g.v, first);
+		TEST_EQ(pool.getCachedBytes(), (size_t)0);
+
+		// reallocating via operator= every "timestep" just trades buffers back and forth
+		auto src1 = Grid<double, 3>(int3(4, 4, 4), [](int3 i) -> double { return i.x; }, alloc);
+		auto src2 = Grid<double, 3>(int3(8, 8, 8), [](int3 i) -> double { return i.y; }, alloc);
+		for (int step = 0; step < 4; ++step) {
+			g = src1;
+			TEST_EQ(g(3, 2, 1), 3);
+			g = src2;
+			TEST_EQ(g(3, 2, 1), 2);
+		}
+		TEST_BOOL(g.alloc == alloc);
+	}
+
+	// moving between different resources has to copy
+	{
+		RecyclingResource pool1, pool2;
+		auto g1 = Grid<int, 1>(intN<1>(10), [](int k) -> int { return k; }, std::pmr::polymorphic_allocator<int>(&pool1));
+		auto g2 = Grid<int, 1>(std::pmr::polymorphic_allocator<int>(&pool2));
+		int * p1 = g1.v;
+		g2 = std::move(g1);
+		TEST_NE(g2.v, p1);
+		TEST_EQ(g2(7), 7);
+		TEST_BOOL(g2.alloc.resource() == &pool2);
+	}
+
+	// first touch
+	{
+		ThreadPool pool(4);
+		auto g = Grid<float, 3>(int3(64, 64, 64), FirstTouch{&pool});
+		for (auto x : g) TEST_EQ(x, 0);
+		auto h = Grid<int, 3>(int3(64, 64, 64), [](int3 i) -> int { return i.dot(int3(1, 100, 10000)); }, FirstTouch{&pool});
+		for (auto i : h.range()) TEST_EQ(h(i), i.dot(int3(1, 100, 10000)));
+		auto hl = Grid<int, 3>(int3(64, 64, 64), [](int k) -> int { return k; }, FirstTouch{&pool});
+		for (int k = 0; k < hl.size.product(); ++k) TEST_EQ(hl.v[k], k);
+	}
+
+	// resize keeps the overlap, zeroes the rest, and doesn't free storage it doesn't own
+	{
+		int buf[6] = {1, 2, 3, 4, 5, 6};
+		auto g = Grid<int, 2>(int2(3, 2), buf);
+		g.resize(int2(2, 3));
+		TEST_BOOL(g.own);
+		TEST_EQ(g(0, 0), 1);
+		TEST_EQ(g(1, 1), 5);
+		TEST_EQ(g(1, 2), 0);
+		TEST_EQ(buf[5], 6);
+	}
+}
@@ -0,0 +1,156 @@
+#include "Test/Test.h"
+#include "Tensor/Multivector.h"
+
+namespace Test {
+	using namespace Tensor;
+	using MV3 = multivector<double, 3>;
+	static_assert(MV3::count == 8);
+	static_assert(std::is_same_v<std::decay_t<decltype(std::declval<MV3>().grade<0>())>, double>);
+	static_assert(std::is_same_v<std::decay_t<decltype(std::declval<MV3>().grade<1>())>, double3>);
+	static_assert(std::is_same_v<std::decay_t<decltype(std::declval<MV3>().grade<2>())>, asym<double, 3>>);
+	static_assert(std::is_same_v<std::decay_t<decltype(std::declval<MV3>().grade<3>())>, asymR<double, 3, 3>>);
+	static_assert(rotor<double, 4>::count == 8);
+	static_assert(rotor<double, 5>::count == 16);
+	// vector * vector has only a scalar and a bivector, and 3*3 terms
+	using V3 = multivector<double, 3, MetricSignature<3>, 2>;
+	static_assert(decltype(std::declval<V3>() * std::declval<V3>())::grades == 0b101);
+	static_assert(MultivectorDetail::ProductTable<3, MetricSignature<3>, MultivectorDetail::Product::Geometric, 2, 2, 0b101>::count == 9);
+	// a null basis vector drops its terms
+	static_assert(MultivectorDetail::ProductTable<3, MetricSignature<2,0,1>, MultivectorDetail::Product::Geometric, 2, 2, 0b101>::count == 8);
+}
+
+void test_Multivector() {
+	using namespace Tensor;
+	double const eps = 1e-12;
+
+	{
+		using MV = multivector<double, 3>;
+		using V = multivector<double, 3, MetricSignature<3>, 2>;
+		double3 const av = {1, 2, 3}, bv = {-2, .5, 4}, cv = {3, -1, .25};
+		V const a = av, b = bv, c = cv;
+
+		// a b = a.b + a^b, and a^b matches the exterior algebra wedge
+		auto const ab = a * b;
+		TEST_EQ_EPS(ab.scalar(), av.dot(bv), eps);
+		auto const w = wedge(a, b);
+		auto const tw = Tensor::wedge(av, bv);
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				TEST_EQ_EPS(w.grade<2>()(i,j), tw(i,j), eps);
+				TEST_EQ_EPS(ab.grade<2>()(i,j), tw(i,j), eps);
+			}
+		}
+		// a^b^c is the determinant
+		auto const abc = wedge(wedge(a, b), c);
+		TEST_EQ_EPS(abc.grade<3>()(0,1,2), double3x3(av, bv, cv).determinant(), eps);
+		TEST_EQ_EPS(abc.grade<3>()(2,1,0), -double3x3(av, bv, cv).determinant(), eps);
+		// associative
+		MV const x = MV(a) + MV(1.5) + MV(wedge(b, c));
+		MV const y = MV(b) + MV(wedge(a, c)) + MV(abc);
+		MV const z = MV(c) + MV(-2.);
+		auto const lhs = (x * y) * z, rhs = x * (y * z);
+		for (int blade = 0; blade < 8; ++blade) {
+			TEST_EQ_EPS(lhs.component(blade), rhs.component(blade), eps);
+		}
+		// a _| (b^c) = (a.b) c - (a.c) b
+		auto const lc = inner(a, wedge(b, c));
+		auto const expected = cv * av.dot(bv) - bv * av.dot(cv);
+		for (int i = 0; i < 3; ++i) {
+			TEST_EQ_EPS(lc.grade<1>()[i], expected[i], eps);
+		}
+		static_assert(decltype(inner(wedge(a, b), c))::grades == 0);
+		// reverse flips grades 2 and 3
+		auto const xr = x.reverse();
+		TEST_EQ(xr.scalar(), x.scalar());
+		TEST_EQ(xr.grade<1>(), x.grade<1>());
+		TEST_EQ(xr.grade<2>()(0,1), -x.grade<2>()(0,1));
+		TEST_EQ_EPS(x.normSq(), 1.5 * 1.5 + av.lenSq() + wedge(b, c).normSq(), eps);
+		TEST_EQ_EPS(V(av).normSq(), av.lenSq(), eps);
+		std::ostringstream ss;
+		ss << MV::basis(0) * MV::basis(1) * 2. + MV(1.);
+		TEST_EQ(ss.str(), "1 + 2*e_01");
+	}
+
+	// 3D rotor vs quat: R = cos(t/2) - sin(t/2) e_01 rotates e_0 toward e_1, like a rotation about z
+	{
+		using R3 = rotor<double, 3>;
+		using V = multivector<double, 3, MetricSignature<3>, 2>;
+		double const angle = .7;
+		R3 r = std::cos(angle / 2);
+		r.grade<2>()(0,1) = -std::sin(angle / 2);
+		auto const q = quatd(0, 0, 1, angle).fromAngleAxis();
+		double3 const v = {1, 2, 3};
+		auto const rv = sandwich(r, V(v));
+		TEST_EQ_EPS(rv.grade<1>().distance(q.rotate(v)), 0, eps);
+		TEST_EQ_EPS((r * r.reverse()).scalar(), 1, eps);
+	}
+
+	// 4D and 5D double rotations, checked against their matrices
+	{
+		double const a1 = .4, a2 = -1.1;
+		auto const planeRotor = [](auto r, int i, int j, double angle) {
+			using R = decltype(r);
+			R p = std::cos(angle / 2);
+			p.template grade<2>()(i,j) = -std::sin(angle / 2);
+			return R(r * p);
+		};
+		{
+			using R4 = rotor<double, 4>;
+			using V = multivector<double, 4, MetricSignature<4>, 2>;
+			R4 r = planeRotor(planeRotor(R4(1.), 0, 1, a1), 2, 3, a2);
+			double4 const v = {1, -2, .5, 3};
+			auto const rv = sandwich(r, V(v)).grade<1>();
+			double4 const m = {
+				std::cos(a1) * v[0] - std::sin(a1) * v[1],
+				std::sin(a1) * v[0] + std::cos(a1) * v[1],
+				std::cos(a2) * v[2] - std::sin(a2) * v[3],
+				std::sin(a2) * v[2] + std::cos(a2) * v[3],
+			};
+			TEST_EQ_EPS(rv.distance(m), 0, eps);
+			// rotors compose
+			R4 const s = planeRotor(R4(1.), 1, 2, .3);
+			auto const both = sandwich(R4(s * r), V(v)).grade<1>();
+			auto const oneByOne = sandwich(s, sandwich(r, V(v))).grade<1>();
+			TEST_EQ_EPS(both.distance(oneByOne), 0, eps);
+			// bivectors rotate too
+			auto const B = wedge(V(v), V(double4(0, 1, 0, 1)));
+			auto const rB = sandwich(r, B);
+			auto const rBexpected = wedge(sandwich(r, V(v)), sandwich(r, V(double4(0, 1, 0, 1))));
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					TEST_EQ_EPS(rB.grade<2>()(i,j), rBexpected.grade<2>()(i,j), eps);
+				}
+			}
+		}
+		{
+			using R5 = rotor<double, 5>;
+			using V = multivector<double, 5, MetricSignature<5>, 2>;
+			R5 r = planeRotor(planeRotor(R5(1.), 0, 3, a1), 1, 4, a2);
+			vec<double, 5> const v = {1, -2, .5, 3, 2};
+			auto const rv = sandwich(r, V(v)).grade<1>();
+			TEST_EQ_EPS(rv[2], v[2], eps);
+			TEST_EQ_EPS(rv[0], std::cos(a1) * v[0] - std::sin(a1) * v[3], eps);
+			TEST_EQ_EPS(rv[4], std::sin(a2) * v[1] + std::cos(a2) * v[4], eps);
+			TEST_EQ_EPS(rv.length(), v.length(), eps);
+		}
+	}
+
+	// signatures
+	{
+		using M = multivector<double, 2, MetricSignature<1, 1>>;
+		auto const e0 = M::basis(0), e1 = M::basis(1);
+		TEST_EQ((e0 * e0).scalar(), 1);
+		TEST_EQ((e1 * e1).scalar(), -1);
+		// e01 squares to +1 here, -1 in euclidean 2D
+		auto const e01 = e0 * e1;
+		TEST_EQ((e01 * e01).scalar(), 1);
+		using E = multivector<double, 2>;
+		TEST_EQ((E::basis(0) * E::basis(1) * E::basis(0) * E::basis(1)).scalar(), -1);
+		// degenerate, PGA-style
+		using P = multivector<double, 3, MetricSignature<2, 0, 1>>;
+		auto const n = P::basis(2);
+		TEST_EQ(P(n * n), P());
+		auto const e02 = P::basis(0) * n;
+		TEST_EQ(e02.grade<2>()(0,2), 1);
+	}
+}
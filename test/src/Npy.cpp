@@ -0,0 +1,144 @@
+#include "Test/Test.h"
+#include "Tensor/Npy.h"
+#include <filesystem>
+#include <sstream>
+
+void test_Npy() {
+	using namespace Tensor;
+
+	TEST_EQ(npyDescr<uint8_t>(), "|u1");
+	TEST_EQ(npyDescr<float>().substr(1), "f4");
+	TEST_EQ(npyDescr<int64_t>().substr(1), "i8");
+	TEST_EQ(npyDescr<bool>(), "|b1");
+
+	// shapes: grid axes reversed, then the cell
+	TEST_BOOL((npyShape<float3s3>({5, 4, 3}) == std::vector<int64_t>{3, 4, 5, 3, 3}));
+	TEST_BOOL((npyShape<float3s3>({5, 4, 3}, NpyLayout::Stored) == std::vector<int64_t>{3, 4, 5, 6}));
+	TEST_BOOL((npyShape<double>({7}) == std::vector<int64_t>{7}));
+	TEST_BOOL((npyShape<vec<sym<float, 2>, 4>>({7}) == std::vector<int64_t>{7, 4, 2, 2}));
+
+	// expanding and collapsing cells
+	{
+		float a[9];
+		NpyCell<float3s3>::expand(float3s3(1, 2, 3, 4, 5, 6), a);
+		float const expected[9] = {1, 2, 4, 2, 3, 5, 4, 5, 6};
+		for (int k = 0; k < 9; ++k) TEST_EQ(a[k], expected[k]);
+		float3s3 b;
+		NpyCell<float3s3>::collapse(a, b);
+		TEST_EQ(b, float3s3(1, 2, 3, 4, 5, 6));
+
+		auto x = float3a3(1, 2, 3);
+		NpyCell<float3a3>::expand(x, a);
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				TEST_EQ(a[3 * i + j], (float)x(i, j));
+			}
+		}
+		float3a3 y;
+		NpyCell<float3a3>::collapse(a, y);
+		TEST_EQ(y, x);
+
+		TEST_BOOL(NpyCell<float3x3>::tables().expandedIsStored);
+		TEST_BOOL(NpyCell<float3>::tables().expandedIsStored);
+		TEST_BOOL(!NpyCell<float3s3>::tables().expandedIsStored);
+	}
+
+	auto size = int3(5, 4, 3);
+	auto g = Grid<float3s3, 3>(size, [](int3 i) -> float3s3 {
+		return float3s3(i.x, i.y, i.z, i.x * i.y, i.y * i.z, .5f * i.x);
+	});
+
+	// round trips, in both layouts
+	for (auto layout : {NpyLayout::Expanded, NpyLayout::Stored}) {
+		std::stringstream s;
+		writeNpy(s, g, layout);
+		auto h = readNpyHeader(s);
+		TEST_EQ(h.dataOffset % 64, (size_t)0);
+		TEST_BOOL(h.shape == npyShape<float3s3>({5, 4, 3}, layout));
+		TEST_EQ(s.str().size(), h.dataOffset + (size_t)size.product() * (layout == NpyLayout::Stored ? 6 : 9) * sizeof(float));
+
+		s.seekg(0);
+		auto back = readNpy<float3s3, 3>(s);
+		TEST_EQ(back.size, size);
+		bool same = true;
+		for (auto i : g.range()) same = same && back(i) == g(i);
+		TEST_BOOL(same);
+	}
+
+	// views and contiguous arrays
+	{
+		std::stringstream s;
+		writeNpy(s, g.view().transpose<0, 2>());
+		auto t = readNpy<float3s3, 3>(s);
+		TEST_EQ(t.size, int3(3, 4, 5));
+		TEST_EQ(t(2, 1, 4), g(4, 1, 2));
+
+		std::vector<float3> a = {float3(1, 2, 3), float3(4, 5, 6)};
+		s.str("");
+		s.clear();
+		writeNpy(s, a.data(), a.size());
+		auto h = readNpyHeader(s);
+		TEST_BOOL((h.shape == std::vector<int64_t>{2, 3}));
+		s.seekg(0);
+		auto b = readNpy<float3, 1>(s);
+		TEST_EQ(b(1), float3(4, 5, 6));
+	}
+
+	// mismatches
+	{
+		std::stringstream s;
+		writeNpy(s, g);
+		std::string const good = s.str();
+		auto throws = [](auto f) -> bool {
+			try {
+				f();
+			} catch (std::exception const &) {
+				return true;
+			}
+			return false;
+		};
+		TEST_BOOL(throws([&]() { std::istringstream i(good); readNpy<double3s3, 3>(i); }));
+		TEST_BOOL(throws([&]() { std::istringstream i(good); readNpy<float3x3, 2>(i); }));
+		TEST_BOOL(throws([&]() { std::istringstream i(good); readNpy<float3, 3>(i); }));
+		TEST_BOOL(!throws([&]() { std::istringstream i(good); readNpy<float3x3, 3>(i); }));	// same cell dims, so it reads as a full matrix
+		TEST_BOOL(throws([&]() { std::istringstream i("garbage"); readNpy<float, 1>(i); }));
+	}
+
+	// zero copy, and npz
+	{
+		auto dir = std::filesystem::temp_directory_path();
+		auto path = (dir / "Tensor_test_Npy.npy").string();
+		writeNpy(path, g, NpyLayout::Stored);
+		{
+			auto m = mapNpy<float3s3, 3>(path);
+			TEST_EQ(m.cgrid().size, size);
+			TEST_EQ(m.cgrid()(4, 3, 2), g(4, 3, 2));
+		}
+		writeNpy(path, g);
+		bool threw = false;
+		try {
+			mapNpy<float3s3, 3>(path);	// expanded sym3 isn't our layout
+		} catch (std::exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+		TEST_EQ((readNpy<float3s3, 3>(path)(1, 2, 1)), g(1, 2, 1));
+
+		auto npzPath = (dir / "Tensor_test_Npy.npz").string();
+		auto m = Grid<float3x3, 2>(int2(2, 3), [](int2 i) -> float3x3 { return float3x3(i.x + 10 * i.y); });
+		{
+			NpzWriter npz(npzPath);
+			npz.add("g", g);
+			npz.add("m", m, NpyLayout::Stored);
+		}
+		NpzReader npz(npzPath);
+		TEST_BOOL((npz.names() == std::vector<std::string>{"g", "m"}));
+		auto g2 = npz.read<float3s3, 3>("g");
+		TEST_EQ(g2(4, 3, 2), g(4, 3, 2));
+		auto m2 = npz.read<float3x3, 2>("m");
+		TEST_EQ(m2(1, 2), m(1, 2));
+
+		std::filesystem::remove(path);
+		std::filesystem::remove(npzPath);
+	}
+}
@@ -172,5 +172,133 @@ void test_Quat() {
 		}
 	}
 
+	// toMatrix, rotateUnit and the batched rotates all agree with rotate() for unit quats
+	{
+		using namespace Tensor;
+		auto q = normalize(quatf(.3f, -.5f, .7f, .4f));
+		auto m = q.toMatrix();
+		TEST_QUAT_EQ(m, float3x3(q.xAxis(), q.yAxis(), q.zAxis()).transpose());
+		float3 const v = {1, 2, 3};
+		TEST_QUAT_EQ(q.rotateUnit(v), q.rotate(v));
+		TEST_QUAT_EQ(m * v, q.rotate(v));
+
+		int const n = 37;	// not a multiple of the block size
+		std::vector<float3> src(n), dst(n), viaMatrix(n);
+		std::vector<quatf> qs(n);
+		for (int i = 0; i < n; ++i) {
+			src[i] = float3(i, 1 - i, .5f * i);
+			qs[i] = normalize(quatf(1, i, -2, .1f * i));
+		}
+		rotate(q, src, dst);
+		rotate(m, src, viaMatrix);
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(dst[i].distance(q.rotate(src[i])), 0, 1e-4);
+			TEST_EQ_EPS(viaMatrix[i].distance(dst[i]), 0, 1e-4);
+		}
+		rotate(std::span<quatf const>(qs), src, dst);
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(dst[i].distance(qs[i].rotate(src[i])), 0, 1e-4);
+		}
+		// in place
+		rotate(q, src, src);
+		TEST_EQ_EPS(src[n-1].distance(q.rotate(float3(n-1, 2-n, .5f * (n-1)))), 0, 1e-4);
+	}
+
+	// interpolation
+	{
+		using namespace Tensor;
+		auto const rz = [](double angle) { return quatd(0, 0, 1, angle).fromAngleAxis(); };
+		auto const id = quatd(0, 0, 0, 1);
+		TEST_QUAT_EQ(slerp(id, rz(M_PI / 2), .5), rz(M_PI / 4));
+		TEST_QUAT_EQ(slerp(id, rz(M_PI / 2), .25), rz(M_PI / 8));
+		TEST_QUAT_EQ(nlerp(id, rz(M_PI / 2), .5), rz(M_PI / 4));
+		// shortest path: -rz is the same rotation
+		TEST_QUAT_EQ(slerp(id, -rz(M_PI / 2), .5), rz(M_PI / 4));
+		TEST_QUAT_EQ(slerp(id, id, .3), id);
+
+		// log and exp
+		auto const q = normalize(quatd(.3, -.5, .7, .4));
+		TEST_QUAT_EQ(q.log().exp(), q);
+		TEST_QUAT_EQ(rz(1).log(), quatd(0, 0, .5, 0));
+		TEST_QUAT_EQ((q * 3.).log().exp(), q * 3.);
+
+		// keys along one axis at even steps: the control points are the keys, so squad is slerp
+		TEST_QUAT_EQ(squadControl(rz(0), rz(.5), rz(1)), rz(.5));
+		TEST_QUAT_EQ(squad(rz(.5), rz(1), rz(.5), rz(1), .3), rz(.65));
+		auto const a = normalize(quatd(1, 2, 3, 4));
+		auto const b = normalize(quatd(-1, 0, 2, 3));
+		auto const sa = squadControl(q, a, b), sb = squadControl(a, b, b);
+		TEST_QUAT_EQ(squad(a, b, sa, sb, 0.), a);
+		TEST_QUAT_EQ(squad(a, b, sa, sb, 1.), b);
+
+		// average: symmetric about q, with a sign flip thrown in that shouldn't matter
+		auto const dx = quatd(1, 0, 0, .3).fromAngleAxis();
+		auto const dy = quatd(0, 1, 0, .2).fromAngleAxis();
+		std::vector<quatd> qs = {q * dx, q * dx.conjugate(), -(q * dy), q * dy.conjugate()};
+		TEST_QUAT_EQ(average(std::span<quatd const>(qs)), q * dx * dx.conjugate());
+		std::vector<double> w = {1, 0, 0, 0};
+		TEST_QUAT_EQ(average(std::span<quatd const>(qs), std::span<double const>(w)), qs[0]);
+		// two inputs, equal weights, is the midpoint
+		std::vector<quatd> two = {a, b};
+		TEST_QUAT_EQ(average(std::span<quatd const>(two)), slerp(a, b, .5));
+
+		// batched against scalar, over angles up to 180 degrees and both hemispheres
+		int const n = 1000;
+		std::vector<quatd> qa(n), qb(n), out(n), out2(n), s0(n), s1(n);
+		std::vector<double> t(n);
+		for (int i = 0; i < n; ++i) {
+			qa[i] = normalize(quatd(std::sin(i * 1.1), std::cos(i * 2.3), std::sin(i * .7 + 1), std::cos(i * .3)));
+			auto const rot = quatd(std::cos(i), std::sin(i), 1, M_PI * 2 * i / (n - 1)).fromAngleAxis();
+			qb[i] = qa[i] * rot;
+			t[i] = (double)(i % 37) / 36;
+			s0[i] = normalize(qa[i] + quatd(.1, 0, 0, 0));
+			s1[i] = normalize(qb[i] + quatd(0, .1, 0, 0));
+		}
+		std::span<quatd const> ca(qa), cb(qb), c0(s0), c1(s1);
+		std::span<double const> ct(t);
+
+		slerp(ca, cb, ct, std::span<quatd>(out));
+		double maxErr = 0;
+		for (int i = 0; i < n; ++i) {
+			maxErr = std::max(maxErr, out[i].distance(slerp(qa[i], qb[i], t[i])));
+		}
+		ECHO(maxErr);
+		TEST_BOOL(maxErr < 5e-5);
+
+		nlerp(ca, cb, ct, std::span<quatd>(out));
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(out[i].distance(nlerp(qa[i], qb[i], t[i])), 0, 1e-12);
+		}
+
+		squad(ca, cb, c0, c1, ct, std::span<quatd>(out));
+		maxErr = 0;
+		for (int i = 0; i < n; ++i) {
+			maxErr = std::max(maxErr, out[i].distance(squad(qa[i], qb[i], s0[i], s1[i], t[i])));
+		}
+		ECHO(maxErr);
+		TEST_BOOL(maxErr < 1.5e-4);
+
+		// one t for all, in place
+		std::vector<double> half = {.5};
+		out2 = qa;
+		slerp(std::span<quatd const>(out2), cb, std::span<double const>(half), std::span<quatd>(out2));
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(out2[i].distance(slerp(qa[i], qb[i], .5)), 0, 5e-5);
+		}
+
+		// floats
+		std::vector<quatf> fa(n), fb(n), fout(n);
+		std::vector<float> ft(n);
+		for (int i = 0; i < n; ++i) {
+			fa[i] = quatf(qa[i]);
+			fb[i] = quatf(qb[i]);
+			ft[i] = (float)t[i];
+		}
+		slerp(std::span<quatf const>(fa), std::span<quatf const>(fb), std::span<float const>(ft), std::span<quatf>(fout));
+		for (int i = 0; i < n; ++i) {
+			TEST_EQ_EPS(quatd(fout[i]).distance(slerp(qa[i], qb[i], t[i])), 0, 5e-5);
+		}
+	}
+
 	test_Quaternions();
 }
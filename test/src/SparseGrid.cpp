@@ -0,0 +1,114 @@
+#include "Test/Test.h"
+#include "Tensor/SparseGrid.h"
+#include "Tensor/Derivative.h"
+
+void test_SparseGrid() {
+	using namespace Tensor;
+
+	// bricks only appear where something was written
+	{
+		auto g = SparseGrid<float, 3, 4>(-1.f);
+		auto const & cg = g;
+		TEST_EQ(cg(100, -200, 3), -1.f);
+		TEST_EQ(g.brickCount(), 0);
+		g(1, 2, 3) = 5;
+		g(-1, 0, 0) = 6;	// the brick below 0
+		g(3, 3, 3) = 7;	// same brick as (1, 2, 3)
+		TEST_EQ(g.brickCount(), 2);
+		TEST_EQ(cg(1, 2, 3), 5.f);
+		TEST_EQ(cg(-1, 0, 0), 6.f);
+		TEST_EQ(cg(0, 0, 0), -1.f);	// allocated, but never written
+		TEST_EQ(cg(4, 0, 0), -1.f);	// not allocated
+		TEST_EQ(g.brickCount(), 2);
+		TEST_BOOL(g.isActive(int3(0, 0, 0)));
+		TEST_BOOL(!g.isActive(int3(4, 0, 0)));
+		TEST_EQ(g.bounds().first, int3(-4, 0, 0));
+		TEST_EQ(g.bounds().second, int3(4, 4, 4));
+
+		int bricks = 0;
+		float sum = 0;
+		for (auto b : g.bricks()) {
+			++bricks;
+			for (auto i : b.view().range()) {
+				float const x = b.view()(i);
+				if (x != -1.f) sum += x;
+				TEST_EQ(x, cg(b.min + i));
+			}
+		}
+		TEST_EQ(bricks, 2);
+		TEST_EQ(sum, 18.f);
+
+		size_t active = 0;
+		g.forEachActive([&](int3 const &, float const &) { ++active; });
+		TEST_EQ(active, g.activeCellCount());
+		TEST_EQ(active, (size_t)2 * 64);
+	}
+
+	// references stay valid as bricks are added
+	{
+		auto s = SparseGrid<double, 2, 2>();
+		s(0, 0) = 1;
+		double & first = s(0, 0);
+		for (int i = 1; i < 100; ++i) {
+			s(2 * i, 0) = s(2 * (i - 1), 0) + 1;	// both sides can be a new brick
+		}
+		TEST_EQ(s.brickCount(), 100);
+		TEST_EQ(first, 1.);
+		first = 2;
+		auto const & cs = s;
+		TEST_EQ(cs(0, 0), 2.);
+		TEST_EQ(cs(198, 0), 100.);
+		s(-10, -10) = s(10, 10);	// neither brick exists yet
+		TEST_EQ(cs(-10, -10), 0.);
+
+		// writing a neighbor from inside forEachActive
+		auto t = SparseGrid<int, 1, 4>();
+		t(0) = 1;
+		t.forEachActive([&](intN<1> const & i, int & x) {
+			if (x == 1 && i[0] < 40) {
+				t(i[0] + 4) = 1;
+				x = 2;
+			}
+		});
+		auto const & ct = t;
+		TEST_EQ(t.brickCount(), 11);
+		TEST_EQ(ct(0), 2);
+		TEST_EQ(ct(40), 1);
+	}
+
+	// a ball in a big box: memory goes with the ball, and stencils work across bricks
+	{
+		int const n = 64;
+		auto dense = Grid<double, 3>(int3(n), [&](int3 i) -> double {
+			double3 const x = double3(i) - n / 2;
+			double const r2 = dot(x, x);
+			return r2 < 100 ? 100 - r2 : 0;
+		});
+		auto s = SparseGrid<double, 3>::fromDense(dense);
+		TEST_BOOL(s.activeCellCount() * 4 < (size_t)n * n * n);
+		auto back = s.copy(int3(), int3(n));
+		bool same = true;
+		for (auto i : dense.range()) same = same && back(i) == dense(i);
+		TEST_BOOL(same);
+
+		// 2nd order derivative, through the same code that reads GridCursors
+		auto grad = SparseGrid<double3, 3>();
+		sparseStencil(grad, s, [](auto const & c) -> double3 {
+			return partialDerivativeGrid<2>(c, double3(1, 1, 1));
+		}, 1);
+		double err = 0;
+		for (auto i : RangeObj<3>(int3(1), int3(n - 1))) {
+			auto const expected = partialDerivativeGrid<2>(i, double3(1, 1, 1), dense);
+			err = std::max(err, (double)normSq(static_cast<SparseGrid<double3, 3> const &>(grad)(i) - expected));
+		}
+		TEST_EQ(err, 0.);
+
+		// parallel sweeps only see active cells
+		ThreadPool pool(4);
+		std::atomic<size_t> visited = 0;
+		s.parallelForEachActive([&](int3 const &, double & x) { x *= 2; ++visited; }, pool);
+		TEST_EQ(visited.load(), s.activeCellCount());
+		auto const & cs = s;
+		TEST_EQ(cs(int3(n / 2)), 200.);
+	}
+}
@@ -0,0 +1,151 @@
+#include "Test/Test.h"
+#include "Tensor/Svd.h"
+
+namespace {
+	template<typename T, int M, int N>
+	T maxDiff(Tensor::mat<T,M,N> const & a, Tensor::mat<T,M,N> const & b) {
+		T d = 0;
+		for (int i = 0; i < M; ++i) {
+			for (int j = 0; j < N; ++j) {
+				d = std::max<T>(d, std::abs(a(i,j) - b(i,j)));
+			}
+		}
+		return d;
+	}
+
+	// A = U diag(sigma) V^T, sigma descending and >= 0, U and V with orthonormal columns
+	template<typename T, int M, int N>
+	void checkSvd(Tensor::mat<T,M,N> const & a, Tensor::Svd<T,M,N> const & d, T eps) {
+		using namespace Tensor;
+		constexpr int K = Svd<T,M,N>::K;
+		auto const us = mat<T,M,N>([&](int i, int j) -> T {
+			T sum = 0;
+			for (int k = 0; k < K; ++k) sum += d.U(i,k) * d.sigma[k] * d.V(j,k);
+			return sum;
+		});
+		T const scale = std::max<T>(d.sigma[0], 1);
+		TEST_EQ_EPS(maxDiff(us, a), 0, eps * scale);
+		for (int k = 0; k < K; ++k) {
+			TEST_BOOL(d.sigma[k] >= 0);
+			if (k > 0) TEST_BOOL(d.sigma[k - 1] >= d.sigma[k]);
+			for (int l = 0; l < K; ++l) {
+				T uu = 0, vv = 0;
+				for (int i = 0; i < M; ++i) uu += d.U(i,k) * d.U(i,l);
+				for (int i = 0; i < N; ++i) vv += d.V(i,k) * d.V(i,l);
+				TEST_EQ_EPS(uu, k == l ? 1 : 0, eps);
+				TEST_EQ_EPS(vv, k == l ? 1 : 0, eps);
+			}
+		}
+	}
+}
+
+void test_Svd() {
+	using namespace Tensor;
+	double const eps = 1e-12;
+
+	std::vector<double3x3> cases = {
+		{{1, 2, 3}, {-1, .5, 2}, {4, 0, -1}},
+		{{2, 0, 0}, {0, -3, 0}, {0, 0, 1}},				// diagonal, negative det
+		{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+		{{1, 2, 3}, {2, 4, 6}, {-1, 0, 1}},				// rank 2
+		{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
+		{{1e-4, 2e-4, 0}, {0, 3e-4, 1e-4}, {5e-5, 0, 2e-4}},
+		{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},				// a rotation, repeated sigma
+		{{0, 1, 0}, {1, 0, 0}, {0, 0, 1}},				// a reflection
+		{{1, .99, 0}, {.99, 1, 0}, {0, 0, 1e-3}},
+	};
+	for (int i = 0; i < 20; ++i) {
+		cases.push_back(double3x3([&](int r, int c) -> double { return std::sin(1. + 17 * i + 5 * r + 3 * c) * (1 + i % 4); }));
+	}
+
+	for (auto const & a : cases) {
+		// signed, with rotations
+		auto const d = svdRotations(a);
+		TEST_EQ_EPS(d.U.length(), 1, eps);
+		TEST_EQ_EPS(d.V.length(), 1, eps);
+		TEST_BOOL(d.sigma[0] >= d.sigma[1]);
+		TEST_BOOL(d.sigma[1] >= std::abs(d.sigma[2]) - eps);
+		double const det = a.determinant();
+		if (std::abs(det) > 1e-9) TEST_BOOL((d.sigma[2] < 0) == (det < 0));
+		auto const us = d.U.toMatrix() * double3x3{{d.sigma[0], 0, 0}, {0, d.sigma[1], 0}, {0, 0, d.sigma[2]}} * d.V.toMatrix().transpose();
+		double const scale = std::max(1., d.sigma[0]);
+		TEST_EQ_EPS(maxDiff(us, a), 0, 1e-12 * scale);
+
+		// unsigned
+		checkSvd(a, svd(a), 1e-12);
+
+		// polar
+		auto const p = polar(a);
+		TEST_EQ_EPS(p.R.length(), 1, eps);
+		TEST_EQ_EPS(maxDiff(p.R.toMatrix() * double3x3([&](int i, int j) -> double { return p.S(i,j); }), a), 0, 1e-12 * scale);
+	}
+	{
+		// a rotation times a stretch comes back apart
+		auto const r = normalize(quatd(.3, -.5, .2, .8));
+		double3s3 s;
+		s(0,0) = 2; s(0,1) = .3; s(0,2) = -.1;
+		s(1,1) = 1.5; s(1,2) = .2; s(2,2) = .7;
+		auto const p = polar(r.toMatrix() * double3x3([&](int i, int j) -> double { return s(i,j); }));
+		TEST_EQ_EPS(std::abs(p.R.dot(r)), 1, eps);
+		for (int i = 0; i < 3; ++i) {
+			for (int j = i; j < 3; ++j) {
+				TEST_EQ_EPS(p.S(i,j), s(i,j), eps);
+			}
+		}
+	}
+
+	// batched matches
+	{
+		std::vector<SvdRotations<double>> ds(cases.size());
+		std::vector<Polar<double>> ps(cases.size());
+		svdRotations(std::span<double3x3 const>(cases), std::span<SvdRotations<double>>(ds));
+		polar(std::span<double3x3 const>(cases), std::span<Polar<double>>(ps));
+		for (size_t i = 0; i < cases.size(); ++i) {
+			auto const d = svdRotations(cases[i]);
+			TEST_EQ_EPS(ds[i].U.distance(d.U), 0, 1e-12);
+			TEST_EQ_EPS(ds[i].V.distance(d.V), 0, 1e-12);
+			TEST_EQ_EPS(ds[i].sigma.distance(d.sigma), 0, 1e-12 * std::max(1., d.sigma[0]));
+			TEST_EQ_EPS(ps[i].R.distance(polar(cases[i]).R), 0, 1e-12);
+		}
+		bool threw = false;
+		try {
+			polar(std::span<double3x3 const>(cases), std::span<Polar<double>>(ps.data(), 2));
+		} catch (Common::Exception const &) {
+			threw = true;
+		}
+		TEST_BOOL(threw);
+	}
+
+	// float
+	{
+		float3x3 const a = {{1, 2, 3}, {-1, .5f, 2}, {4, 0, -1}};
+		checkSvd(a, svd(a), 1e-5f);
+	}
+
+	// other sizes
+	{
+		checkSvd(double2x2{{1, 2}, {3, 4}}, svd(double2x2{{1, 2}, {3, 4}}), eps);
+		auto const a44 = mat<double,4,4>([](int i, int j) -> double { return std::cos(1. + 3 * i + 7 * j); });
+		checkSvd(a44, svd(a44), eps);
+		auto const a42 = mat<double,4,2>([](int i, int j) -> double { return std::cos(2. + 3 * i + 7 * j); });
+		checkSvd(a42, svd(a42), eps);
+		auto const a24 = mat<double,2,4>([](int i, int j) -> double { return std::cos(3. + 3 * i + 7 * j); });
+		checkSvd(a24, svd(a24), eps);
+		// rank 1, so U gets completed
+		auto const r1 = mat<double,4,3>([](int i, int j) -> double { return (i + 1.) * (j - 1.5); });
+		auto const d = svd(r1);
+		checkSvd(r1, d, eps);
+		TEST_EQ_EPS(d.sigma[1], 0, eps);
+		// rank 3, the missing column (.5, .5, .5, .5) is no closer to one unit vector than another
+		auto const p = mat<double,4,4>([](int i, int j) -> double { return (i == j) - .25; });
+		auto const dp = svd(p);
+		checkSvd(p, dp, eps);
+		TEST_EQ_EPS(dp.sigma[3], 0, eps);
+		for (int i = 0; i < 4; ++i) TEST_EQ_EPS(std::abs(dp.U(i,3)), .5, eps);
+
+		std::vector<mat<double,4,2>> many(3, a42);
+		std::vector<Svd<double,4,2>> out(3);
+		svd(std::span<mat<double,4,2> const>(many), std::span<Svd<double,4,2>>(out));
+		TEST_EQ_EPS(out[2].sigma.distance(svd(a42).sigma), 0, eps);
+	}
+}
@@ -12,8 +12,26 @@ int main() {
 	test_TotallySymmetric();
 	test_TotallyAntisymmetric();
 	test_Index();
+	test_Grid();
+	test_GridParallel();
+	test_Memory();
+	test_MappedGrid();
+	test_GridStream();
+	test_GridIO();
+	test_Compression();
+	test_GridGhost();
+	test_GridDecomposition();
+	test_GridLayout();
+	test_PlanarGrid();
+	test_SparseGrid();
+	test_Npy();
 	test_Derivative();
 	test_Math();
 	test_Quat();
+	test_DualQuat();
+	test_Multivector();
+	test_MatrixExp();
+	test_Eigen();
+	test_Svd();
 	test_Valence();
 }